@@ -0,0 +1,142 @@
+//------------------------------------------------------------------------------
+//
+//   Copyright 2018-2019 Fetch.AI Limited
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//------------------------------------------------------------------------------
+
+#include "matrix_operations.hpp"
+#include "tensor.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <random>
+
+/*
+ * GFLOP/s of Dot, DotTranspose and TransposeDot against the Get / Set loops they used to be,
+ * on one thread and on the default pool
+ * [1 x 100].[100 x 25] is the CBOW graph's product, [64 x 100].[100 x 10000] a batch of
+ * similarity queries, the others are mini-batch and square sizes
+ */
+
+using ArrayType = fetch::math::Tensor<float, 2>;
+using SizeType  = ArrayType::SizeType;
+
+void NaiveDot(ArrayType const &A, ArrayType const &B, ArrayType &ret)
+{
+  for (SizeType i(0); i < A.shape()[0]; ++i)
+    {
+      for (SizeType j(0); j < B.shape()[1]; ++j)
+	{
+	  ret.Set(i, j, A.Get(i, 0) * B.Get(0, j));
+	  for (SizeType k(1); k < A.shape()[1]; ++k)
+	    {
+	      ret.Set(i, j, ret.Get(i, j) + A.Get(i, k) * B.Get(k, j));
+	    }
+	}
+    }
+}
+
+void NaiveDotTranspose(ArrayType const &A, ArrayType const &B, ArrayType &ret)
+{
+  for (SizeType i(0); i < A.shape()[0]; ++i)
+    {
+      for (SizeType j(0); j < B.shape()[0]; ++j)
+	{
+	  for (SizeType k(0); k < A.shape()[1]; ++k)
+	    {
+	      ret.Set(i, j, ret.Get(i, j) + A.Get(i, k) * B.Get(j, k));
+	    }
+	}
+    }
+}
+
+void NaiveTransposeDot(ArrayType const &A, ArrayType const &B, ArrayType &ret)
+{
+  for (SizeType i(0); i < A.shape()[1]; ++i)
+    {
+      for (SizeType j(0); j < B.shape()[1]; ++j)
+	{
+	  for (SizeType k(0); k < A.shape()[0]; ++k)
+	    {
+	      ret.Set(i, j, ret.Get(i, j) + A.Get(k, i) * B.Get(k, j));
+	    }
+	}
+    }
+}
+
+ArrayType Random(SizeType rows, SizeType cols, std::mt19937 &rng)
+{
+  std::uniform_real_distribution<float> distribution(-1.f, 1.f);
+  ArrayType t({rows, cols});
+  for (SizeType i(0) ; i < rows ; ++i)
+    {
+      for (SizeType j(0) ; j < cols ; ++j)
+	{
+	  t.Set(i, j, distribution(rng));
+	}
+    }
+  return t;
+}
+
+// Repeats f for about half a second and returns GFLOP/s, a product of m x k by k x n being 2mnk flops
+template <typename F>
+double GFlops(SizeType m, SizeType n, SizeType k, F const &f)
+{
+  f(); // Warm up
+  std::uint64_t runs(0);
+  auto start = std::chrono::steady_clock::now();
+  std::chrono::duration<double> elapsed(0);
+  while (elapsed.count() < 0.5)
+    {
+      f();
+      ++runs;
+      elapsed = std::chrono::steady_clock::now() - start;
+    }
+  return 2.0 * double(m) * double(n) * double(k) * double(runs) / elapsed.count() * 1e-9;
+}
+
+int main()
+{
+  using fetch::math::gemm::View;
+  using fetch::math::gemm::MultiplyAdd;
+  fetch::math::ThreadPool serial(0);
+  fetch::math::ThreadPool &pool = fetch::math::ThreadPool::Default();
+
+  std::mt19937 rng(42);
+  std::cout << "GFLOP/s, " << pool.NbThreads() << " threads" << std::endl;
+  std::cout << "m x n x k          variant        naive    blocked  threaded" << std::endl;
+  for (auto const &s : std::vector<std::array<SizeType, 3>>({{1, 25, 100}, {64, 25, 100}, {128, 128, 128}, {512, 512, 512}, {64, 10000, 100}}))
+    {
+      SizeType m(s[0]), n(s[1]), k(s[2]);
+      ArrayType a = Random(m, k, rng);
+      ArrayType b = Random(k, n, rng);
+      ArrayType b_t = Random(n, k, rng);
+      ArrayType a_t = Random(k, m, rng);
+      ArrayType c({m, n});
+
+      std::cout << m << " x " << n << " x " << k << "\t";
+      std::cout << "\tDot            " << GFlops(m, n, k, [&]() { NaiveDot(a, b, c); })
+		<< "\t" << GFlops(m, n, k, [&]() { c.Fill(0.f); MultiplyAdd(View(a), View(b), View(c), serial); })
+		<< "\t" << GFlops(m, n, k, [&]() { fetch::math::Dot(a, b, c); }) << std::endl;
+      std::cout << "\t\t\tDotTranspose   " << GFlops(m, n, k, [&]() { NaiveDotTranspose(a, b_t, c); })
+		<< "\t" << GFlops(m, n, k, [&]() { MultiplyAdd(View(a), View(b_t).Transposed(), View(c), serial); })
+		<< "\t" << GFlops(m, n, k, [&]() { fetch::math::DotTranspose(a, b_t, c); }) << std::endl;
+      std::cout << "\t\t\tTransposeDot   " << GFlops(m, n, k, [&]() { NaiveTransposeDot(a_t, b, c); })
+		<< "\t" << GFlops(m, n, k, [&]() { MultiplyAdd(View(a_t).Transposed(), View(b), View(c), serial); })
+		<< "\t" << GFlops(m, n, k, [&]() { fetch::math::TransposeDot(a_t, b, c); }) << std::endl;
+    }
+  return 0;
+}
@@ -0,0 +1,101 @@
+//------------------------------------------------------------------------------
+//
+//   Copyright 2018-2019 Fetch.AI Limited
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//------------------------------------------------------------------------------
+
+#include "sigmoid.hpp"
+#include "sigmoid_table.hpp"
+#include "table_sigmoid.hpp"
+#include "tensor.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <random>
+
+/*
+ * Compares the exact sigmoid (std::exp) with the lookup table, both as graph ops on a tensor
+ * and as the scalar call made by the fused trainers
+ */
+
+using ArrayType = fetch::math::Tensor<float, 2>;
+
+#define NB_ELEMENTS 1000000
+#define NB_REPETITIONS 20
+
+template <typename F>
+double nsPerElement(F const &f)
+{
+  f(); // Warm up
+  auto start = std::chrono::steady_clock::now();
+  for (int i(0) ; i < NB_REPETITIONS ; ++i)
+    {
+      f();
+    }
+  std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+  return elapsed.count() / (double(NB_ELEMENTS) * NB_REPETITIONS);
+}
+
+int main()
+{
+  // Dot products seen during training mostly fall in [-10, 10]
+  ArrayType input({1, NB_ELEMENTS});
+  ArrayType error({1, NB_ELEMENTS});
+  std::mt19937 rng(42);
+  std::uniform_real_distribution<float> distribution(-10.0f, 10.0f);
+  for (float &e : input)
+    {
+      e = distribution(rng);
+    }
+  error.Fill(1.0f);
+  ArrayType output({1, NB_ELEMENTS});
+  std::vector<ArrayType> gradients({ArrayType({1, NB_ELEMENTS})});
+
+  fetch::ml::ops::Sigmoid<ArrayType>      exact_op;
+  fetch::ml::ops::TableSigmoid<ArrayType> table_op;
+  fetch::math::SigmoidTable<float> const &table = table_op.Table();
+
+  std::cout << "Sigmoid::Forward           " << nsPerElement([&]() { exact_op.Forward({input}, output); }) << " ns/element" << std::endl;
+  std::cout << "TableSigmoid::Forward      " << nsPerElement([&]() { table_op.Forward({input}, output); }) << " ns/element" << std::endl;
+  std::cout << "Sigmoid::Backward          " << nsPerElement([&]() { exact_op.Backward({input}, error, gradients); }) << " ns/element" << std::endl;
+  std::cout << "TableSigmoid::Backward     " << nsPerElement([&]() { table_op.Backward({input}, error, gradients); }) << " ns/element" << std::endl;
+
+  // Scalar path, as used by the fused trainers
+  float const *data = input.Storage().get();
+  std::vector<float> results(NB_ELEMENTS);
+  std::cout << "fetch::math::Sigmoid exact " << nsPerElement([&]() {
+      for (std::uint64_t i(0) ; i < NB_ELEMENTS ; ++i)
+	results[i] = fetch::math::Sigmoid(data[i]);
+    }) << " ns/element" << std::endl;
+  std::cout << "fetch::math::Sigmoid table " << nsPerElement([&]() {
+      for (std::uint64_t i(0) ; i < NB_ELEMENTS ; ++i)
+	results[i] = fetch::math::Sigmoid(data[i], &table);
+    }) << " ns/element" << std::endl;
+  float sum(0);
+  for (float r : results)
+    {
+      sum += r;
+    }
+
+  // Accuracy of the table inside the clamped range
+  float max_error(0);
+  for (float x(-table.Clamp()) ; x < table.Clamp() ; x += 0.001f)
+    {
+      max_error = std::max(max_error, std::abs(fetch::math::Sigmoid(x) - table(x)));
+    }
+  std::cout << "Max absolute error in [-" << table.Clamp() << ", " << table.Clamp() << "] : " << max_error << std::endl;
+  std::cout << "(checksum " << sum << ")" << std::endl;
+  return 0;
+}
@@ -0,0 +1,119 @@
+//------------------------------------------------------------------------------
+//
+//   Copyright 2018-2019 Fetch.AI Limited
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//------------------------------------------------------------------------------
+
+#include "cbow_negative_sampling_trainer.hpp"
+#include "sigmoid_table.hpp"
+#include "tensor.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <vector>
+
+/*
+ * Cost of a CBOW training step depending on where the embedding rows sit in memory :
+ * rows starting on cache lines (the Tensor default), the former layout (rows padded to 8
+ * elements on a 16 bytes aligned block) and rows packed back to back from an odd address
+ * A step reads 10 context rows and 25 target rows out of a 70000 words vocabulary
+ */
+
+using ArrayType = fetch::math::Tensor<float, 2>;
+using SizeType  = ArrayType::SizeType;
+
+#define VOCAB_SIZE 70000
+#define CONTEXT_SIZE 10
+#define NB_TARGETS 25
+#define NB_STEPS 200000
+
+// [VOCAB_SIZE x dimensions] with rows of row_size elements, starting offset elements into an aligned block
+ArrayType Embeddings(SizeType dimensions, SizeType row_size, SizeType offset)
+{
+  ArrayType t({VOCAB_SIZE, dimensions}, {{1, 1}}, {{0, row_size - dimensions}},
+	      ArrayType::Allocate(VOCAB_SIZE * row_size + offset), offset);
+  std::mt19937 rng(1);
+  std::uniform_real_distribution<float> distribution(-0.5f, 0.5f);
+  for (SizeType r(0) ; r < VOCAB_SIZE ; ++r)
+    {
+      for (float &e : t.RowSpan(r))
+	{
+	  e = distribution(rng) / float(dimensions);
+	}
+    }
+  return t;
+}
+
+double nsPerStep(ArrayType words, ArrayType weights, std::vector<ArrayType> const &contexts, std::vector<ArrayType> const &targets)
+{
+  fetch::math::SigmoidTable<float> table;
+  fetch::ml::CBOWNegativeSamplingTrainer<float> trainer(words, weights);
+  trainer.SetSigmoidTable(&table);
+  auto run = [&]() {
+    for (SizeType step(0) ; step < NB_STEPS ; ++step)
+      {
+	trainer.Step(contexts[step % contexts.size()], targets[step % targets.size()], 0.025f);
+      }
+  };
+  run(); // Warm up
+  auto start = std::chrono::steady_clock::now();
+  run();
+  std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+  return elapsed.count() / NB_STEPS;
+}
+
+int main()
+{
+  // Zipf distributed words, as in a real corpus
+  std::mt19937 rng(42);
+  std::vector<double> frequencies(VOCAB_SIZE);
+  for (SizeType i(0) ; i < VOCAB_SIZE ; ++i)
+    {
+      frequencies[i] = 1.0 / double(i + 1);
+    }
+  std::discrete_distribution<SizeType> words(frequencies.begin(), frequencies.end());
+  std::vector<ArrayType> contexts;
+  std::vector<ArrayType> targets;
+  for (SizeType i(0) ; i < 4096 ; ++i)
+    {
+      contexts.push_back(ArrayType({1, CONTEXT_SIZE}));
+      targets.push_back(ArrayType({1, NB_TARGETS}));
+      for (float &w : contexts.back().AsSpan())
+	{
+	  w = float(words(rng));
+	}
+      for (float &w : targets.back().AsSpan())
+	{
+	  w = float(words(rng));
+	}
+    }
+
+  SizeType const line = ArrayType::DefaultAlignment;
+  for (SizeType dimensions : {100, 128, 300})
+    {
+      SizeType aligned = (dimensions + line - 1) / line * line;
+      SizeType padded8 = (dimensions + 7) / 8 * 8;
+      std::cout << "dimensions " << dimensions << std::endl;
+      std::cout << "  cache line aligned rows   "
+		<< nsPerStep(Embeddings(dimensions, aligned, 0), Embeddings(dimensions, aligned, 0), contexts, targets) << " ns/step" << std::endl;
+      std::cout << "  8 elements padding        "
+		<< nsPerStep(Embeddings(dimensions, padded8, 4), Embeddings(dimensions, padded8, 4), contexts, targets) << " ns/step" << std::endl;
+      std::cout << "  packed, odd address       "
+		<< nsPerStep(Embeddings(dimensions, dimensions, 1), Embeddings(dimensions, dimensions, 1), contexts, targets) << " ns/step" << std::endl;
+    }
+  return 0;
+}
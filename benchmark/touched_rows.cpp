@@ -0,0 +1,115 @@
+//------------------------------------------------------------------------------
+//
+//   Copyright 2018-2019 Fetch.AI Limited
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//------------------------------------------------------------------------------
+
+#include "touched_rows.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <set>
+#include <vector>
+
+/*
+ * Tracking the rows touched by a training step : the std::set the embedding ops used to have
+ * against TouchedRows. A step touches about 35 rows (10 context words + 25 targets)
+ */
+
+#define VOCAB_SIZE 70000
+#define ROWS_PER_STEP 35
+#define NB_STEPS 1000000
+
+template <typename F>
+double nsPerStep(F const &f)
+{
+  f(); // Warm up
+  auto start = std::chrono::steady_clock::now();
+  f();
+  std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+  return elapsed.count() / NB_STEPS;
+}
+
+int main()
+{
+  // Word frequencies follow Zipf's law, so some rows come back within a step
+  std::mt19937 rng(42);
+  std::vector<double> weights(VOCAB_SIZE);
+  for (std::uint64_t i(0) ; i < VOCAB_SIZE ; ++i)
+    {
+      weights[i] = 1.0 / double(i + 1);
+    }
+  std::discrete_distribution<std::uint64_t> distribution(weights.begin(), weights.end());
+  std::vector<std::uint64_t> rows(ROWS_PER_STEP * 4096);
+  for (std::uint64_t &r : rows)
+    {
+      r = distribution(rng);
+    }
+
+  std::uint64_t checksum(0);
+  std::set<std::uint64_t> set;
+  std::cout << "std::set    " << nsPerStep([&]() {
+      for (std::uint64_t step(0) ; step < NB_STEPS ; ++step)
+	{
+	  std::uint64_t const *r = &rows[(step % 4096) * ROWS_PER_STEP];
+	  for (std::uint64_t i(0) ; i < ROWS_PER_STEP ; ++i)
+	    {
+	      set.insert(r[i]);
+	    }
+	  for (std::uint64_t row : set)
+	    {
+	      checksum += row;
+	    }
+	  set.clear();
+	}
+    }) << " ns/step" << std::endl;
+
+  fetch::ml::TouchedRows touched;
+  std::cout << "TouchedRows " << nsPerStep([&]() {
+      for (std::uint64_t step(0) ; step < NB_STEPS ; ++step)
+	{
+	  std::uint64_t const *r = &rows[(step % 4096) * ROWS_PER_STEP];
+	  for (std::uint64_t i(0) ; i < ROWS_PER_STEP ; ++i)
+	    {
+	      touched.Insert(r[i]);
+	    }
+	  for (std::uint64_t row : touched.Rows())
+	    {
+	      checksum += row;
+	    }
+	  touched.Clear();
+	}
+    }) << " ns/step" << std::endl;
+
+  std::cout << "TouchedRows, sorted " << nsPerStep([&]() {
+      for (std::uint64_t step(0) ; step < NB_STEPS ; ++step)
+	{
+	  std::uint64_t const *r = &rows[(step % 4096) * ROWS_PER_STEP];
+	  for (std::uint64_t i(0) ; i < ROWS_PER_STEP ; ++i)
+	    {
+	      touched.Insert(r[i]);
+	    }
+	  for (std::uint64_t slot : touched.SortedSlots())
+	    {
+	      checksum += touched.Rows()[slot];
+	    }
+	  touched.Clear();
+	}
+    }) << " ns/step" << std::endl;
+  std::cout << "(checksum " << checksum << ")" << std::endl;
+  return 0;
+}
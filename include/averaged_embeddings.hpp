@@ -17,8 +17,8 @@
 //
 //------------------------------------------------------------------------------
 
+#include "sparse_row_gradient.hpp"
 #include "weights.hpp"
-#include <set>
 
 namespace fetch {
 namespace ml {
@@ -47,6 +47,26 @@ public:
 
   virtual ~AveragedEmbeddings() = default;
 
+  /*
+   * Only the rows touched by Backward get a gradient (see SparseRowGradient), so unlike other
+   * weights no dense gradient_accumulation_ is allocated
+   */
+  virtual bool SetData(ArrayType const &data)
+  {
+    return PlaceHolder<T, 2>::SetData(data);
+  }
+
+  virtual bool SetDirectUpdate(DataType learningRate)
+  {
+    direct_learning_rate_ = learningRate;
+    return true;
+  }
+
+  SparseRowGradient<ArrayType> const &Gradient() const
+  {
+    return gradient_;
+  }
+
   virtual ArrayType Forward(std::vector<std::reference_wrapper<ArrayType const>> const &inputs,
                             ArrayType &                                                 output)
   {
@@ -58,7 +78,7 @@ public:
     uint64_t valid_samples(0);
     // Taking a slice of the output, this as the effect of turning a [1xDIM] matrix into a [DIM] vector (could have used squeeze)
     // This is done for performance reasons as iterating over a vector is much faster than iterating over a matrix
-    fetch::math::Tensor<float, 1> output_slice = output.Slice(0);
+    fetch::math::TensorView<DataType, 1> output_slice = output.SliceView(0);
     bool clear = true;
     for (DataType const &i : inputs.front().get())
     {
@@ -66,12 +86,12 @@ public:
       {
 	if (clear)
 	  {
-	    output_slice.Copy(this->output_->Slice(typename ArrayType::SizeType(i)));
+	    output_slice.Copy(this->output_->SliceView(SizeType(i)));
 	    clear = false;
 	  }
 	else
 	  {
-	    output_slice.InlineAdd(this->output_->Slice(typename ArrayType::SizeType(i)));
+	    output_slice.InlineAdd(this->output_->SliceView(SizeType(i)));
 	  }
         valid_samples++;
       }
@@ -80,7 +100,7 @@ public:
     return output;
   }
 
-  virtual std::vector<ArrayType> Backward(
+  virtual std::vector<ArrayType> &Backward(
       std::vector<std::reference_wrapper<ArrayType const>> const &inputs,
       ArrayType const &                                           error_signal,
       std::vector<ArrayType>                                     &output)
@@ -90,37 +110,82 @@ public:
     
     // Taking a slice of the output, this as the effect of turning a [1xDIM] matrix into a [DIM] vector (could have used Squeeze)
     // This is done for performance reasons as iterating over a vector is much faster than iterating over a matrix
-    fetch::math::Tensor<float, 1> error_signal_slice = error_signal.Slice(0);
+    fetch::math::TensorView<DataType const, 1> error_signal_slice = error_signal.SliceView(0);
     
     for (DataType const &i : inputs.front().get())
     {
       if (i >= 0)
       {
-        updated_rows_.insert(typename ArrayType::SizeType(double(i)));
-	this->gradient_accumulation_->Slice(typename ArrayType::SizeType(i)).InlineAdd(error_signal_slice);
+	Update(SizeType(i), error_signal_slice);
       }
     }
     return output;
   }
 
-  virtual void Step(typename T::Type learningRate)
+  /*
+   * Batch version : each row of the input [BATCH x N] is a different context
+   * and gets averaged into the corresponding row of the output [BATCH x DIM]
+   */
+  virtual ArrayType ForwardBatch(std::vector<std::reference_wrapper<ArrayType const>> const &inputs,
+				 ArrayType &                                                 output)
   {
-    for (auto const &r : updated_rows_)
-    {
-      auto gradientAccumulationSlice = this->gradient_accumulation_->Slice(r);
-      auto outputSlice               = this->output_->Slice(r);
-      auto it1                       = gradientAccumulationSlice.begin();
-      auto end                       = gradientAccumulationSlice.end();
-      auto it2                       = outputSlice.begin();
-      while (it1 != end)
+    assert(this->output_);
+    assert(inputs.size() == 1);
+    assert(output.shape() == this->ComputeBatchOutputShape(inputs));
+
+    for (SizeType b(0); b < output.shape()[0]; ++b)
       {
-        *it2 += (*it1 * learningRate);
-        *it1 = 0;
-        ++it1;
-        ++it2;
+	fetch::math::TensorView<DataType const, 1> input_slice  = inputs.front().get().SliceView(b);
+	fetch::math::TensorView<DataType, 1>       output_slice = output.SliceView(b);
+	uint64_t valid_samples(0);
+	for (SizeType k(0); k < input_slice.Size(); ++k)
+	  {
+	    DataType const i = input_slice.Get(k);
+	    if (i >= 0)
+	      {
+		if (valid_samples == 0)
+		  {
+		    output_slice.Copy(this->output_->SliceView(SizeType(i)));
+		  }
+		else
+		  {
+		    output_slice.InlineAdd(this->output_->SliceView(SizeType(i)));
+		  }
+		valid_samples++;
+	      }
+	  }
+	output_slice.InlineDivide(DataType(valid_samples));
       }
-    }
-    updated_rows_.clear();
+    return output;
+  }
+
+  virtual std::vector<ArrayType> &BackwardBatch(
+      std::vector<std::reference_wrapper<ArrayType const>> const &inputs,
+      ArrayType const &                                           error_signal,
+      std::vector<ArrayType>                                     &output)
+  {
+    assert(inputs.size() == 1 && output.size() == 1);
+    assert(error_signal.shape()[0] == inputs.front().get().shape()[0]);
+
+    for (SizeType b(0); b < error_signal.shape()[0]; ++b)
+      {
+	fetch::math::TensorView<DataType const, 1> input_slice        = inputs.front().get().SliceView(b);
+	fetch::math::TensorView<DataType const, 1> error_signal_slice = error_signal.SliceView(b);
+	for (SizeType k(0); k < input_slice.Size(); ++k)
+	  {
+	    DataType const i = input_slice.Get(k);
+	    if (i >= 0)
+	      {
+		Update(SizeType(i), error_signal_slice);
+	      }
+	  }
+      }
+    return output;
+  }
+
+  virtual void Step(typename T::Type learningRate)
+  {
+    gradient_.Apply(*this->output_, learningRate);
   }
 
   virtual std::array<SizeType, 2> ComputeOutputShape(
@@ -131,8 +196,28 @@ public:
     return outputShape;
   }
 
+  virtual std::array<SizeType, 2> ComputeBatchOutputShape(
+      std::vector<std::reference_wrapper<ArrayType const>> const &inputs) const
+  {
+    return {inputs.front().get().shape()[0], this->output_->shape()[1]};
+  }
+
 private:
-  std::set<typename ArrayType::SizeType> updated_rows_;
+  // Gradient of one context word, applied right away in direct-update mode
+  void Update(SizeType row, fetch::math::TensorView<DataType const, 1> const &error_signal)
+  {
+    if (direct_learning_rate_ != DataType(0))
+      {
+	this->output_->SliceView(row).InlineAdd(error_signal, direct_learning_rate_);
+      }
+    else
+      {
+	gradient_.Add(row, error_signal);
+      }
+  }
+
+  SparseRowGradient<ArrayType> gradient_;
+  DataType                     direct_learning_rate_ = DataType(0); // 0 when accumulating in gradient_
 };
 
 }  // namespace ops
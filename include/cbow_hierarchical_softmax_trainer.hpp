@@ -0,0 +1,94 @@
+#pragma once
+//------------------------------------------------------------------------------
+//
+//   Copyright 2018-2019 Fetch.AI Limited
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//------------------------------------------------------------------------------
+
+#include "fused_trainer.hpp"
+#include "huffman_tree.hpp"
+
+#include <vector>
+
+namespace fetch {
+namespace ml {
+
+/*
+ * Specialised CBOW + hierarchical softmax training step
+ * Drop-in replacement for CBOWNegativeSamplingTrainer : instead of scoring the target word against
+ * negative samples, the averaged context predicts the branches taken along the target word's path
+ * in a Huffman tree. Each step only touches CodeLength(target) (~log2(V)) rows of inner_nodes
+ * Step takes the same context as CBOWNegativeSamplingTrainer, and targets [1 x K] whose first
+ * element is the word to predict, the others are ignored
+ */
+template <typename T>
+class CBOWHierarchicalSoftmaxTrainer : public FusedTrainer<CBOWHierarchicalSoftmaxTrainer<T>, T>
+{
+public:
+  using BaseType  = FusedTrainer<CBOWHierarchicalSoftmaxTrainer<T>, T>;
+  using ArrayType = typename BaseType::ArrayType;
+  using DataType  = T;
+  using SizeType  = typename ArrayType::SizeType;
+
+  /*
+   * @param words [V x D] word embeddings
+   * @param inner_nodes [V - 1 x D] one row per inner node of the tree
+   * @param tree Huffman tree built on the vocabulary, must outlive the trainer
+   */
+  CBOWHierarchicalSoftmaxTrainer(ArrayType &words, ArrayType &inner_nodes, HuffmanTree const &tree)
+    : BaseType(words, inner_nodes)
+    , tree_(tree)
+    , hidden_(this->dimensions_)
+    , hidden_error_(this->dimensions_)
+  {
+    assert(inner_nodes.shape()[0] >= tree_.NbInnerNodes());
+  }
+
+private:
+  friend BaseType;
+
+  template <typename Row>
+  void Run(Row row_kernels, ArrayType const &context, ArrayType const &targets, DataType learning_rate)
+  {
+    SizeType const dimensions = this->dimensions_;
+    this->GatherAverage(row_kernels, hidden_.data(), context.AsSpan());
+
+    // Binary logistic regression at each inner node on the path to the target word
+    SizeType const        target = SizeType(targets.Get(0, 0));
+    SizeType const        length = tree_.CodeLength(target);
+    std::uint8_t const *  codes  = tree_.Codes(target);
+    std::uint32_t const * points = tree_.Points(target);
+    Row::Fill(hidden_error_.data(), DataType(0), dimensions);
+    for (SizeType d(0) ; d < length ; ++d)
+      {
+	DataType *row = this->WeightsRow(SizeType(points[d]));
+	DataType dot = Row::Dot(hidden_.data(), row, dimensions);
+	// Following the original implementation, code 0 is the positive label
+	DataType error = (DataType(1) - DataType(codes[d]) - this->Sigmoid(dot)) * learning_rate;
+	Row::Axpy(hidden_error_.data(), row, error, dimensions);
+	Row::Axpy(row, hidden_.data(), error, dimensions);
+      }
+
+    // The errors are already scaled by the learning rate
+    this->Scatter(row_kernels, hidden_error_.data(), context.AsSpan(), DataType(1));
+  }
+
+  HuffmanTree const &   tree_;
+  std::vector<DataType> hidden_;
+  std::vector<DataType> hidden_error_;
+};
+
+}  // namespace ml
+}  // namespace fetch
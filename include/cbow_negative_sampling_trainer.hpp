@@ -0,0 +1,90 @@
+#pragma once
+//------------------------------------------------------------------------------
+//
+//   Copyright 2018-2019 Fetch.AI Limited
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//------------------------------------------------------------------------------
+
+#include "fused_trainer.hpp"
+
+#include <vector>
+
+namespace fetch {
+namespace ml {
+
+/*
+ * Specialised CBOW + negative sampling training step
+ * Computes exactly what the Graph [AveragedEmbeddings -> MatrixMultiply(Embeddings^T)] does,
+ * but in a single pass over raw rows : no virtual calls, no name lookups and no temporary tensors
+ * Step takes context [1 x N], the indices of the context words (negative values are ignored),
+ * and targets [1 x K], the indices of the output words, the first one being the positive sample
+ */
+template <typename T>
+class CBOWNegativeSamplingTrainer : public FusedTrainer<CBOWNegativeSamplingTrainer<T>, T>
+{
+public:
+  using BaseType  = FusedTrainer<CBOWNegativeSamplingTrainer<T>, T>;
+  using ArrayType = typename BaseType::ArrayType;
+  using DataType  = T;
+  using SizeType  = typename ArrayType::SizeType;
+
+  CBOWNegativeSamplingTrainer(ArrayType &words, ArrayType &weights)
+    : BaseType(words, weights)
+    , hidden_(this->dimensions_)
+    , hidden_error_(this->dimensions_)
+  {}
+
+private:
+  friend BaseType;
+
+  template <typename Row>
+  void Run(Row row_kernels, ArrayType const &context, ArrayType const &targets, DataType learning_rate)
+  {
+    SizeType const dimensions = this->dimensions_;
+    errors_.resize(targets.shape()[1]);
+    this->GatherAverage(row_kernels, hidden_.data(), context.AsSpan());
+
+    // Dot product, sigmoid and error for each target,
+    // the error on the hidden layer is computed with the weights before the update
+    Row::Fill(hidden_error_.data(), DataType(0), dimensions);
+    SizeType k(0);
+    for (DataType const &target : targets.AsSpan())
+      {
+	DataType const *row = this->WeightsRow(SizeType(target));
+	DataType dot = Row::Dot(hidden_.data(), row, dimensions);
+	DataType label = (k == 0) ? DataType(1) : DataType(0);
+	errors_[k] = label - this->Sigmoid(dot);
+	Row::Axpy(hidden_error_.data(), row, errors_[k], dimensions);
+	k++;
+      }
+
+    // Update output weights
+    k = 0;
+    for (DataType const &target : targets.AsSpan())
+      {
+	Row::Axpy(this->WeightsRow(SizeType(target)), hidden_.data(), errors_[k] * learning_rate, dimensions);
+	k++;
+      }
+
+    this->Scatter(row_kernels, hidden_error_.data(), context.AsSpan(), learning_rate);
+  }
+
+  std::vector<DataType> hidden_;
+  std::vector<DataType> hidden_error_;
+  std::vector<DataType> errors_;
+};
+
+}  // namespace ml
+}  // namespace fetch
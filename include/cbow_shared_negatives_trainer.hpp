@@ -0,0 +1,135 @@
+#pragma once
+//------------------------------------------------------------------------------
+//
+//   Copyright 2018-2019 Fetch.AI Limited
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//------------------------------------------------------------------------------
+
+#include "fused_trainer.hpp"
+#include "matrix_operations.hpp"
+
+namespace fetch {
+namespace ml {
+
+/*
+ * CBOW + negative sampling training step for a mini-batch of contexts sharing the same negatives
+ * The B contexts are scored against the B positive targets and the K negatives at once :
+ * [B x D].[D x (B + K)], so both the scoring and the gradients are dense matrix products
+ * Each context only learns from its own target (label 1) and the K negatives (label 0),
+ * the targets of the other contexts are masked out
+ * Step takes context [B x N], the indices of the context words (negative values are ignored), and
+ * targets [1 x B + K], the B positive targets (one per context) followed by the K shared negatives
+ */
+template <typename T>
+class CBOWSharedNegativesTrainer : public FusedTrainer<CBOWSharedNegativesTrainer<T>, T>
+{
+public:
+  using BaseType  = FusedTrainer<CBOWSharedNegativesTrainer<T>, T>;
+  using ArrayType = typename BaseType::ArrayType;
+  using DataType  = T;
+  using SizeType  = typename ArrayType::SizeType;
+
+  CBOWSharedNegativesTrainer(ArrayType &words, ArrayType &weights)
+    : BaseType(words, weights)
+  {}
+
+private:
+  friend BaseType;
+
+  template <typename Row>
+  void Run(Row row_kernels, ArrayType const &context, ArrayType const &targets, DataType learning_rate)
+  {
+    SizeType const batch_size = context.shape()[0];
+    SizeType const nb_targets = targets.shape()[1];
+    assert(nb_targets >= batch_size);
+    Resize(batch_size, nb_targets);
+
+    // Gather and average the context rows
+    for (SizeType b(0) ; b < batch_size ; ++b)
+      {
+	this->GatherAverage(row_kernels, hidden_.RowPointer(b), context.RowSpan(b));
+      }
+
+    // Gather the output rows
+    SizeType m(0);
+    for (DataType const &target : targets.AsSpan())
+      {
+	Row::Copy(outputs_.RowPointer(m++), this->WeightsRow(SizeType(target)), this->dimensions_);
+      }
+
+    // Scores [B x (B + K)] = hidden.outputs^T, straight through gemm so the step does not allocate
+    scores_.Fill(DataType(0));
+    fetch::math::DotTranspose(hidden_, outputs_, scores_);
+
+    // Sigmoid and error, already scaled by the learning rate
+    for (SizeType b(0) ; b < batch_size ; ++b)
+      {
+	DataType positive = targets.Get(0, b);
+	for (m = 0 ; m < nb_targets ; ++m)
+	  {
+	    DataType error(0);
+	    if (m == b)
+	      {
+		error = DataType(1) - this->Sigmoid(scores_.Get(b, m));
+	      }
+	    else if (m >= batch_size && targets.Get(0, m) != positive)
+	      {
+		error = DataType(0) - this->Sigmoid(scores_.Get(b, m));
+	      }
+	    scores_.Set(b, m, error * learning_rate);
+	  }
+      }
+
+    // Gradients : [B x D] = errors.outputs for the hidden layer and [(B + K) x D] = errors^T.hidden
+    // for the output rows, both computed from the values before the update
+    fetch::math::Dot(scores_, outputs_, hidden_gradient_);
+    output_gradient_.Fill(DataType(0));
+    fetch::math::TransposeDot(scores_, hidden_, output_gradient_);
+
+    // Scatter the output gradients back to the weights
+    m = 0;
+    for (DataType const &target : targets.AsSpan())
+      {
+	Row::Add(this->WeightsRow(SizeType(target)), output_gradient_.RowPointer(m++), this->dimensions_);
+      }
+
+    // Scatter the hidden error back to every context word
+    for (SizeType b(0) ; b < batch_size ; ++b)
+      {
+	this->Scatter(row_kernels, hidden_gradient_.RowPointer(b), context.RowSpan(b), DataType(1));
+      }
+  }
+
+  void Resize(SizeType batch_size, SizeType nb_targets)
+  {
+    if (scores_.shape()[0] != batch_size || scores_.shape()[1] != nb_targets)
+      {
+	hidden_  = ArrayType({batch_size, this->dimensions_});
+	outputs_ = ArrayType({nb_targets, this->dimensions_});
+	scores_  = ArrayType({batch_size, nb_targets});
+	hidden_gradient_ = ArrayType({batch_size, this->dimensions_});
+	output_gradient_ = ArrayType({nb_targets, this->dimensions_});
+      }
+  }
+
+  ArrayType hidden_{{1, 1}};
+  ArrayType outputs_{{1, 1}};
+  ArrayType scores_{{1, 1}};
+  ArrayType hidden_gradient_{{1, 1}};
+  ArrayType output_gradient_{{1, 1}};
+};
+
+}  // namespace ml
+}  // namespace fetch
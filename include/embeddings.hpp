@@ -17,8 +17,8 @@
 //
 //------------------------------------------------------------------------------
 
+#include "sparse_row_gradient.hpp"
 #include "weights.hpp"
-#include <set>
 
 namespace fetch {
 namespace ml {
@@ -47,6 +47,28 @@ public:
 
   virtual ~Embeddings() = default;
 
+  /*
+   * Only the rows touched by Backward get a gradient (see SparseRowGradient), so unlike other
+   * weights no dense gradient_accumulation_ is allocated
+   */
+  virtual bool SetData(ArrayType const &data)
+  {
+    return PlaceHolder<T, 2>::SetData(data);
+  }
+
+  virtual bool SetDirectUpdate(DataType learningRate)
+  {
+    direct_learning_rate_ = learningRate;
+    return true;
+  }
+
+  SparseRowGradient<ArrayType> const &Gradient() const
+  {
+    return gradient_;
+  }
+
+  // Every index is looked up independently, so a batch of words [BATCH x N] goes through the
+  // same kernels as a single sample and gives a [BATCH * N x DIM] output, one row per word
   virtual ArrayType Forward(std::vector<std::reference_wrapper<ArrayType const>> const &inputs,
                             ArrayType &                                                 output)
   {
@@ -57,13 +79,13 @@ public:
     uint64_t j(0);
     for (DataType const &i : inputs.front().get())
     {
-      output.Slice(j).Copy(this->output_->Slice(SizeType(i)));
+      output.SliceView(j).Copy(this->output_->SliceView(SizeType(i)));
       j++;
     }
     return output;
   }
 
-  virtual std::vector<ArrayType> Backward(
+  virtual std::vector<ArrayType> &Backward(
       std::vector<std::reference_wrapper<ArrayType const>> const &inputs,
       ArrayType const &                                           errorSignal,
       std::vector<ArrayType>                                     &output)
@@ -73,8 +95,14 @@ public:
     uint64_t j(0);
     for (DataType const &i : inputs.front().get())
     {
-      updated_rows_.insert(typename ArrayType::SizeType(double(i)));
-      this->gradient_accumulation_->Slice(typename ArrayType::SizeType(double(i))).InlineAdd(errorSignal.Slice(j));
+      if (direct_learning_rate_ != DataType(0))
+      {
+	this->output_->SliceView(SizeType(double(i))).InlineAdd(errorSignal.SliceView(j), direct_learning_rate_);
+      }
+      else
+      {
+	gradient_.Add(SizeType(double(i)), errorSignal.SliceView(j));
+      }
       j++;
     }
     return output;
@@ -82,22 +110,7 @@ public:
 
   virtual void Step(typename T::Type learningRate)
   {
-    for (auto const &r : updated_rows_)
-    {
-      auto gradientAccumulationSlice = this->gradient_accumulation_->Slice(r);
-      auto outputSlice               = this->output_->Slice(r);
-      auto it1                       = gradientAccumulationSlice.begin();
-      auto end                       = gradientAccumulationSlice.end();
-      auto it2                       = outputSlice.begin();
-      while (it1 != end)
-      {
-        *it2 += (*it1 * learningRate);
-        *it1 = 0;
-        ++it1;
-        ++it2;
-      }
-    }
-    updated_rows_.clear();
+    gradient_.Apply(*this->output_, learningRate);
   }
 
   virtual std::array<SizeType, 2> ComputeOutputShape(
@@ -107,7 +120,8 @@ public:
   }
 
 private:
-  std::set<typename ArrayType::SizeType> updated_rows_;
+  SparseRowGradient<ArrayType> gradient_;
+  DataType                     direct_learning_rate_ = DataType(0); // 0 when accumulating in gradient_
 };
 
 }  // namespace ops
@@ -0,0 +1,152 @@
+#pragma once
+//------------------------------------------------------------------------------
+//
+//   Copyright 2018-2019 Fetch.AI Limited
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//------------------------------------------------------------------------------
+
+#include <cassert>
+#include <cstddef>
+
+namespace fetch {
+namespace math {
+
+/*
+ * Row operations of the training kernels (gather-average, dot, axpy) for a row length N known at
+ * compile time : with a constant trip count the compiler fully unrolls and vectorises the loops
+ * FixedRow<T, 0> is the generic version, the length is then the runtime n
+ * The dot product keeps LANES partial sums so that it vectorises without reassociating floats
+ */
+template <typename T, std::size_t N>
+struct FixedRow
+{
+  static constexpr std::size_t DIMENSION = N;
+  static constexpr std::size_t LANES     = 8;
+
+  static std::size_t Length(std::size_t n)
+  {
+    assert(N == 0 || n == N);
+    return N ? N : n;
+  }
+
+  static T Dot(T const *a, T const *b, std::size_t n)
+  {
+    n = Length(n);
+    std::size_t const body = n - n % LANES;
+    T partial[LANES] = {};
+    for (std::size_t j(0) ; j < body ; j += LANES)
+      {
+	for (std::size_t l(0) ; l < LANES ; ++l)
+	  {
+	    partial[l] += a[j + l] * b[j + l];
+	  }
+      }
+    T dot(0);
+    for (std::size_t j(body) ; j < n ; ++j)
+      {
+	dot += a[j] * b[j];
+      }
+    for (std::size_t l(0) ; l < LANES ; ++l)
+      {
+	dot += partial[l];
+      }
+    return dot;
+  }
+
+  // y += x * alpha
+  static void Axpy(T *y, T const *x, T alpha, std::size_t n)
+  {
+    n = Length(n);
+    for (std::size_t j(0) ; j < n ; ++j)
+      {
+	y[j] += x[j] * alpha;
+      }
+  }
+
+  static void Add(T *y, T const *x, std::size_t n)
+  {
+    n = Length(n);
+    for (std::size_t j(0) ; j < n ; ++j)
+      {
+	y[j] += x[j];
+      }
+  }
+
+  static void Copy(T *y, T const *x, std::size_t n)
+  {
+    n = Length(n);
+    for (std::size_t j(0) ; j < n ; ++j)
+      {
+	y[j] = x[j];
+      }
+  }
+
+  static void Fill(T *y, T value, std::size_t n)
+  {
+    n = Length(n);
+    for (std::size_t j(0) ; j < n ; ++j)
+      {
+	y[j] = value;
+      }
+  }
+
+  static void Divide(T *y, T value, std::size_t n)
+  {
+    n = Length(n);
+    for (std::size_t j(0) ; j < n ; ++j)
+      {
+	y[j] /= value;
+      }
+  }
+};
+
+template <typename T, std::size_t N>
+constexpr std::size_t FixedRow<T, N>::DIMENSION;
+template <typename T, std::size_t N>
+constexpr std::size_t FixedRow<T, N>::LANES;
+
+/*
+ * Calls f(FixedRow<T, n>()) for the common embedding sizes (64, 100, 128, 200, 300) and
+ * f(FixedRow<T, 0>()) for the others. f is typically a generic lambda forwarding to a kernel
+ * templated on the row type, so that each size gets its own specialised copy of the kernel
+ */
+template <typename T, typename F>
+void WithFixedRow(std::size_t n, F &&f)
+{
+  switch (n)
+    {
+    case 64:
+      f(FixedRow<T, 64>());
+      break;
+    case 100:
+      f(FixedRow<T, 100>());
+      break;
+    case 128:
+      f(FixedRow<T, 128>());
+      break;
+    case 200:
+      f(FixedRow<T, 200>());
+      break;
+    case 300:
+      f(FixedRow<T, 300>());
+      break;
+    default:
+      f(FixedRow<T, 0>());
+      break;
+    }
+}
+
+}  // namespace math
+}  // namespace fetch
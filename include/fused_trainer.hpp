@@ -0,0 +1,139 @@
+#pragma once
+//------------------------------------------------------------------------------
+//
+//   Copyright 2018-2019 Fetch.AI Limited
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//------------------------------------------------------------------------------
+
+#include "fixed_row.hpp"
+#include "sigmoid_table.hpp"
+#include "tensor.hpp"
+
+namespace fetch {
+namespace ml {
+
+/*
+ * Input side shared by the fused trainers : the word embeddings [V x D] and the output weights
+ * [M x D] (negative sampling targets or hierarchical softmax inner nodes), both shared with the
+ * caller and updated in place, the optional sigmoid table and the gather / scatter of context rows
+ * Derived only implements its output head, as
+ *   template <typename Row> void Run(Row, ArrayType const &context, ArrayType const &targets, DataType learning_rate)
+ * which Step calls with the FixedRow kernels matching the embedding size
+ */
+template <typename Derived, typename T>
+class FusedTrainer
+{
+public:
+  using ArrayType = fetch::math::Tensor<T, 2>;
+  using DataType  = T;
+  using SizeType  = typename ArrayType::SizeType;
+
+  /*
+   * Run forward, backward and update for one sample, the layout of context and targets is
+   * specific to each trainer
+   */
+  void Step(ArrayType const &context, ArrayType const &targets, DataType learning_rate)
+  {
+    // One copy of the kernel per common embedding size, see WithFixedRow
+    fetch::math::WithFixedRow<DataType>(dimensions_, [&](auto row_kernels) {
+	static_cast<Derived *>(this)->Run(row_kernels, context, targets, learning_rate);
+      });
+  }
+
+  // Use a precomputed table instead of std::exp for the sigmoid, the table must outlive the trainer
+  void SetSigmoidTable(fetch::math::SigmoidTable<DataType> const *table)
+  {
+    sigmoid_table_ = table;
+  }
+
+protected:
+  FusedTrainer(ArrayType &words, ArrayType &weights)
+    : words_(words)
+    , weights_(weights)
+    , dimensions_(words.shape()[1])
+  {
+    // Keeping raw pointers around, so the hot loops never touch the shared_ptr
+    assert(words_.shape()[1] == weights_.shape()[1]);
+    assert(words_.IsDense() && weights_.IsDense());
+    words_data_     = words_.RowPointer(0);
+    words_stride_   = words_.DimensionSize(0);
+    weights_data_   = weights_.RowPointer(0);
+    weights_stride_ = weights_.DimensionSize(0);
+  }
+
+  DataType *WordRow(SizeType i) const
+  {
+    return words_data_ + i * words_stride_;
+  }
+
+  DataType *WeightsRow(SizeType i) const
+  {
+    return weights_data_ + i * weights_stride_;
+  }
+
+  DataType Sigmoid(DataType x) const
+  {
+    return fetch::math::Sigmoid(x, sigmoid_table_);
+  }
+
+  // hidden = average of the rows of the context words, negative indices are ignored
+  template <typename Row, typename Indices>
+  void GatherAverage(Row, DataType *hidden, Indices const &context) const
+  {
+    SizeType valid_samples(0);
+    for (DataType const &i : context)
+      {
+	if (i >= 0)
+	  {
+	    DataType const *row = WordRow(SizeType(i));
+	    if (valid_samples == 0)
+	      {
+		Row::Copy(hidden, row, dimensions_);
+	      }
+	    else
+	      {
+		Row::Add(hidden, row, dimensions_);
+	      }
+	    valid_samples++;
+	  }
+      }
+    Row::Divide(hidden, DataType(valid_samples), dimensions_);
+  }
+
+  // Adds error * alpha to the row of every context word, negative indices are ignored
+  template <typename Row, typename Indices>
+  void Scatter(Row, DataType const *error, Indices const &context, DataType alpha) const
+  {
+    for (DataType const &i : context)
+      {
+	if (i >= 0)
+	  {
+	    Row::Axpy(WordRow(SizeType(i)), error, alpha, dimensions_);
+	  }
+      }
+  }
+
+  ArrayType                                   words_;
+  ArrayType                                   weights_;
+  SizeType                                    dimensions_;
+  DataType *                                  words_data_;
+  SizeType                                    words_stride_;
+  DataType *                                  weights_data_;
+  SizeType                                    weights_stride_;
+  fetch::math::SigmoidTable<DataType> const * sigmoid_table_ = nullptr;
+};
+
+}  // namespace ml
+}  // namespace fetch
@@ -0,0 +1,450 @@
+#pragma once
+//------------------------------------------------------------------------------
+//
+//   Copyright 2018-2019 Fetch.AI Limited
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//------------------------------------------------------------------------------
+
+#include "thread_pool.hpp"
+#include "vector_kernels.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace fetch {
+namespace math {
+namespace gemm {
+
+using SizeType = std::uint64_t;
+
+/*
+ * A matrix anywhere in memory : element (i, j) is data[i * row_stride + j * col_stride]
+ * Tensors, their transposed views and blocks of columns all map to one without any copy
+ */
+template <typename T>
+struct MatrixView
+{
+  T       *data;
+  SizeType rows;
+  SizeType cols;
+  SizeType row_stride;
+  SizeType col_stride;
+
+  T &operator()(SizeType i, SizeType j) const
+  {
+    return data[i * row_stride + j * col_stride];
+  }
+
+  MatrixView Transposed() const
+  {
+    return {data, cols, rows, col_stride, row_stride};
+  }
+
+  MatrixView Block(SizeType row, SizeType col, SizeType nb_rows, SizeType nb_cols) const
+  {
+    return {data + row * row_stride + col * col_stride, nb_rows, nb_cols, row_stride, col_stride};
+  }
+};
+
+template <typename ArrayType>
+MatrixView<typename ArrayType::Type> View(ArrayType const &t)
+{
+  return {t.Storage().get() + t.Offset(), t.shape()[0], t.shape()[1], t.DimensionSize(0), t.DimensionSize(1)};
+}
+
+/*
+ * c += a.b, the textbook loops
+ * Used for the types without vector kernels
+ */
+template <typename T>
+void Reference(MatrixView<T> const &a, MatrixView<T> const &b, MatrixView<T> const &c)
+{
+  for (SizeType i(0) ; i < c.rows ; ++i)
+    {
+      for (SizeType j(0) ; j < c.cols ; ++j)
+	{
+	  T sum = c(i, j);
+	  T const *a_row = &a(i, 0);
+	  T const *b_col = &b(0, j);
+	  for (SizeType k(0) ; k < a.cols ; ++k)
+	    {
+	      sum += a_row[k * a.col_stride] * b_col[k * b.row_stride];
+	    }
+	  c(i, j) = sum;
+	}
+    }
+}
+
+/*
+ * Goto / BLIS style blocked product
+ * b is cut in KC x NC blocks packed in NR wide column panels, a in MC x KC blocks packed in MR
+ * high row panels, both padded with zeros, so the micro-kernel always computes a full
+ * MR x NR tile with unit stride loads, whatever the strides of the matrices
+ * NC is sized so the packed b block fits in L3_BYTES, the a panel and the b panel of the
+ * micro-kernel stay in L1
+ */
+template <typename MicroKernel, typename T>
+struct Blocked
+{
+  static constexpr SizeType L3_BYTES = 1024 * 1024;
+
+  static constexpr SizeType MR = MicroKernel::MR;
+  static constexpr SizeType NR = MicroKernel::NR;
+  static constexpr SizeType KC = 256;
+  static constexpr SizeType MC = MR * 16;
+  static constexpr SizeType NC = L3_BYTES / (KC * sizeof(T)) / NR * NR;
+
+  static void Multiply(MatrixView<T> const &a, MatrixView<T> const &b, MatrixView<T> const &c)
+  {
+    // Reused between calls, so only the first product of a thread allocates
+    thread_local std::vector<T> packed_a;
+    thread_local std::vector<T> packed_b;
+    T tile[MR * NR];
+
+    SizeType m = c.rows;
+    SizeType n = c.cols;
+    SizeType k = a.cols;
+    for (SizeType jc(0) ; jc < n ; jc += NC)
+      {
+	SizeType nc = std::min(NC, n - jc);
+	for (SizeType pc(0) ; pc < k ; pc += KC)
+	  {
+	    SizeType kc = std::min(KC, k - pc);
+	    packed_b.resize(kc * RoundUp(nc, NR));
+	    PackB(b.Block(pc, jc, kc, nc), packed_b.data());
+	    for (SizeType ic(0) ; ic < m ; ic += MC)
+	      {
+		SizeType mc = std::min(MC, m - ic);
+		packed_a.resize(kc * RoundUp(mc, MR));
+		PackA(a.Block(ic, pc, mc, kc), packed_a.data());
+		for (SizeType jr(0) ; jr < nc ; jr += NR)
+		  {
+		    for (SizeType ir(0) ; ir < mc ; ir += MR)
+		      {
+			MicroKernel::Run(kc, packed_a.data() + ir * kc, packed_b.data() + jr * kc, tile);
+			MatrixView<T> c_tile = c.Block(ic + ir, jc + jr, std::min(MR, mc - ir), std::min(NR, nc - jr));
+			for (SizeType i(0) ; i < c_tile.rows ; ++i)
+			  {
+			    for (SizeType j(0) ; j < c_tile.cols ; ++j)
+			      {
+				c_tile(i, j) += tile[i * NR + j];
+			      }
+			  }
+		      }
+		  }
+	      }
+	  }
+      }
+  }
+
+  static SizeType RoundUp(SizeType n, SizeType multiple)
+  {
+    return (n + multiple - 1) / multiple * multiple;
+  }
+
+  // Panels of MR rows : element (r, p) of a panel at p * MR + r
+  static void PackA(MatrixView<T> const &a, T *packed)
+  {
+    for (SizeType i(0) ; i < a.rows ; i += MR)
+      {
+	SizeType rows = std::min(MR, a.rows - i);
+	for (SizeType p(0) ; p < a.cols ; ++p)
+	  {
+	    SizeType r(0);
+	    for ( ; r < rows ; ++r)
+	      {
+		*packed++ = a(i + r, p);
+	      }
+	    for ( ; r < MR ; ++r)
+	      {
+		*packed++ = T(0);
+	      }
+	  }
+      }
+  }
+
+  // Panels of NR columns : element (p, c) of a panel at p * NR + c
+  static void PackB(MatrixView<T> const &b, T *packed)
+  {
+    for (SizeType j(0) ; j < b.cols ; j += NR)
+      {
+	SizeType cols = std::min(NR, b.cols - j);
+	for (SizeType p(0) ; p < b.rows ; ++p)
+	  {
+	    T const *row = &b(p, j);
+	    SizeType c(0);
+	    if (b.col_stride == 1)
+	      {
+		std::copy_n(row, cols, packed);
+		c = cols;
+	      }
+	    for ( ; c < cols ; ++c)
+	      {
+		packed[c] = row[c * b.col_stride];
+	      }
+	    std::fill(packed + cols, packed + NR, T(0));
+	    packed += NR;
+	  }
+      }
+  }
+};
+
+template <typename M, typename T>
+constexpr SizeType Blocked<M, T>::L3_BYTES;
+template <typename M, typename T>
+constexpr SizeType Blocked<M, T>::MR;
+template <typename M, typename T>
+constexpr SizeType Blocked<M, T>::NR;
+template <typename M, typename T>
+constexpr SizeType Blocked<M, T>::KC;
+template <typename M, typename T>
+constexpr SizeType Blocked<M, T>::MC;
+template <typename M, typename T>
+constexpr SizeType Blocked<M, T>::NC;
+
+#if FETCH_VECTOR_KERNELS
+
+/*
+ * Unlike the element-wise kernels, the GEMM kernels don't have to match a scalar loop bit for
+ * bit : their multiply-adds are contracted to FMA wherever the instruction set has it
+ */
+#if defined(__clang__)
+#define FETCH_GEMM_TARGET(ISA) __attribute__((target(ISA)))
+#define FETCH_GEMM_CONTRACT _Pragma("clang fp contract(fast)")
+#else
+#define FETCH_GEMM_TARGET(ISA) __attribute__((target(ISA), optimize("fp-contract=fast")))
+#define FETCH_GEMM_CONTRACT
+#endif
+
+/*
+ * MR x NR tile of a.b from an MR high panel of a and an NR wide panel of b, NR being two vectors
+ * Keeps the 2 * MR accumulators in registers (12 of the 16 SSE / AVX registers)
+ */
+#define FETCH_DEFINE_GEMM_MICRO_KERNEL(NAME, ISA, BYTES)				\
+  template <typename T>									\
+  struct NAME										\
+  {											\
+    typedef T Vector __attribute__((vector_size(BYTES)));				\
+    static constexpr SizeType WIDTH = BYTES / sizeof(T);				\
+    static constexpr SizeType MR    = 6;						\
+    static constexpr SizeType NR    = 2 * WIDTH;					\
+											\
+    FETCH_GEMM_TARGET(ISA) static void Run(SizeType kc, T const *a, T const *b, T *tile) \
+    {											\
+      FETCH_GEMM_CONTRACT								\
+      Vector acc[MR][2];								\
+      for (SizeType r(0) ; r < MR ; ++r)						\
+	{										\
+	  acc[r][0] = Vector{};								\
+	  acc[r][1] = Vector{};								\
+	}										\
+      for (SizeType p(0) ; p < kc ; ++p, a += MR, b += NR)				\
+	{										\
+	  Vector b0, b1;								\
+	  std::memcpy(&b0, b, BYTES);							\
+	  std::memcpy(&b1, b + WIDTH, BYTES);						\
+	  for (SizeType r(0) ; r < MR ; ++r)						\
+	    {										\
+	      acc[r][0] += a[r] * b0;							\
+	      acc[r][1] += a[r] * b1;							\
+	    }										\
+	}										\
+      for (SizeType r(0) ; r < MR ; ++r)						\
+	{										\
+	  std::memcpy(tile + r * NR, &acc[r][0], BYTES);				\
+	  std::memcpy(tile + r * NR + WIDTH, &acc[r][1], BYTES);			\
+	}										\
+    }											\
+											\
+    /* Sum of a[p] * b[p], for the products too small to pack */			\
+    FETCH_GEMM_TARGET(ISA) static T Dot(T const *a, T const *b, SizeType n)		\
+    {											\
+      FETCH_GEMM_CONTRACT								\
+      Vector acc0{}, acc1{};								\
+      SizeType p(0);									\
+      for ( ; p + NR <= n ; p += NR)							\
+	{										\
+	  Vector a0, a1, b0, b1;							\
+	  std::memcpy(&a0, a + p, BYTES);						\
+	  std::memcpy(&a1, a + p + WIDTH, BYTES);					\
+	  std::memcpy(&b0, b + p, BYTES);						\
+	  std::memcpy(&b1, b + p + WIDTH, BYTES);					\
+	  acc0 += a0 * b0;								\
+	  acc1 += a1 * b1;								\
+	}										\
+      acc0 += acc1;									\
+      T sum(0);										\
+      for (SizeType i(0) ; i < WIDTH ; ++i)						\
+	{										\
+	  sum += acc0[i];								\
+	}										\
+      for ( ; p < n ; ++p)								\
+	{										\
+	  sum += a[p] * b[p];								\
+	}										\
+      return sum;									\
+    }											\
+  };
+
+FETCH_DEFINE_GEMM_MICRO_KERNEL(SSE2MicroKernel, "sse2", 16)
+FETCH_DEFINE_GEMM_MICRO_KERNEL(AVX2MicroKernel, "avx2,fma", 32)
+FETCH_DEFINE_GEMM_MICRO_KERNEL(AVX512MicroKernel, "avx512f", 64)
+
+#undef FETCH_DEFINE_GEMM_MICRO_KERNEL
+#undef FETCH_GEMM_TARGET
+#undef FETCH_GEMM_CONTRACT
+
+#endif
+
+// Below that many multiply-adds, packing costs more than it saves
+constexpr SizeType BLOCKED_THRESHOLD = 8 * 1024;
+// Below that many, waking the pool costs more than it saves
+constexpr SizeType PARALLEL_THRESHOLD = 256 * 1024;
+
+/*
+ * c += a.b, large products being shared between the threads of pool
+ */
+template <typename T>
+void MultiplyAdd(MatrixView<T> const &a, MatrixView<T> const &b, MatrixView<T> const &c, ThreadPool &)
+{
+  Reference(a, b, c);
+}
+
+#if FETCH_VECTOR_KERNELS
+/*
+ * c += a.b without packing, when the unit strides allow it :
+ *  - rows of b and c contiguous : row i of c gets a(i, p) * row p of b for every p, with the vector add kernel
+ *  - rows of a and columns of b contiguous : every c(i, j) is a vector dot product
+ * A c with contiguous columns is handled as c^T += b^T.a^T
+ */
+template <typename MicroKernel, typename T>
+bool Small(MatrixView<T> const &a, MatrixView<T> const &b, MatrixView<T> const &c)
+{
+  if (c.col_stride != 1 && c.row_stride == 1)
+    {
+      return Small<MicroKernel>(b.Transposed(), a.Transposed(), c.Transposed());
+    }
+  if (c.col_stride == 1 && b.col_stride == 1)
+    {
+      static auto const add = fetch::math::kernels::Kernels<T>().add;
+      for (SizeType i(0) ; i < c.rows ; ++i)
+	{
+	  for (SizeType p(0) ; p < a.cols ; ++p)
+	    {
+	      add(&c(i, 0), &b(p, 0), a(i, p), c.cols);
+	    }
+	}
+      return true;
+    }
+  if (a.col_stride == 1 && b.row_stride == 1)
+    {
+      for (SizeType i(0) ; i < c.rows ; ++i)
+	{
+	  for (SizeType j(0) ; j < c.cols ; ++j)
+	    {
+	      c(i, j) += MicroKernel::Dot(&a(i, 0), &b(0, j), a.cols);
+	    }
+	}
+      return true;
+    }
+  return false;
+}
+
+/*
+ * Splits c in as many bands as the pool has threads, along its longer side and on tile
+ * boundaries, and runs the blocked product of each band on its own thread
+ * Every band packs its own copy of the shared operand, which is cheap next to the product
+ */
+template <typename MicroKernel, typename T>
+void Parallel(MatrixView<T> const &a, MatrixView<T> const &b, MatrixView<T> const &c, ThreadPool &pool)
+{
+  bool by_rows = c.rows * MicroKernel::NR >= c.cols * MicroKernel::MR;
+  SizeType tile = by_rows ? MicroKernel::MR : MicroKernel::NR;
+  SizeType length = by_rows ? c.rows : c.cols;
+  SizeType nb_tiles = (length + tile - 1) / tile;
+  SizeType nb_bands = std::min<SizeType>(pool.NbThreads(), nb_tiles);
+  pool.ParallelFor(nb_bands, [&](std::size_t band) {
+      SizeType begin = std::min(length, nb_tiles * band / nb_bands * tile);
+      SizeType end = std::min(length, nb_tiles * (band + 1) / nb_bands * tile);
+      if (by_rows)
+	{
+	  Blocked<MicroKernel, T>::Multiply(a.Block(begin, 0, end - begin, a.cols), b, c.Block(begin, 0, end - begin, c.cols));
+	}
+      else
+	{
+	  Blocked<MicroKernel, T>::Multiply(a, b.Block(0, begin, b.rows, end - begin), c.Block(0, begin, c.rows, end - begin));
+	}
+    });
+}
+
+template <typename MicroKernel, typename T>
+void VectorMultiplyAdd(MatrixView<T> const &a, MatrixView<T> const &b, MatrixView<T> const &c, ThreadPool &pool)
+{
+  SizeType size = c.rows * c.cols * a.cols;
+  if (size >= PARALLEL_THRESHOLD && pool.NbThreads() > 1)
+    {
+      Parallel<MicroKernel>(a, b, c, pool);
+    }
+  else if (size >= BLOCKED_THRESHOLD || !Small<MicroKernel>(a, b, c))
+    {
+      Blocked<MicroKernel, T>::Multiply(a, b, c);
+    }
+}
+
+template <typename T>
+void VectorMultiplyAdd(MatrixView<T> const &a, MatrixView<T> const &b, MatrixView<T> const &c, ThreadPool &pool)
+{
+  using fetch::math::kernels::InstructionSet;
+  static InstructionSet const isa = fetch::math::kernels::BestInstructionSet();
+  static bool const fma = __builtin_cpu_supports("fma");
+  if (isa == InstructionSet::AVX512)
+    {
+      VectorMultiplyAdd<AVX512MicroKernel<T>>(a, b, c, pool);
+    }
+  else if (isa == InstructionSet::AVX2 && fma)
+    {
+      VectorMultiplyAdd<AVX2MicroKernel<T>>(a, b, c, pool);
+    }
+  else
+    {
+      VectorMultiplyAdd<SSE2MicroKernel<T>>(a, b, c, pool);
+    }
+}
+
+template <>
+inline void MultiplyAdd<float>(MatrixView<float> const &a, MatrixView<float> const &b, MatrixView<float> const &c, ThreadPool &pool)
+{
+  VectorMultiplyAdd(a, b, c, pool);
+}
+
+template <>
+inline void MultiplyAdd<double>(MatrixView<double> const &a, MatrixView<double> const &b, MatrixView<double> const &c, ThreadPool &pool)
+{
+  VectorMultiplyAdd(a, b, c, pool);
+}
+#endif
+
+// c += a.b on the default pool
+template <typename T>
+void MultiplyAdd(MatrixView<T> const &a, MatrixView<T> const &b, MatrixView<T> const &c)
+{
+  MultiplyAdd(a, b, c, ThreadPool::Default());
+}
+
+}  // namespace gemm
+}  // namespace math
+}  // namespace fetch
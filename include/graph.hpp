@@ -23,14 +23,57 @@
 #include "weights.hpp"
 #include "state_dict.hpp"
 
+#include <algorithm>
 #include <iostream>
 #include <list>
 #include <memory>
+#include <string>
 #include <unordered_map>
+#include <vector>
 
 namespace fetch {
 namespace ml {
 
+/**
+ * Reference to a node of a graph, returned by Graph::AddNode : its index in the graph's list of
+ * nodes, so the calls made at every training step don't have to look the node up by name
+ * The type of the op is kept, which lets SetInput check at compile time that it gets a
+ * placeholder. Handles of any type convert to the untyped NodeHandle<>
+ * AddNode used to return the name of the node : handles also convert to it, so code that keeps
+ * it in a std::string or passes it as the input of another node still compiles
+ */
+template <class OperationType = void>
+struct NodeHandle;
+
+template <>
+struct NodeHandle<void>
+{
+  std::uint64_t index;
+  std::string   name;
+
+  operator std::string const &() const
+  {
+    return name;
+  }
+};
+
+template <class OperationType>
+struct NodeHandle
+{
+  std::uint64_t index;
+  std::string   name;
+
+  operator NodeHandle<>() const
+  {
+    return {index, name};
+  }
+
+  operator std::string const &() const
+  {
+    return name;
+  }
+};
+
 /**
  * The full graph on which to run the computation
  */
@@ -41,6 +84,7 @@ public:
   using ArrayType      = T;
   using ArrayPtrType   = std::shared_ptr<ArrayType>;
   using Datatype       = typename ArrayType::Type;
+  using SizeType       = typename ArrayType::SizeType;
 
   Graph()
   {}
@@ -52,6 +96,10 @@ public:
    */
   ArrayType Evaluate(std::string const &node_name)
   {
+    if (compiled_)
+    {
+      return RunForward(StepIndex(node_name));
+    }
     if (nodes_[node_name])
     {
       return nodes_[node_name]->Evaluate();
@@ -62,6 +110,17 @@ public:
     }
   }
 
+  // Same from the handle returned by AddNode, without looking up the name
+  template <class OperationType>
+  ArrayType Evaluate(NodeHandle<OperationType> const &node)
+  {
+    if (compiled_)
+    {
+      return RunForward(handle_steps_[node.index]);
+    }
+    return node_list_[node.index]->Evaluate();
+  }
+
   /**
    * Backpropagate an error signal through the graph
    * @param node_name name of node from which to begin backprop
@@ -69,9 +128,86 @@ public:
    */
   void BackPropagate(std::string const &node_name, ArrayType const &errorSignal)
   {
+    if (compiled_)
+    {
+      RunBackward(StepIndex(node_name), errorSignal);
+      return;
+    }
     nodes_[node_name]->BackPropagate(errorSignal);
   }
 
+  // Same from the handle returned by AddNode, without looking up the name
+  template <class OperationType>
+  void BackPropagate(NodeHandle<OperationType> const &node, ArrayType const &errorSignal)
+  {
+    if (compiled_)
+    {
+      RunBackward(handle_steps_[node.index], errorSignal);
+      return;
+    }
+    node_list_[node.index]->BackPropagate(errorSignal);
+  }
+
+  /**
+   * Builds a static execution plan : the nodes are sorted topologically once, with the buffers of
+   * their inputs resolved. Evaluate and BackPropagate then run as flat loops over the plan,
+   * without recursion, hash lookups (apart from the one for the node name) or temporary vectors
+   * When a node feeds several others, the error signals it receives are summed and it is
+   * back propagated once, instead of once per path as the recursive version does
+   * Adding a node drops the plan, Compile has to be called again
+   */
+  void Compile()
+  {
+    steps_.clear();
+    step_index_.clear();
+    std::unordered_map<NodeInterface<T> *, SizeType> position;
+    for (auto const &n : nodes_)
+    {
+      Sort(n.second.get(), position);
+    }
+    for (auto const &n : nodes_)
+    {
+      step_index_[n.first] = position.at(n.second.get());
+    }
+    handle_steps_.clear();
+    for (auto const &n : node_list_)
+    {
+      handle_steps_.push_back(position.at(n.get()));
+    }
+
+    // Resolve the inputs and gather the steps each node depends on
+    std::vector<bool> needed(steps_.size());
+    for (SizeType s(0); s < steps_.size(); ++s)
+    {
+      PlanStep &step = steps_[s];
+      for (auto const &i : step.node->GetInputs())
+      {
+	step.inputs.emplace_back(i->Output());
+	step.input_steps.push_back(position.at(i.get()));
+      }
+      std::fill(needed.begin(), needed.end(), false);
+      needed[s] = true;
+      for (SizeType a(s + 1); a-- > 0;)
+      {
+	if (needed[a])
+	{
+	  for (SizeType i : steps_[a].input_steps)
+	  {
+	    needed[i] = true;
+	  }
+	}
+      }
+      for (SizeType a(0); a <= s; ++a)
+      {
+	if (needed[a])
+	{
+	  step.plan.push_back(a);
+	}
+      }
+    }
+    compiled_ = true;
+  }
+
   /**
    * Adds a node without trainable parameters.
    * @tparam OperationType Op template type
@@ -79,17 +215,18 @@ public:
    * @param node_name non-unique specified node name
    * @param inputs names of node inputs to the node
    * @param params input parameters to the node op
+   * @return handle of the new node, for the calls made at every step
    */
   template <class OperationType, typename... Params>
-  meta::IfIsNotTrainable<ArrayType, OperationType, std::string> AddNode(
+  meta::IfIsNotTrainable<ArrayType, OperationType, NodeHandle<OperationType>> AddNode(
       std::string const &node_name, std::vector<std::string> const &inputs, Params... params)
   {
     std::string name = UpdateVariableName<OperationType>(node_name);
     std::shared_ptr<Node<ArrayType, OperationType>> op =
         std::make_shared<Node<ArrayType, OperationType>>(name, params...);
-    AddNodeImpl<OperationType>(name, inputs, op);
+    NodeHandle<OperationType> handle = AddNodeImpl<OperationType>(name, inputs, op);
     //    FETCH_LOG_INFO("ML_LIB", "Created non-trainable node [", name, "]");
-    return name;
+    return handle;
   }
 
   /**
@@ -99,18 +236,19 @@ public:
    * @param node_name non-unique specified node name
    * @param inputs names of node inputs to the node
    * @param params input parameters to the node op
+   * @return handle of the new node, for the calls made at every step
    */
   template <class OperationType, typename... Params>
-  meta::IfIsTrainable<ArrayType, OperationType, std::string> AddNode(
+  meta::IfIsTrainable<ArrayType, OperationType, NodeHandle<OperationType>> AddNode(
       std::string const &node_name, std::vector<std::string> const &inputs, Params... params)
   {
     std::string name = UpdateVariableName<OperationType>(node_name);
     std::shared_ptr<Node<ArrayType, OperationType>> op =
         std::make_shared<Node<ArrayType, OperationType>>(name, params...);
-    AddNodeImpl<OperationType>(name, inputs, op);
+    NodeHandle<OperationType> handle = AddNodeImpl<OperationType>(name, inputs, op);
     //FETCH_LOG_INFO("ML_LIB", "Created trainable node [", name, "]");
     trainable_[name] = op;
-    return name;
+    return handle;
   }
 
   std::shared_ptr<fetch::ml::NodeInterface<ArrayType>> GetNode(std::string const &node_name) const
@@ -144,10 +282,51 @@ public:
     {
       throw std::runtime_error("No placeholder node with name [" + node_name + "] found in graph!");
     }
-    for (auto &n : nodes_)
-    {
-      n.second->SetBatch(batch);
-    }
+    SetBatch(batch);
+  }
+
+  // Same from the handle returned by AddNode, which is known to be a placeholder
+  void SetInput(NodeHandle<ops::PlaceHolder<ArrayType, 2>> const &node, ArrayType const &data, bool batch = false)
+  {
+    std::shared_ptr<NodeInterface<T>> const &n = node_list_[node.index];
+    bool input_size_changed = static_cast<Node<ArrayType, ops::PlaceHolder<ArrayType, 2>> &>(*n).SetData(data);
+    ResetGraphCache(n, input_size_changed);
+    SetBatch(batch);
+  }
+
+  // Handles of other ops would otherwise convert to their name and only fail at runtime
+  template <class OperationType>
+  void SetInput(NodeHandle<OperationType> const &node, ArrayType const &data, bool batch = false) = delete;
+
+  /**
+   * Zero-copy version of SetInput : the placeholder reads data directly (see PlaceHolder::Bind),
+   * which must stay alive until the graph is done with it (see UnbindInput). Nothing is allocated
+   * or copied, and the buffers of the graph are kept as long as the shape doesn't change
+   */
+  void BindInput(NodeHandle<ops::PlaceHolder<ArrayType, 2>> const &node, ArrayType const &data, bool batch = false)
+  {
+    std::shared_ptr<NodeInterface<T>> const &n = node_list_[node.index];
+    bool input_size_changed = static_cast<Node<ArrayType, ops::PlaceHolder<ArrayType, 2>> &>(*n).Bind(data);
+    ResetGraphCache(n, input_size_changed);
+    SetBatch(batch);
+  }
+
+  // A temporary would be gone before the graph reads it
+  void BindInput(NodeHandle<ops::PlaceHolder<ArrayType, 2>> const &node, ArrayType &&data, bool batch = false) = delete;
+
+  /**
+   * The tensor bound to a placeholder was refilled in place, with the same shape : only the
+   * cached outputs that depend on it are invalidated
+   */
+  void InputUpdated(NodeHandle<ops::PlaceHolder<ArrayType, 2>> const &node)
+  {
+    ResetGraphCache(node_list_[node.index], false);
+  }
+
+  // Forgets the tensor given to BindInput, before it gets destroyed
+  void UnbindInput(NodeHandle<ops::PlaceHolder<ArrayType, 2>> const &node)
+  {
+    static_cast<Node<ArrayType, ops::PlaceHolder<ArrayType, 2>> &>(*node_list_[node.index]).Unbind();
   }
 
   /**
@@ -162,6 +341,22 @@ public:
     }
   }
 
+  /**
+   * Switches all the trainable ops that support it to direct-update SGD (see Trainable)
+   * Ops that don't keep accumulating their gradients until Step
+   * @param learningRate learning rate of the coming BackPropagate, 0 to go back to accumulating
+   * @return true if all the trainable ops apply their updates directly
+   */
+  virtual bool SetDirectUpdate(Datatype learningRate)
+  {
+    bool all = true;
+    for (auto &t : trainable_)
+    {
+      all = t.second->SetDirectUpdate(learningRate) && all;
+    }
+    return all;
+  }
+
   /**
    * Resets graph cache, clearing stored evaluation outputs
    * and recursively updating the input size for all downstream nodes
@@ -214,21 +409,39 @@ private:
    * @param op  the op to be added to the graph as a new node
    */
   template <typename OperationType>
-  void AddNodeImpl(std::string const &node_name, std::vector<std::string> const &inputs,
-                   std::shared_ptr<Node<ArrayType, OperationType>> op)
+  NodeHandle<OperationType> AddNodeImpl(std::string const &node_name, std::vector<std::string> const &inputs,
+					std::shared_ptr<Node<ArrayType, OperationType>> op)
   {
+    compiled_ = false;
     if (!(nodes_.find(node_name) == nodes_.end()))
     {
       throw std::runtime_error("node named [" + node_name + "] already exists");
     }
 
     nodes_[node_name] = op;
+    node_list_.push_back(op);
+    op->SetBatch(batch_);
 
     for (auto const &i : inputs)
     {
       nodes_[node_name]->AddInput(nodes_[i]);
       nodes_[i]->AddOutput(nodes_[node_name]);
     }
+    return {node_list_.size() - 1, node_name};
+  }
+
+  // Only goes through all the nodes when the mode changes
+  void SetBatch(bool batch)
+  {
+    if (batch == batch_)
+    {
+      return;
+    }
+    batch_ = batch;
+    for (auto &n : node_list_)
+    {
+      n->SetBatch(batch);
+    }
   }
 
   /**
@@ -256,9 +469,107 @@ private:
     return ret;
   }
 
+  /**
+   * One node of the compiled plan
+   */
+  struct PlanStep
+  {
+    NodeInterface<T> *                                   node;
+    std::vector<std::reference_wrapper<const ArrayType>> inputs;       // outputs of the input nodes
+    std::vector<SizeType>                                input_steps;  // and their position in steps_
+    std::vector<SizeType>                                plan;         // steps to run to evaluate this one, in order, itself last
+    ArrayType const *                                    error_signal = nullptr;  // received during the current backward pass
+    SizeType                                             nb_error_signals = 0;
+    ArrayType                                            error_sum = ArrayType({1, 1});  // when it received more than one
+  };
+
+  // Depth first, a node gets its position once all its inputs have theirs
+  void Sort(NodeInterface<T> *node, std::unordered_map<NodeInterface<T> *, SizeType> &position)
+  {
+    if (position.find(node) != position.end())
+    {
+      return;
+    }
+    for (auto const &i : node->GetInputs())
+    {
+      Sort(i.get(), position);
+    }
+    position[node] = steps_.size();
+    steps_.emplace_back();
+    steps_.back().node = node;
+  }
+
+  SizeType StepIndex(std::string const &node_name) const
+  {
+    auto it = step_index_.find(node_name);
+    if (it == step_index_.end())
+    {
+      throw std::runtime_error("node [" + node_name + "] not in graph");
+    }
+    return it->second;
+  }
+
+  ArrayType &RunForward(SizeType target)
+  {
+    for (SizeType s : steps_[target].plan)
+    {
+      steps_[s].node->Evaluate(steps_[s].inputs);
+    }
+    return steps_[target].node->Output();
+  }
+
+  void RunBackward(SizeType start, ArrayType const &errorSignal)
+  {
+    RunForward(start);
+    std::vector<SizeType> const &plan = steps_[start].plan;
+    for (SizeType s : plan)
+    {
+      steps_[s].nb_error_signals = 0;
+    }
+    steps_[start].error_signal     = &errorSignal;
+    steps_[start].nb_error_signals = 1;
+    for (SizeType p(plan.size()); p-- > 0;)
+    {
+      PlanStep &step = steps_[plan[p]];
+      std::vector<ArrayType> &signals = step.node->BackPropagate(step.inputs, *step.error_signal);
+      for (SizeType i(0); i < step.input_steps.size(); ++i)
+      {
+	AddErrorSignal(steps_[step.input_steps[i]], signals[i]);
+      }
+    }
+  }
+
+  void AddErrorSignal(PlanStep &step, ArrayType const &signal)
+  {
+    if (step.nb_error_signals == 0)
+    {
+      step.error_signal = &signal;
+    }
+    else
+    {
+      if (step.nb_error_signals == 1)
+      {
+	if (step.error_sum.shape() != signal.shape())
+	{
+	  step.error_sum = ArrayType(signal.shape());
+	}
+	step.error_sum.Assign(*step.error_signal);
+	step.error_signal = &step.error_sum;
+      }
+      step.error_sum += signal;
+    }
+    step.nb_error_signals++;
+  }
+
 protected:
   std::unordered_map<std::string, std::shared_ptr<fetch::ml::NodeInterface<ArrayType>>>  nodes_;
   std::unordered_map<std::string, std::shared_ptr<fetch::ml::ops::Trainable<ArrayType>>> trainable_;
+  std::vector<std::shared_ptr<fetch::ml::NodeInterface<ArrayType>>>                      node_list_;  // indexed by NodeHandle
+  bool                                                                                   batch_ = false;
+  std::vector<PlanStep>                                                                  steps_;
+  std::unordered_map<std::string, SizeType>                                              step_index_;
+  std::vector<SizeType>                                                                  handle_steps_;
+  bool                                                                                   compiled_ = false;
 };
 
 }  // namespace ml
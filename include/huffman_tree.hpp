@@ -0,0 +1,161 @@
+#pragma once
+//------------------------------------------------------------------------------
+//
+//   Copyright 2018-2019 Fetch.AI Limited
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <numeric>
+#include <vector>
+
+namespace fetch {
+namespace ml {
+
+/*
+ * Huffman tree over the vocabulary, used by hierarchical softmax
+ * Frequent words get short codes, so on average an update only touches ~log2(V) inner nodes
+ * The codes and paths of all words are stored back to back in two flat arrays (indexed through
+ * offsets_) so that looking up a word is a single contiguous read
+ * Inner nodes are numbered in [0, V - 1), the root being V - 2
+ */
+class HuffmanTree
+{
+public:
+  using SizeType = std::uint64_t;
+
+  HuffmanTree() = default;
+
+  explicit HuffmanTree(std::vector<std::uint64_t> const &frequencies)
+  {
+    Build(frequencies);
+  }
+
+  /*
+   * Build the tree from word counts, using the same linear time algorithm as the original
+   * word2vec (two queues : sorted leaves and inner nodes created in increasing count order)
+   */
+  void Build(std::vector<std::uint64_t> const &frequencies)
+  {
+    SizeType const vocab_size = frequencies.size();
+    offsets_.assign(vocab_size + 1, 0);
+    codes_.clear();
+    points_.clear();
+    if (vocab_size < 2)
+      {
+	return;
+      }
+
+    // Leaves sorted by decreasing count, followed by the inner nodes
+    std::vector<SizeType> sorted(vocab_size);
+    std::iota(sorted.begin(), sorted.end(), SizeType(0));
+    std::stable_sort(sorted.begin(), sorted.end(),
+		     [&frequencies](SizeType a, SizeType b) { return frequencies[a] > frequencies[b]; });
+
+    std::vector<std::uint64_t> count(vocab_size * 2 - 1);
+    std::vector<SizeType>      parent(vocab_size * 2 - 1, 0);
+    std::vector<std::uint8_t>  binary(vocab_size * 2 - 1, 0);
+    for (SizeType i(0) ; i < vocab_size ; ++i)
+      {
+	count[i] = frequencies[sorted[i]];
+      }
+
+    std::int64_t leaf = std::int64_t(vocab_size) - 1;  // Next smallest leaf
+    SizeType     node = vocab_size;                    // Next smallest inner node
+    for (SizeType i(0) ; i < vocab_size - 1 ; ++i)
+      {
+	SizeType min[2];
+	for (SizeType &m : min)
+	  {
+	    if (leaf >= 0 && (node >= vocab_size + i || count[SizeType(leaf)] < count[node]))
+	      {
+		m = SizeType(leaf--);
+	      }
+	    else
+	      {
+		m = node++;
+	      }
+	  }
+	count[vocab_size + i] = count[min[0]] + count[min[1]];
+	parent[min[0]]        = vocab_size + i;
+	parent[min[1]]        = vocab_size + i;
+	binary[min[1]]        = 1;
+      }
+
+    // Walk from each leaf up to the root, then store the path in root to leaf order
+    SizeType const root = vocab_size * 2 - 2;
+    std::vector<std::vector<std::uint8_t>>  word_codes(vocab_size);
+    std::vector<std::vector<std::uint32_t>> word_points(vocab_size);
+    for (SizeType i(0) ; i < vocab_size ; ++i)
+      {
+	std::vector<std::uint8_t> &  c = word_codes[sorted[i]];
+	std::vector<std::uint32_t> & p = word_points[sorted[i]];
+	for (SizeType n(i) ; n != root ; n = parent[n])
+	  {
+	    c.push_back(binary[n]);
+	    p.push_back(std::uint32_t(parent[n] - vocab_size));
+	  }
+	std::reverse(c.begin(), c.end());
+	std::reverse(p.begin(), p.end());
+      }
+    for (SizeType w(0) ; w < vocab_size ; ++w)
+      {
+	offsets_[w + 1] = offsets_[w] + word_codes[w].size();
+	codes_.insert(codes_.end(), word_codes[w].begin(), word_codes[w].end());
+	points_.insert(points_.end(), word_points[w].begin(), word_points[w].end());
+      }
+  }
+
+  SizeType VocabSize() const
+  {
+    return offsets_.empty() ? 0 : offsets_.size() - 1;
+  }
+
+  SizeType NbInnerNodes() const
+  {
+    return VocabSize() > 1 ? VocabSize() - 1 : 0;
+  }
+
+  SizeType CodeLength(SizeType word) const
+  {
+    return offsets_[word + 1] - offsets_[word];
+  }
+
+  /*
+   * Branch taken (0 or 1) at each inner node, from the root to the word
+   */
+  std::uint8_t const *Codes(SizeType word) const
+  {
+    return codes_.data() + offsets_[word];
+  }
+
+  /*
+   * Inner nodes visited, from the root to the word
+   */
+  std::uint32_t const *Points(SizeType word) const
+  {
+    return points_.data() + offsets_[word];
+  }
+
+private:
+  std::vector<SizeType>      offsets_;
+  std::vector<std::uint8_t>  codes_;
+  std::vector<std::uint32_t> points_;  // 32 bits is plenty for inner node indices and halves the traffic
+};
+
+}  // namespace ml
+}  // namespace fetch
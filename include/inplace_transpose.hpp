@@ -41,7 +41,7 @@ public:
     return inputs.front().get().Transpose();
   }
 
-  virtual std::vector<ArrayType> Backward(
+  virtual std::vector<ArrayType> &Backward(
       std::vector<std::reference_wrapper<ArrayType const>> const &inputs,
       ArrayType const &                                           errorSignal,
       std::vector<ArrayType>                                     &output)
@@ -51,6 +51,21 @@ public:
     return output;
   }
 
+  // The batch dimension just becomes the columns
+  ArrayType ForwardBatch(std::vector<std::reference_wrapper<ArrayType const>> const &inputs,
+                         ArrayType &                                                 output)
+  {
+    return Forward(inputs, output);
+  }
+
+  virtual std::vector<ArrayType> &BackwardBatch(
+      std::vector<std::reference_wrapper<ArrayType const>> const &inputs,
+      ArrayType const &                                           errorSignal,
+      std::vector<ArrayType>                                     &output)
+  {
+    return Backward(inputs, errorSignal, output);
+  }
+
   std::array<SizeType, 2> ComputeOutputShape(
       std::vector<std::reference_wrapper<ArrayType const>> const &inputs) const
   {
@@ -47,7 +47,7 @@ public:
     return output;
   }
 
-  std::vector<ArrayType> Backward(
+  std::vector<ArrayType> &Backward(
       std::vector<std::reference_wrapper<const ArrayType>> const &inputs,
       ArrayType const &                                           errorSignal,
       std::vector<ArrayType>                                     &output)
@@ -63,12 +63,51 @@ public:
     return output;
   }
 
+  /*
+   * In batch mode inputs[0] is [BATCH x N] and inputs[1] is [N x BATCH * M]
+   * (e.g. the transposed embeddings of BATCH rows of M words), each sample only
+   * being multiplied by its own block of columns
+   */
+  ArrayType ForwardBatch(std::vector<std::reference_wrapper<ArrayType const>> const &inputs,
+                         ArrayType &                                                 output)
+  {
+    assert(inputs.size() == 2);
+    assert(output.shape() == ComputeBatchOutputShape(inputs));
+
+    fetch::math::BatchDot(inputs[0].get(), inputs[1].get(), output);
+    return output;
+  }
+
+  std::vector<ArrayType> &BackwardBatch(
+      std::vector<std::reference_wrapper<const ArrayType>> const &inputs,
+      ArrayType const &                                           errorSignal,
+      std::vector<ArrayType>                                     &output)
+  {
+    assert(inputs.size() == 2 && output.size() == 2);
+
+    output[0].Fill(0);
+    output[1].Fill(0);
+
+    fetch::math::BatchDotTranspose(errorSignal, inputs.at(1).get(), output[0]);
+    fetch::math::BatchTransposeDot(inputs.at(0).get(), errorSignal, output[1]);
+
+    return output;
+  }
+
   std::array<SizeType, 2> ComputeOutputShape(
       std::vector<std::reference_wrapper<ArrayType const>> const &inputs) const
   {
     return {inputs.at(0).get().shape()[0], inputs.at(1).get().shape()[1]};
   }
 
+  std::array<SizeType, 2> ComputeBatchOutputShape(
+      std::vector<std::reference_wrapper<ArrayType const>> const &inputs) const
+  {
+    SizeType batch_size = inputs.at(0).get().shape()[0];
+    assert(inputs.at(1).get().shape()[1] % batch_size == 0);
+    return {batch_size, inputs.at(1).get().shape()[1] / batch_size};
+  }
+
   static constexpr char const *DESCRIPTOR = "MatrixMultiply";
 };
 
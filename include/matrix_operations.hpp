@@ -17,51 +17,118 @@
 //
 //------------------------------------------------------------------------------
 
+#include "gemm.hpp"
+
+#include <cassert>
+#include <cstddef>
 
 namespace fetch {
 namespace math {
-  
+
+  /*
+   * The products below go through gemm::MultiplyAdd, which reads the operands through their
+   * strides : transposed tensors and blocks of columns are used in place, never copied
+   */
+
   template <typename ArrayType>
   void Dot(ArrayType const &A, ArrayType const &B, ArrayType &ret)
   {
-    for (typename ArrayType::SizeType i(0); i < A.shape()[0]; ++i)
+    assert(A.shape()[1] == B.shape()[0]);
+    assert(ret.shape()[0] == A.shape()[0] && ret.shape()[1] == B.shape()[1]);
+    ret.Fill(typename ArrayType::Type(0));
+    gemm::MultiplyAdd(gemm::View(A), gemm::View(B), gemm::View(ret));
+  }
+
+  // ret += A.B^T
+  template <class ArrayType>
+  void DotTranspose(ArrayType const &A, ArrayType const &B, ArrayType &ret)
+  {
+    assert(A.shape()[1] == B.shape()[1]);
+    assert(ret.shape()[0] == A.shape()[0] && ret.shape()[1] == B.shape()[0]);
+    gemm::MultiplyAdd(gemm::View(A), gemm::View(B).Transposed(), gemm::View(ret));
+  }
+
+  // ret += A^T.B
+  template <class ArrayType>
+  void TransposeDot(ArrayType const &A, ArrayType const &B, ArrayType &ret)
+  {
+    assert(A.shape()[0] == B.shape()[0]);
+    assert(ret.shape()[0] == A.shape()[1] && ret.shape()[1] == B.shape()[1]);
+    gemm::MultiplyAdd(gemm::View(A).Transposed(), gemm::View(B), gemm::View(ret));
+  }
+
+  /*
+   * Batched product : A is [BATCH x N], B is [N x BATCH * M] and ret is [BATCH x M]
+   * Row b of A is multiplied by the b-th block of M columns of B, so each sample
+   * only pays for its own [1 x N].[N x M] product
+   */
+  template <class ArrayType>
+  void BatchDot(ArrayType const &A, ArrayType const &B, ArrayType &ret)
+  {
+    size_t n = A.shape()[1];
+    size_t m = ret.shape()[1];
+    assert(B.shape()[1] == A.shape()[0] * m);
+    ret.Fill(typename ArrayType::Type(0));
+    auto a = gemm::View(A);
+    auto b = gemm::View(B);
+    auto c = gemm::View(ret);
+    for (size_t i(0); i < A.shape()[0]; ++i)
       {
-	for (typename ArrayType::SizeType j(0); j < B.shape()[1]; ++j)
-	  {
-	    ret.Set(i, j, A.Get(i, 0) * B.Get(0, j));
-	    for (typename ArrayType::SizeType k(1); k < A.shape()[1]; ++k)
-	      {
-		ret.Set(i, j, ret.Get(i, j) + A.Get(i, k) * B.Get(k, j));
-	      }
-	  }
+	gemm::MultiplyAdd(a.Block(i, 0, 1, n), b.Block(0, i * m, n, m), c.Block(i, 0, 1, m));
       }
   }
-  
+
+  /*
+   * Gradient of BatchDot with regard to A : A is [BATCH x M], B is [N x BATCH * M], ret is [BATCH x N]
+   */
   template <class ArrayType>
-  void DotTranspose(ArrayType const &A, ArrayType const &B, ArrayType &ret)
+  void BatchDotTranspose(ArrayType const &A, ArrayType const &B, ArrayType &ret)
   {
+    size_t n = B.shape()[0];
+    size_t m = A.shape()[1];
+    auto a = gemm::View(A);
+    auto b = gemm::View(B);
+    auto c = gemm::View(ret);
     for (size_t i(0); i < A.shape()[0]; ++i)
       {
-	for (size_t j(0); j < B.shape()[0]; ++j)
-	  {
-	    for (size_t k(0); k < A.shape()[1]; ++k)
-	      {
-		ret.Set(i, j, ret.Get(i, j) + A.Get(i, k) * B.Get(j, k));
-	      }
-	  }
+	gemm::MultiplyAdd(a.Block(i, 0, 1, m), b.Block(0, i * m, n, m).Transposed(), c.Block(i, 0, 1, n));
       }
   }
-  
+
+  /*
+   * Gradient of BatchDot with regard to B : A is [BATCH x N], B is [BATCH x M], ret is [N x BATCH * M]
+   * Every sample is an outer product of M columns only, too narrow for gemm : when the rows of B
+   * and ret are contiguous, a single pass over the rows of ret is much faster than a product per
+   * sample
+   */
   template <class ArrayType>
-  void TransposeDot(ArrayType const &A, ArrayType const &B, ArrayType &ret)
+  void BatchTransposeDot(ArrayType const &A, ArrayType const &B, ArrayType &ret)
   {
-    for (size_t i(0); i < A.shape()[1]; ++i)
+    using T = typename ArrayType::Type;
+    size_t n = A.shape()[1];
+    size_t m = B.shape()[1];
+    assert(ret.shape()[0] == n && ret.shape()[1] == A.shape()[0] * m);
+    auto a = gemm::View(A);
+    auto b = gemm::View(B);
+    auto c = gemm::View(ret);
+    if (b.col_stride != 1 || c.col_stride != 1)
+      {
+	for (size_t i(0); i < A.shape()[0]; ++i)
+	  {
+	    gemm::MultiplyAdd(a.Block(i, 0, 1, n).Transposed(), b.Block(i, 0, 1, m), c.Block(0, i * m, n, m));
+	  }
+	return;
+      }
+    for (size_t p(0); p < n; ++p)
       {
-	for (size_t j(0); j < B.shape()[1]; ++j)
+	T *c_row = &c(p, 0);
+	for (size_t i(0); i < A.shape()[0]; ++i, c_row += m)
 	  {
-	    for (size_t k(0); k < A.shape()[0]; ++k)
+	    T const  a_ip  = a(i, p);
+	    T const *b_row = &b(i, 0);
+	    for (size_t j(0); j < m; ++j)
 	      {
-		ret.Set(i, j, ret.Get(i, j) + A.Get(k, i) * B.Get(k, j));
+		c_row[j] += a_ip * b_row[j];
 	      }
 	  }
       }
@@ -36,13 +36,24 @@ public:
   using ArrayPtrType   = std::shared_ptr<ArrayType>;
 
   virtual ArrayType &Evaluate()                                            = 0;
+  /*
+   * Non recursive versions of Evaluate and BackPropagate for Graph's compiled plan : the inputs
+   * are the outputs of the input nodes, already evaluated, and BackPropagate only returns the
+   * error signals of the inputs instead of propagating them
+   */
+  virtual ArrayType &Evaluate(std::vector<std::reference_wrapper<const ArrayType>> const &inputs) = 0;
+  virtual std::vector<ArrayType> &BackPropagate(std::vector<std::reference_wrapper<const ArrayType>> const &inputs,
+						ArrayType const &errorSignal) = 0;
+  // Output of the last evaluation, the object stays the same for the lifetime of the node
+  virtual ArrayType &Output()                                              = 0;
   virtual void       AddInput(std::shared_ptr<NodeInterface<T>> const &i)  = 0;
   virtual void       AddOutput(std::shared_ptr<NodeInterface<T>> const &i) = 0;
-  virtual std::vector<std::pair<NodeInterface<T> *, ArrayType>> BackPropagate(
+  virtual std::vector<std::pair<NodeInterface<T> *, ArrayType>> const &BackPropagate(
       ArrayType const &errorSignal)                                                = 0;
   virtual void ResetCache(bool input_size_changed)                                 = 0;
   virtual void SetBatch(bool b)                                                    = 0;
   virtual std::vector<std::shared_ptr<NodeInterface<T>>> const &GetOutputs() const = 0;
+  virtual std::vector<std::shared_ptr<NodeInterface<T>>> const &GetInputs() const  = 0;
 };
 
 template <class T, class O>
@@ -71,24 +82,33 @@ public:
 
   virtual ~Node() = default;
 
-  std::vector<std::reference_wrapper<const ArrayType>> GatherInputs() const
+  // The returned vector is reused by the next call
+  std::vector<std::reference_wrapper<const ArrayType>> const &GatherInputs()
   {
-    std::vector<std::reference_wrapper<const ArrayType>> inputs;
+    gathered_inputs_.clear();
     for (auto const &i : inputs_)
     {
-      inputs.push_back(i->Evaluate());
+      gathered_inputs_.push_back(i->Evaluate());
     }
-    return inputs;
+    return gathered_inputs_;
   }
 
   virtual ArrayType &Evaluate()
   {
     if (cached_output_status_ != CachedOutputState::VALID_CACHE)
     {
-      std::vector<std::reference_wrapper<const ArrayType>> inputs = GatherInputs();
+      Evaluate(GatherInputs());
+    }
+    return cached_output_;
+  }
+
+  virtual ArrayType &Evaluate(std::vector<std::reference_wrapper<const ArrayType>> const &inputs)
+  {
+    if (cached_output_status_ != CachedOutputState::VALID_CACHE)
+    {
       if (cached_output_status_ == CachedOutputState::CHANGED_SIZE)
       {
-        auto output_shape = this->ComputeOutputShape(inputs);
+        auto output_shape = batch_ ? this->ComputeBatchOutputShape(inputs) : this->ComputeOutputShape(inputs);
         if (cached_output_.shape() != output_shape)
         {
           cached_output_ = ArrayType(output_shape);
@@ -101,7 +121,7 @@ public:
       }
       if (batch_)
       {
-        cached_output_ = this->ForwardBatch(inputs);
+        cached_output_ = this->ForwardBatch(inputs, cached_output_);
       }
       else
       {
@@ -113,17 +133,22 @@ public:
     return cached_output_;
   }
 
-  virtual std::vector<std::pair<NodeInterface<T> *, ArrayType>> BackPropagate(
+  /*
+   * The returned vector belongs to the node and is reused by the next call, like all the
+   * vectors used on the way : once the shapes are known, BackPropagate doesn't allocate
+   */
+  virtual std::vector<std::pair<NodeInterface<T> *, ArrayType>> const &BackPropagate(
       ArrayType const &errorSignal) 
   {
-    std::vector<std::reference_wrapper<const ArrayType>> inputs = GatherInputs();
-    std::vector<ArrayType> back_propagated_error_signals = this->Backward(inputs, errorSignal, cached_error_signal_);
-    std::vector<std::pair<NodeInterface<T> *, ArrayType>> non_back_propagated_error_signals;
+    std::vector<std::reference_wrapper<const ArrayType>> const &inputs = GatherInputs();
+    std::vector<ArrayType> &back_propagated_error_signals = BackPropagate(inputs, errorSignal);
+    std::vector<std::pair<NodeInterface<T> *, ArrayType>> &non_back_propagated_error_signals = non_back_propagated_error_signals_;
+    non_back_propagated_error_signals.clear();
     assert(back_propagated_error_signals.size() == inputs.size() || inputs.empty());
 
     for (std::uint64_t i(0); i < inputs_.size(); ++i)
     {
-      auto ret = inputs_[i]->BackPropagate(back_propagated_error_signals[i]);
+      auto const &ret = inputs_[i]->BackPropagate(back_propagated_error_signals[i]);
       non_back_propagated_error_signals.insert(non_back_propagated_error_signals.end(), ret.begin(),
                                                ret.end());
     }
@@ -133,7 +158,7 @@ public:
     // so it sends its unpropagated gradient to its wrapper node that will forward them out
     if (inputs_.empty())
     {
-      for (auto g : back_propagated_error_signals)
+      for (auto const &g : back_propagated_error_signals)
       {
         non_back_propagated_error_signals.push_back(std::make_pair(this, g));
       }
@@ -141,6 +166,18 @@ public:
     return non_back_propagated_error_signals;
   }
 
+  virtual std::vector<ArrayType> &BackPropagate(std::vector<std::reference_wrapper<const ArrayType>> const &inputs,
+						ArrayType const &errorSignal)
+  {
+    return batch_ ? this->BackwardBatch(inputs, errorSignal, cached_error_signal_) :
+      this->Backward(inputs, errorSignal, cached_error_signal_);
+  }
+
+  virtual ArrayType &Output()
+  {
+    return cached_output_;
+  }
+
   void AddInput(std::shared_ptr<NodeInterface<T>> const &i)
   {
     inputs_.push_back(i);
@@ -156,10 +193,22 @@ public:
     return outputs_;
   }
 
+  virtual std::vector<std::shared_ptr<NodeInterface<T>>> const &GetInputs() const
+  {
+    return inputs_;
+  }
+
   virtual void ResetCache(bool input_size_changed)
   {
-    cached_output_status_ =
-        input_size_changed ? CachedOutputState::CHANGED_SIZE : CachedOutputState::CHANGED_CONTENT;
+    // A size change that hasn't been evaluated yet must not be downgraded by a later content change
+    if (input_size_changed || cached_output_status_ == CachedOutputState::CHANGED_SIZE)
+    {
+      cached_output_status_ = CachedOutputState::CHANGED_SIZE;
+    }
+    else
+    {
+      cached_output_status_ = CachedOutputState::CHANGED_CONTENT;
+    }
   }
 
   virtual void SetBatch(bool b)
@@ -174,6 +223,8 @@ private:
 
   ArrayType                                      cached_output_;
   std::vector<ArrayType>                         cached_error_signal_;
+  std::vector<std::reference_wrapper<const ArrayType>>  gathered_inputs_;
+  std::vector<std::pair<NodeInterface<T> *, ArrayType>> non_back_propagated_error_signals_;
   CachedOutputState                              cached_output_status_;
   bool                                           batch_;
 };
@@ -35,9 +35,10 @@ public:
   using SizeType     = typename ArrayType::SizeType;
   using ArrayPtrType = std::shared_ptr<ArrayType>;
 
+  // Convenience versions allocating their outputs, as Tensor temporaries (see Tensor::Temporary)
   virtual ArrayType Forward(std::vector<std::reference_wrapper<ArrayType const>> const &inputs)
   {
-    ArrayType output(ComputeOutputShape(inputs));
+    ArrayType output = ArrayType::Temporary(ComputeOutputShape(inputs));
     return Forward(inputs, output);
   }
 
@@ -46,19 +47,46 @@ public:
     std::vector<ArrayType> output;
     for (auto const &i : inputs)
       {
-	output.emplace_back(i.get().shape());
+	output.push_back(ArrayType::Temporary(i.get().shape()));
       }
-    return Backward(inputs, errorSignal, output);
+    Backward(inputs, errorSignal, output);
+    return output;
   }
 
   virtual ArrayType Forward(std::vector<std::reference_wrapper<ArrayType const>> const &inputs, ArrayType &output) = 0;
-  virtual std::vector<ArrayType> Backward(std::vector<std::reference_wrapper<const ArrayType>> const &inputs, ArrayType const &errorSignal, std::vector<ArrayType> &output) = 0;
+  virtual std::vector<ArrayType> &Backward(std::vector<std::reference_wrapper<const ArrayType>> const &inputs, ArrayType const &errorSignal, std::vector<ArrayType> &output) = 0;
 
-  virtual ArrayType ForwardBatch(std::vector<std::reference_wrapper<const ArrayType>> const &inputs) = 0;
-  virtual std::vector<ArrayType> BackwardBatch(std::vector<std::reference_wrapper<const ArrayType>> const &inputs, ArrayType const & errorSignal) = 0;
+  virtual ArrayType ForwardBatch(std::vector<std::reference_wrapper<const ArrayType>> const &inputs)
+  {
+    ArrayType output = ArrayType::Temporary(ComputeBatchOutputShape(inputs));
+    return ForwardBatch(inputs, output);
+  }
+
+  virtual std::vector<ArrayType> BackwardBatch(std::vector<std::reference_wrapper<const ArrayType>> const &inputs, ArrayType const &errorSignal)
+  {
+    std::vector<ArrayType> output;
+    for (auto const &i : inputs)
+      {
+	output.push_back(ArrayType::Temporary(i.get().shape()));
+      }
+    BackwardBatch(inputs, errorSignal, output);
+    return output;
+  }
+
+  /*
+   * Batch versions of Forward / Backward, the first dimension of the inputs is the batch
+   * How the batch maps to the other inputs and to the output is specific to each op
+   */
+  virtual ArrayType ForwardBatch(std::vector<std::reference_wrapper<const ArrayType>> const &inputs, ArrayType &output) = 0;
+  virtual std::vector<ArrayType> &BackwardBatch(std::vector<std::reference_wrapper<const ArrayType>> const &inputs, ArrayType const &errorSignal, std::vector<ArrayType> &output) = 0;
 
   virtual std::array<SizeType, OUTPUT_RANK> ComputeOutputShape(std::vector<std::reference_wrapper<ArrayType const>> const &inputs) const = 0;
 
+  virtual std::array<SizeType, OUTPUT_RANK> ComputeBatchOutputShape(std::vector<std::reference_wrapper<ArrayType const>> const &inputs) const
+  {
+    return ComputeOutputShape(inputs);
+  }
+
   void SetTraining(bool is_training)
   {
     is_training_ = is_training;
@@ -79,17 +107,19 @@ public:
   using SizeType     = typename ArrayType::SizeType;
   using ArrayPtrType = std::shared_ptr<ArrayType>;
 
-  virtual ArrayType ForwardBatch(std::vector<std::reference_wrapper<const ArrayType>> const &inputs)
+  // Element wise ops don't care about the batch dimension
+  virtual ArrayType ForwardBatch(std::vector<std::reference_wrapper<const ArrayType>> const &inputs,
+				 ArrayType &                                                 output)
   {
-    ArrayType output({1});  // Temporary Dummy
     return this->Forward(inputs, output);
   }
 
-  virtual std::vector<ArrayType> BackwardBatch(
+  virtual std::vector<ArrayType> &BackwardBatch(
       std::vector<std::reference_wrapper<const ArrayType>> const &inputs,
-      ArrayType const &                                           errorSignal)
+      ArrayType const &                                           errorSignal,
+      std::vector<ArrayType>                                     &output)
   {
-    return {}; // this->Backward(inputs, errorSignal);
+    return this->Backward(inputs, errorSignal, output);
   }
 
   virtual std::array<SizeType, OUTPUT_RANK> ComputeOutputShape(
@@ -111,44 +141,13 @@ public:
   using SizeType     = typename ArrayType::SizeType;
   using ArrayPtrType = std::shared_ptr<ArrayType>;
 
-  // Overload that method for optimisation purposes
-  virtual ArrayType ForwardBatch(std::vector<std::reference_wrapper<const ArrayType>> const &inputs)
-  {
-    assert(inputs.size() == 1);
-    // std::vector<ArrayType> results;
-    // for (typename ArrayType::SizeType b(0); b < inputs.front().get().shape()[0]; ++b)
-    // {
-    //   ArrayType slice = inputs.front().get().Slice(b).Copy();
-    //   ArrayType output({1});  // Temporary Dummy
-    //   results.push_back(this->Forward({slice}, output));
-    // }
-    return inputs.front().get(); // ArrayType::Stack(results);
-  }
+  virtual ArrayType ForwardBatch(std::vector<std::reference_wrapper<const ArrayType>> const &inputs,
+				 ArrayType &                                                 output) = 0;
 
-  virtual std::vector<ArrayType> BackwardBatch(
+  virtual std::vector<ArrayType> &BackwardBatch(
       std::vector<std::reference_wrapper<const ArrayType>> const &inputs,
-      ArrayType const &                                           errorSignal)
-  {
-    return {}; // this->Backward(inputs, errorSignal);
-    // assert(inputs.size() == 1);
-    // assert(inputs.front().get().shape()[0] == errorSignal.shape()[0]);
-    // std::vector<std::vector<ArrayType>> results;
-    // for (typename ArrayType::SizeType b(0); b < inputs.front().get().shape()[0]; ++b)
-    // {
-    //   auto ret =
-    //       this->Backward({inputs.front().get().Slice(b).Tensor()}, errorSignal.Slice(b).Tensor());
-    //   for (std::size_t i(0); i < ret.size(); ++i)
-    //   {
-    //     results[i].push_back(ret[i]);
-    //   }
-    // }
-    // std::vector<ArrayType> concatenatedResults;
-    // for (auto const &tensorList : results)
-    // {
-    //   concatenatedResults.push_back(ArrayType::Stack(tensorList));
-    // }
-    // return concatenatedResults;
-  }
+      ArrayType const &                                           errorSignal,
+      std::vector<ArrayType>                                     &output) = 0;
 };
 
 }  // namespace ml
@@ -38,11 +38,11 @@ public:
   {
     (void)output;
     assert(inputs.empty());
-    assert(this->output_);
-    return *(this->output_);
+    assert(HasData());
+    return Data();
   }
 
-  virtual std::vector<ArrayType> Backward(
+  virtual std::vector<ArrayType> &Backward(
       std::vector<std::reference_wrapper<const ArrayType>> const &inputs,
       ArrayType const &                                           errorSignal,
       std::vector<ArrayType>                                     &output)
@@ -53,26 +53,83 @@ public:
 
   virtual bool SetData(ArrayType const &data)
   {
-    std::array<SizeType, OUTPUT_RANK> old_shape;
-    if (this->output_)
+    bool shape_changed = UpdateShape(data);
+    bound_ = nullptr;
+    // Reuses the Tensor object when nobody else holds it, so feeding a new sample doesn't allocate
+    if (this->output_ && this->output_.use_count() == 1)
     {
-      old_shape = this->output_->shape();
+      *this->output_ = data;
     }
-    this->output_ = std::make_shared<ArrayType>(data);
-    return old_shape != this->output_->shape();
+    else
+    {
+      this->output_ = std::make_shared<ArrayType>(data);
+    }
+    return shape_changed;
+  }
+
+  /*
+   * Makes the placeholder read data directly, without copying it or sharing its ownership, so
+   * feeding a sample doesn't allocate or touch any reference count. data must stay alive as long
+   * as the graph uses it, the caller can refill it in place between evaluations, and Unbind it
+   * before it goes away
+   * Meant for inputs : trainable ops keep working on the tensor given to SetData
+   * @return true if the shape changed
+   */
+  bool Bind(ArrayType const &data)
+  {
+    bool shape_changed = UpdateShape(data);
+    bound_ = &data;
+    return shape_changed;
+  }
+
+  // A temporary would be gone before the placeholder reads it
+  bool Bind(ArrayType &&) = delete;
+
+  /*
+   * Forgets the tensor given to Bind. Its shape is remembered, so binding another tensor of the
+   * same shape later still keeps the buffers of the graph
+   */
+  void Unbind()
+  {
+    bound_ = nullptr;
+  }
+
+  bool HasData() const
+  {
+    return bound_ || this->output_;
+  }
+
+  // The tensor given to Bind, or the one given to SetData
+  ArrayType const &Data() const
+  {
+    return bound_ ? *bound_ : *this->output_;
   }
 
   virtual std::array<SizeType, OUTPUT_RANK> ComputeOutputShape(
       std::vector<std::reference_wrapper<ArrayType const>> const &inputs) const
   {
     (void)inputs;
-    return this->output_->shape();
+    return Data().shape();
   }
 
   static constexpr char const *DESCRIPTOR = "PlaceHolder";
 
 protected:
   ArrayPtrType output_;
+
+private:
+  // Compares with the shape of the last data by value : a previously bound tensor may be gone
+  bool UpdateShape(ArrayType const &data)
+  {
+    bool shape_changed = !has_shape_ || shape_ != data.shape();
+    shape_     = data.shape();
+    has_shape_ = true;
+    return shape_changed;
+  }
+
+  ArrayType const *                 bound_ = nullptr;
+  std::array<SizeType, OUTPUT_RANK> shape_{};
+  bool                              has_shape_ = false;
 };
 
 }  // namespace ops
@@ -0,0 +1,357 @@
+#pragma once
+//------------------------------------------------------------------------------
+//
+//   Copyright 2018-2019 Fetch.AI Limited
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//------------------------------------------------------------------------------
+
+#include "state_dict.hpp"
+
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <list>
+#include <new>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace fetch {
+namespace ml {
+
+/**
+ * Data-parallel training on a single machine with several processes
+ * Each process trains its own copy of a model, and from time to time they all average their
+ * weights with StateDict::MergeList
+ * The copies are exchanged through an anonymous shared memory mapping, created before Fork()
+ * so every process inherits it : one slot per process holding all the weights of a StateDict
+ * The processes also share a counter of processed samples, to decay the learning rate globally
+ * @tparam T the ArrayType of the model
+ */
+template <class T>
+class SharedMemoryAverager
+{
+public:
+  using ArrayType = T;
+  using DataType  = typename ArrayType::Type;
+  using ShapeType = typename std::decay<decltype(std::declval<ArrayType const &>().shape())>::type;
+
+  /**
+   * @param model the weights to average, only their shapes are used here
+   * @param nb_processes number of processes that will take part in the averaging
+   */
+  SharedMemoryAverager(StateDict<ArrayType> const &model, unsigned int nb_processes)
+    : nb_processes_(nb_processes)
+  {
+    assert(nb_processes_ > 0);
+    Collect(model, shapes_);
+    for (auto const &shape : shapes_)
+      {
+	slot_capacity_ += AlignedCapacity(ArrayType(shape));
+      }
+    mapping_size_ = sizeof(Header) + nb_processes_ * slot_capacity_ * sizeof(DataType);
+    void *mapping = mmap(nullptr, mapping_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (mapping == MAP_FAILED)
+      {
+	throw std::runtime_error("SharedMemoryAverager : can't map shared memory");
+      }
+    header_ = new (mapping) Header();
+    data_   = reinterpret_cast<DataType *>(static_cast<char *>(mapping) + sizeof(Header));
+  }
+
+  SharedMemoryAverager(SharedMemoryAverager const &) = delete;
+  SharedMemoryAverager &operator=(SharedMemoryAverager const &) = delete;
+
+  ~SharedMemoryAverager()
+  {
+    munmap(header_, mapping_size_);
+  }
+
+  /**
+   * Starts the other processes, each one returns from Fork() with its own rank
+   * Rank 0 is the calling process
+   * @return the rank of the process, in [0, nb_processes)
+   */
+  unsigned int Fork()
+  {
+    parent_ = getpid();
+    for (unsigned int rank(1) ; rank < nb_processes_ ; ++rank)
+      {
+	pid_t pid = fork();
+	if (pid < 0)
+	  {
+	    throw std::runtime_error("SharedMemoryAverager : fork failed");
+	  }
+	if (pid == 0)
+	  {
+	    children_.clear();
+	    rank_ = rank;
+	    return rank_;
+	  }
+	children_.push_back(pid);
+      }
+    return rank_;
+  }
+
+  /**
+   * Rank 0 only : waits for all the other processes to exit
+   * @return true if they all exited normally
+   */
+  bool Join()
+  {
+    for (pid_t pid : children_)
+      {
+	int status(0);
+	waitpid(pid, &status, 0);
+	exit_status_.push_back(status);
+      }
+    children_.clear();
+    bool success = !header_->failed.load(std::memory_order_acquire);
+    for (int status : exit_status_)
+      {
+	success = success && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+      }
+    exit_status_.clear();
+    return success;
+  }
+
+  /**
+   * Replaces the weights of model by the average of the models of all the processes
+   * Blocks until every process called it, so they all have to call it the same number of times
+   * Throws if a process dies before getting there, instead of waiting for it forever
+   */
+  void Average(StateDict<ArrayType> &model)
+  {
+    std::vector<ArrayType> weights;
+    Collect(model, weights);
+    assert(weights.size() == shapes_.size());
+
+    std::vector<ArrayType> own_slot = Slot(rank_);
+    for (std::size_t i(0) ; i < weights.size() ; ++i)
+      {
+	CopyData(own_slot[i], weights[i]);
+      }
+    Barrier();
+
+    std::list<StateDict<ArrayType>> models;
+    for (unsigned int rank(0) ; rank < nb_processes_ ; ++rank)
+      {
+	models.push_back(ToStateDict(model, Slot(rank)));
+      }
+    StateDict<ArrayType> average = StateDict<ArrayType>::MergeList(models);
+    std::vector<ArrayType> averaged_weights;
+    Collect(average, averaged_weights);
+    for (std::size_t i(0) ; i < weights.size() ; ++i)
+      {
+	CopyData(weights[i], averaged_weights[i]);
+      }
+    // Nobody can write in its slot again before everybody is done reading them
+    Barrier();
+  }
+
+  /**
+   * Number of samples processed by all the processes together
+   */
+  std::atomic<uint64_t> &Processed()
+  {
+    return header_->processed;
+  }
+
+  unsigned int Rank() const
+  {
+    return rank_;
+  }
+
+  unsigned int NbProcesses() const
+  {
+    return nb_processes_;
+  }
+
+private:
+  // Lives at the beginning of the shared mapping, the atomics are lock-free so they work across processes
+  // Aligned like Tensor storage, so the slots that follow it start on an ALIGNMENT boundary
+  struct alignas(FETCH_TENSOR_ALIGNMENT) Header
+  {
+    std::atomic<uint64_t> processed{0};
+    std::atomic<uint64_t> arrived{0};
+    std::atomic<uint64_t> generation{0};
+    std::atomic<bool>     failed{false};  // A process died, every barrier fails from then on
+  };
+
+  /*
+   * Flattens the weights of a StateDict, always in the same order (depth first, by name)
+   */
+  static void Collect(StateDict<ArrayType> const &d, std::vector<ArrayType> &weights)
+  {
+    if (d.weights_)
+      {
+	weights.push_back(*d.weights_);
+      }
+    for (auto const &kvp : d.dict_)
+      {
+	Collect(kvp.second, weights);
+      }
+  }
+
+  static void Collect(StateDict<ArrayType> const &d, std::vector<ShapeType> &shapes)
+  {
+    std::vector<ArrayType> weights;
+    Collect(d, weights);
+    for (auto const &w : weights)
+      {
+	shapes.push_back(w.shape());
+      }
+  }
+
+  /*
+   * Rebuilds a StateDict with the structure of model on top of the given weights
+   */
+  static StateDict<ArrayType> ToStateDict(StateDict<ArrayType> const &model, std::vector<ArrayType> const &weights)
+  {
+    std::size_t i(0);
+    return ToStateDict(model, weights, i);
+  }
+
+  static StateDict<ArrayType> ToStateDict(StateDict<ArrayType> const &model, std::vector<ArrayType> const &weights, std::size_t &i)
+  {
+    StateDict<ArrayType> d;
+    if (model.weights_)
+      {
+	d.weights_ = std::make_shared<ArrayType>(weights[i++]);
+      }
+    for (auto const &kvp : model.dict_)
+      {
+	d.dict_.emplace(kvp.first, ToStateDict(kvp.second, weights, i));
+      }
+    return d;
+  }
+
+  /*
+   * Elements taken by a tensor in a slot, rounded up so the next one starts on an ALIGNMENT boundary
+   */
+  static uint64_t AlignedCapacity(ArrayType const &t)
+  {
+    uint64_t const alignment = ArrayType::DefaultAlignment;
+    return (t.Capacity() + alignment - 1) / alignment * alignment;
+  }
+
+  /*
+   * Tensors over the shared memory of a process
+   */
+  std::vector<ArrayType> Slot(unsigned int rank) const
+  {
+    std::vector<ArrayType> slot;
+    DataType *data = data_ + rank * slot_capacity_;
+    ShapeType default_layout;
+    default_layout.fill(uint64_t(-1));
+    for (auto const &shape : shapes_)
+      {
+	// The memory belongs to the mapping, the tensor must not free it
+	slot.emplace_back(shape, default_layout, default_layout, std::shared_ptr<DataType>(data, [](DataType *) {}));
+	data += AlignedCapacity(slot.back());
+      }
+    return slot;
+  }
+
+  /*
+   * Tensor::Copy goes through the iterators, tensors with the same layout can just be memcpy'd
+   */
+  static void CopyData(ArrayType &dst, ArrayType const &src)
+  {
+    if (dst.shape() == src.shape() && dst.Offset() == 0 && src.Offset() == 0 &&
+	dst.Strides() == src.Strides() && dst.Padding() == src.Padding())
+      {
+	std::memcpy(dst.Storage().get(), src.Storage().get(), src.Capacity() * sizeof(DataType));
+      }
+    else
+      {
+	dst.Copy(src);
+      }
+  }
+
+  /*
+   * Waits until all the processes reached it
+   * Sleeps rather than spins, as processes usually outnumber the free cores while training
+   * While waiting, rank 0 watches its children and the others their parent : a death is reported
+   * to everybody through the header, and makes the barrier throw
+   */
+  void Barrier()
+  {
+    uint64_t generation = header_->generation.load(std::memory_order_acquire);
+    if (header_->arrived.fetch_add(1, std::memory_order_acq_rel) + 1 == nb_processes_)
+      {
+	header_->arrived.store(0, std::memory_order_relaxed);
+	header_->generation.store(generation + 1, std::memory_order_release);
+	return;
+      }
+    while (header_->generation.load(std::memory_order_acquire) == generation)
+      {
+	// A child can exit as soon as the barrier is released, check it wasn't before failing
+	if ((header_->failed.load(std::memory_order_acquire) || PeerDied()) &&
+	    header_->generation.load(std::memory_order_acquire) == generation)
+	  {
+	    header_->failed.store(true, std::memory_order_release);
+	    throw std::runtime_error("SharedMemoryAverager : a training process died");
+	  }
+	std::this_thread::sleep_for(std::chrono::microseconds(100));
+      }
+  }
+
+  /*
+   * Rank 0 : reaps a child that exited, keeping its status for Join
+   * Other ranks : checks the parent is still there, they get reparented when it dies
+   */
+  bool PeerDied()
+  {
+    if (rank_ != 0)
+      {
+	return getppid() != parent_;
+      }
+    for (auto it = children_.begin() ; it != children_.end() ; ++it)
+      {
+	int status(0);
+	if (waitpid(*it, &status, WNOHANG) == *it)
+	  {
+	    exit_status_.push_back(status);
+	    children_.erase(it);
+	    return true;
+	  }
+      }
+    return false;
+  }
+
+  unsigned int                                    nb_processes_;
+  unsigned int                                    rank_          = 0;
+  std::vector<pid_t>                              children_;     // Rank 0 only
+  std::vector<int>                                exit_status_;  // Rank 0 only, children reaped while waiting
+  pid_t                                           parent_        = 0;
+  std::vector<ShapeType>          shapes_;
+  uint64_t                                        slot_capacity_ = 0; // Elements per process
+  std::size_t                                     mapping_size_  = 0;
+  Header                                         *header_        = nullptr;
+  DataType                                       *data_          = nullptr;
+};
+
+}  // namespace ml
+}  // namespace fetch
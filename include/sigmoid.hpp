@@ -23,6 +23,21 @@ namespace fetch {
 namespace ml {
 namespace ops {
 
+/*
+ * Gradient of a sigmoid : output = s(x)(1 - s(x)) * errorSignal, where sigmoid(x) gives s(x),
+ * evaluated as a single expression (see tensor_expression.hpp), without temporaries
+ */
+template <class ArrayType, class F>
+void SigmoidBackward(ArrayType const &input, ArrayType const &errorSignal, ArrayType &output, F const &sigmoid)
+{
+  using DataType = typename ArrayType::Type;
+  auto gradient = [&sigmoid](DataType x) {
+    DataType s = sigmoid(x);
+    return DataType(s * (DataType(1) - s));
+  };
+  output.Assign(fetch::math::Map(gradient, input) * errorSignal);
+}
+
 template <class T>
 class Sigmoid : public fetch::ml::ElementWiseOps<T, 2>
 {
@@ -54,21 +69,17 @@ public:
     return output;
   }
 
-  virtual std::vector<ArrayType> Backward(
+  virtual std::vector<ArrayType> &Backward(
       std::vector<std::reference_wrapper<const ArrayType>> const &inputs,
       ArrayType const &                                           errorSignal,
       std::vector<ArrayType>                                     &output)
   {
     assert(inputs.size() == 1 && output.size() == 1);
     assert(inputs.front().get().shape() == errorSignal.shape());
-    ArrayType t{inputs.front().get().shape()};
 
     // gradient of sigmoid function is s(x)(1 - s(x))
-    this->Forward(inputs, t);
-    output[0].Fill(1);
-    output[0].InlineSubtract(t);
-    output[0].InlineMultiply(t);
-    output[0].InlineMultiply(errorSignal);
+    SigmoidBackward(inputs.front().get(), errorSignal, output[0],
+                    [](DataType x) { return DataType(1 / (1 + std::exp(x * -1))); });
     return output;
   }
 
@@ -0,0 +1,98 @@
+#pragma once
+//------------------------------------------------------------------------------
+//
+//   Copyright 2018-2019 Fetch.AI Limited
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace fetch {
+namespace math {
+
+/*
+ * Precomputed sigmoid, as in the original word2vec expTable
+ * Inputs in [-clamp, clamp] are mapped to one of size buckets (4KB with the defaults, so it stays
+ * in L1), inputs outside that range saturate to 0 or 1
+ */
+template <typename T>
+class SigmoidTable
+{
+public:
+  using SizeType = std::uint64_t;
+
+  explicit SigmoidTable(SizeType size = 1000, T clamp = T(6))
+    : clamp_(clamp)
+    , scale_(T(size) / (T(2) * clamp))
+    , max_index_(T(size + 1))
+    , table_(size + 2)
+  {
+    assert(size > 0 && clamp > 0);
+    // First and last entries hold the saturated values, so the lookup needs no branch
+    table_.front() = T(0);
+    table_.back()  = T(1);
+    for (SizeType i(0) ; i < size ; ++i)
+      {
+	// Value at the center of each bucket
+	double x = ((double(i) + 0.5) / double(size) * 2.0 - 1.0) * double(clamp);
+	table_[i + 1] = T(1.0 / (1.0 + std::exp(-x)));
+      }
+  }
+
+  T operator()(T x) const
+  {
+    T index = (x + clamp_) * scale_ + T(1);
+    // Written so that a NaN fails the comparison and maps to 0 instead of reaching the cast
+    index = index > T(0) ? std::min(index, max_index_) : T(0);
+    // Going through a signed 32 bits int, float to uint64 conversions are slow on x86
+    return table_[static_cast<std::int32_t>(index)];
+  }
+
+  SizeType Size() const
+  {
+    return table_.size() - 2;
+  }
+
+  T Clamp() const
+  {
+    return clamp_;
+  }
+
+private:
+  T              clamp_;
+  T              scale_;
+  T              max_index_;
+  std::vector<T> table_;
+};
+
+/*
+ * Exact sigmoid, or its tabulated approximation when a table is given
+ */
+template <typename T>
+T Sigmoid(T x, SigmoidTable<T> const *table = nullptr)
+{
+  if (table)
+    {
+      return (*table)(x);
+    }
+  return T(1) / (T(1) + std::exp(-x));
+}
+
+}  // namespace math
+}  // namespace fetch
@@ -0,0 +1,94 @@
+#pragma once
+//------------------------------------------------------------------------------
+//
+//   Copyright 2018-2019 Fetch.AI Limited
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//------------------------------------------------------------------------------
+
+#include "fused_trainer.hpp"
+
+#include <vector>
+
+namespace fetch {
+namespace ml {
+
+/*
+ * Specialised Skip-gram + negative sampling training step
+ * One step processes all the (center, context) pairs of a window : the center row is loaded once,
+ * its error is accumulated over all pairs and applied once at the end of the window
+ * Step takes center [1 x 1], the index of the center word, and targets [P x K], one row per
+ * context word : the context word followed by negative samples, rows starting with a negative
+ * value are ignored
+ */
+template <typename T>
+class SkipGramNegativeSamplingTrainer : public FusedTrainer<SkipGramNegativeSamplingTrainer<T>, T>
+{
+public:
+  using BaseType  = FusedTrainer<SkipGramNegativeSamplingTrainer<T>, T>;
+  using ArrayType = typename BaseType::ArrayType;
+  using DataType  = T;
+  using SizeType  = typename ArrayType::SizeType;
+
+  SkipGramNegativeSamplingTrainer(ArrayType &words, ArrayType &weights)
+    : BaseType(words, weights)
+    , hidden_error_(this->dimensions_)
+  {}
+
+private:
+  friend BaseType;
+
+  template <typename Row>
+  void Run(Row, ArrayType const &center, ArrayType const &targets, DataType learning_rate)
+  {
+    SizeType const dimensions = this->dimensions_;
+    SizeType const nb_targets = targets.shape()[1];
+    errors_.resize(nb_targets);
+
+    DataType *hidden = this->WordRow(SizeType(center.Get(0, 0)));
+    Row::Fill(hidden_error_.data(), DataType(0), dimensions);
+    for (SizeType p(0) ; p < targets.shape()[0] ; ++p)
+      {
+	if (targets.Get(p, 0) < 0)
+	  {
+	    continue;
+	  }
+
+	// Dot product, sigmoid and error for each target of the pair
+	for (SizeType k(0) ; k < nb_targets ; ++k)
+	  {
+	    DataType const *row = this->WeightsRow(SizeType(targets.Get(p, k)));
+	    DataType dot = Row::Dot(hidden, row, dimensions);
+	    DataType label = (k == 0) ? DataType(1) : DataType(0);
+	    errors_[k] = label - this->Sigmoid(dot);
+	    Row::Axpy(hidden_error_.data(), row, errors_[k], dimensions);
+	  }
+
+	// Update output weights
+	for (SizeType k(0) ; k < nb_targets ; ++k)
+	  {
+	    Row::Axpy(this->WeightsRow(SizeType(targets.Get(p, k))), hidden, errors_[k] * learning_rate, dimensions);
+	  }
+      }
+
+    // The center word is updated once for the whole window
+    Row::Axpy(hidden, hidden_error_.data(), learning_rate, dimensions);
+  }
+
+  std::vector<DataType> hidden_error_;
+  std::vector<DataType> errors_;
+};
+
+}  // namespace ml
+}  // namespace fetch
@@ -0,0 +1,74 @@
+#pragma once
+//------------------------------------------------------------------------------
+//
+//   Copyright 2018-2019 Fetch.AI Limited
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//------------------------------------------------------------------------------
+
+#include <cassert>
+#include <cstdint>
+
+namespace fetch {
+namespace math {
+
+/*
+ * Non owning view of n contiguous elements, for code that wants to work on a raw T * + length
+ * instead of going through the tensor iterators
+ */
+template <typename T>
+class Span
+{
+public:
+  using SizeType = std::uint64_t;
+
+  Span(T *data, SizeType size)
+    : data_(data)
+    , size_(size)
+  {}
+
+  T *data() const
+  {
+    return data_;
+  }
+
+  SizeType size() const
+  {
+    return size_;
+  }
+
+  T &operator[](SizeType i) const
+  {
+    assert(i < size_);
+    return data_[i];
+  }
+
+  // Lowercase for range based loops
+  T *begin() const
+  {
+    return data_;
+  }
+
+  T *end() const
+  {
+    return data_ + size_;
+  }
+
+private:
+  T       *data_;
+  SizeType size_;
+};
+
+}  // namespace math
+}  // namespace fetch
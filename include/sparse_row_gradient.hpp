@@ -0,0 +1,141 @@
+#pragma once
+//------------------------------------------------------------------------------
+//
+//   Copyright 2018-2019 Fetch.AI Limited
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//------------------------------------------------------------------------------
+
+#include "tensor.hpp"
+#include "touched_rows.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
+namespace fetch {
+namespace ml {
+
+/**
+ * Gradient of a matrix where only a few rows are non zero, like the embeddings of the words
+ * seen since the last step
+ * Only the touched rows are stored, packed one after the other in a pooled buffer that keeps its
+ * memory between steps, so the memory used is O(rows touched per step) instead of a second
+ * VocabSize x Dim matrix
+ * @tparam T ArrayType of the matrix
+ */
+template <class T>
+class SparseRowGradient
+{
+public:
+  using ArrayType = T;
+  using DataType  = typename ArrayType::Type;
+  using SizeType  = typename ArrayType::SizeType;
+
+  /**
+   * Adds gradient to the row of the matrix
+   */
+  void Add(SizeType row, fetch::math::TensorView<DataType const, 1> const &gradient)
+  {
+    assert(dimension_ == 0 || dimension_ == gradient.Size());
+    dimension_ = gradient.Size();
+    auto slot  = rows_.Insert(row);
+    DataType *values = Values(slot.first);
+    if (slot.second)
+      {
+	// First time this row is touched : the slot still holds the values of a previous step
+	std::fill_n(values, dimension_, DataType(0));
+      }
+    // Not dense for a slice of a transposed error signal
+    DataType const *g = gradient.data();
+    SizeType const stride = gradient.strides()[0];
+    for (SizeType i(0) ; i < dimension_ ; ++i)
+      {
+	values[i] += g[i * stride];
+      }
+  }
+
+  /**
+   * weights[row] += learning_rate * gradient[row] for all the touched rows, then forgets them
+   * Rows are visited in the order they were first touched, which walks the pool sequentially
+   * Each row is only updated once, so the result doesn't depend on that order
+   */
+  void Apply(ArrayType &weights, DataType learning_rate)
+  {
+    assert(rows_.Empty() || (weights.IsDense() && weights.RowSize() == dimension_));
+    std::vector<SizeType> const &rows = rows_.Rows();
+    for (SizeType slot(0) ; slot < rows.size() ; ++slot)
+      {
+	DataType const *values = Values(slot);
+	DataType *w = weights.RowPointer(rows[slot]);
+	for (SizeType i(0) ; i < dimension_ ; ++i)
+	  {
+	    w[i] += values[i] * learning_rate;
+	  }
+      }
+    Clear();
+  }
+
+  void Clear()
+  {
+    rows_.Clear();
+  }
+
+  /**
+   * Number of rows touched since the last Apply / Clear
+   */
+  SizeType NbRows() const
+  {
+    return rows_.Size();
+  }
+
+  /**
+   * Accumulated gradient of row, nullptr if it wasn't touched
+   */
+  DataType const *Row(SizeType row) const
+  {
+    SizeType slot = rows_.Find(row);
+    return slot == rows_.Size() ? nullptr : Values(slot);
+  }
+
+  /**
+   * Floats held by the pool, which only grows to the largest number of rows touched in a step
+   */
+  SizeType PoolSize() const
+  {
+    return pool_.size();
+  }
+
+private:
+  DataType *Values(SizeType slot)
+  {
+    if (pool_.size() < (slot + 1) * dimension_)
+      {
+	pool_.resize((slot + 1) * dimension_);
+      }
+    return pool_.data() + slot * dimension_;
+  }
+
+  DataType const *Values(SizeType slot) const
+  {
+    return pool_.data() + slot * dimension_;
+  }
+
+  SizeType                     dimension_ = 0;
+  TouchedRows                  rows_;      // Row of the matrix -> slot in the pool
+  std::vector<DataType>        pool_;      // Gradients of the touched rows, dimension_ values per slot
+};
+
+}  // namespace ml
+}  // namespace fetch
@@ -0,0 +1,188 @@
+#pragma once
+//------------------------------------------------------------------------------
+//
+//   Copyright 2018-2019 Fetch.AI Limited
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//------------------------------------------------------------------------------
+
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace fetch {
+namespace ml {
+
+/*
+ * Lock-free single producer / single consumer ring buffer of preallocated items
+ * Items are never copied : the producer fills a slot in place (BeginPush / EndPush) and the
+ * consumer reads it in place (BeginPop / EndPop), so large samples can be handed over for free
+ * A full ring makes the producer wait (backpressure), an empty one makes the consumer wait
+ * Both sides count how many times, and for how long, they had to wait
+ */
+template <typename T>
+class SPSCRingBuffer
+{
+public:
+  /*
+   * @param capacity number of slots, rounded up to a power of 2
+   * @param make called once per slot to allocate the items
+   */
+  template <typename Factory>
+  SPSCRingBuffer(std::size_t capacity, Factory make)
+  {
+    std::size_t size(1);
+    while (size < capacity)
+      {
+	size <<= 1;
+      }
+    mask_ = size - 1;
+    slots_.reserve(size);
+    for (std::size_t i(0) ; i < size ; ++i)
+      {
+	slots_.push_back(make());
+      }
+  }
+
+  SPSCRingBuffer(SPSCRingBuffer const &) = delete;
+  SPSCRingBuffer &operator=(SPSCRingBuffer const &) = delete;
+
+  /*
+   * Producer side : slot to fill, waits while the ring is full
+   * Returns nullptr if the ring was closed
+   */
+  T *BeginPush()
+  {
+    uint64_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail - head_.load(std::memory_order_acquire) > mask_)
+      {
+	producer_waits_.fetch_add(1, std::memory_order_relaxed);
+	producer_wait_ns_.fetch_add(Wait([&]() { return tail - head_.load(std::memory_order_acquire) > mask_; }), std::memory_order_relaxed);
+      }
+    if (closed_.load(std::memory_order_acquire))
+      {
+	return nullptr;
+      }
+    return &slots_[tail & mask_];
+  }
+
+  void EndPush()
+  {
+    tail_.store(tail_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+  }
+
+  /*
+   * Consumer side : next slot to read, waits while the ring is empty
+   * Returns nullptr once the ring is closed and all the items were consumed
+   */
+  T *BeginPop()
+  {
+    uint64_t head = head_.load(std::memory_order_relaxed);
+    if (head == tail_.load(std::memory_order_acquire))
+      {
+	consumer_waits_.fetch_add(1, std::memory_order_relaxed);
+	consumer_wait_ns_.fetch_add(Wait([&]() { return head == tail_.load(std::memory_order_acquire); }), std::memory_order_relaxed);
+	if (head == tail_.load(std::memory_order_acquire))
+	  {
+	    return nullptr; // Closed and empty
+	  }
+      }
+    return &slots_[head & mask_];
+  }
+
+  void EndPop()
+  {
+    head_.store(head_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+  }
+
+  /*
+   * No more items will be pushed (or, from the consumer, no more will be read)
+   * Unblocks the other side
+   */
+  void Close()
+  {
+    closed_.store(true, std::memory_order_release);
+  }
+
+  std::size_t Capacity() const
+  {
+    return mask_ + 1;
+  }
+
+  // Number of times the producer found the ring full
+  uint64_t ProducerWaits() const
+  {
+    return producer_waits_.load(std::memory_order_relaxed);
+  }
+
+  // Number of times the consumer found the ring empty
+  uint64_t ConsumerWaits() const
+  {
+    return consumer_waits_.load(std::memory_order_relaxed);
+  }
+
+  double ProducerWaitSeconds() const
+  {
+    return double(producer_wait_ns_.load(std::memory_order_relaxed)) * 1e-9;
+  }
+
+  double ConsumerWaitSeconds() const
+  {
+    return double(consumer_wait_ns_.load(std::memory_order_relaxed)) * 1e-9;
+  }
+
+private:
+  /*
+   * Wait until blocked() is false or the ring is closed, returns the time spent in nanoseconds
+   * Starts by yielding, then backs off to short sleeps so that a waiting thread doesn't steal
+   * the CPU from the other side when there are more threads than cores
+   */
+  template <typename Blocked>
+  uint64_t Wait(Blocked const &blocked)
+  {
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned int attempt(0) ; blocked() && !closed_.load(std::memory_order_acquire) ; ++attempt)
+      {
+	if (attempt < 16)
+	  {
+	    std::this_thread::yield();
+	  }
+	else
+	  {
+	    std::this_thread::sleep_for(std::chrono::microseconds(50));
+	  }
+      }
+    return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+  }
+
+  // Indexes only ever grow, slot = index & mask_
+  // Each one lives on its own cache line so the two threads don't invalidate each other's
+  std::atomic<uint64_t> head_{0};
+  char                  head_padding_[64 - sizeof(std::atomic<uint64_t>)];
+  std::atomic<uint64_t> tail_{0};
+  char                  tail_padding_[64 - sizeof(std::atomic<uint64_t>)];
+  std::atomic<bool>     closed_{false};
+  std::atomic<uint64_t> producer_waits_{0};
+  std::atomic<uint64_t> producer_wait_ns_{0};
+  std::atomic<uint64_t> consumer_waits_{0};
+  std::atomic<uint64_t> consumer_wait_ns_{0};
+  std::size_t           mask_;
+  std::vector<T>        slots_;
+};
+
+}  // namespace ml
+}  // namespace fetch
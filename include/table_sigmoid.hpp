@@ -0,0 +1,90 @@
+#pragma once
+//------------------------------------------------------------------------------
+//
+//   Copyright 2018-2019 Fetch.AI Limited
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//------------------------------------------------------------------------------
+
+#include "sigmoid.hpp"
+#include "sigmoid_table.hpp"
+
+namespace fetch {
+namespace ml {
+namespace ops {
+
+/*
+ * Sigmoid using a precomputed lookup table instead of std::exp
+ * Values are approximated inside [-clamp, clamp] and saturate to 0 or 1 outside of it
+ */
+template <class T>
+class TableSigmoid : public fetch::ml::ElementWiseOps<T, 2>
+{
+public:
+  using ArrayType    = T;
+  using DataType     = typename ArrayType::Type;
+  using SizeType     = typename ArrayType::SizeType;
+  using ArrayPtrType = std::shared_ptr<ArrayType>;
+
+  TableSigmoid(SizeType table_size = 1000, DataType clamp = DataType(6))
+    : table_(table_size, clamp)
+  {}
+
+  virtual ~TableSigmoid() = default;
+
+  virtual ArrayType Forward(std::vector<std::reference_wrapper<ArrayType const>> const &inputs,
+                            ArrayType &                                                 output)
+  {
+    assert(inputs.size() == 1);
+    assert(output.shape() == this->ComputeOutputShape(inputs));
+
+    auto input_it = inputs.at(0).get().begin();
+    auto input_end = inputs.at(0).get().end();
+    auto output_it = output.begin();
+
+    while (input_it != input_end)
+      {
+	*output_it = table_(*input_it);
+	++input_it;
+	++output_it;
+      }
+    return output;
+  }
+
+  virtual std::vector<ArrayType> &Backward(
+      std::vector<std::reference_wrapper<const ArrayType>> const &inputs,
+      ArrayType const &                                           errorSignal,
+      std::vector<ArrayType>                                     &output)
+  {
+    assert(inputs.size() == 1 && output.size() == 1);
+    assert(inputs.front().get().shape() == errorSignal.shape());
+
+    SigmoidBackward(inputs.front().get(), errorSignal, output[0], table_);
+    return output;
+  }
+
+  fetch::math::SigmoidTable<DataType> const &Table() const
+  {
+    return table_;
+  }
+
+  static constexpr char const *DESCRIPTOR = "TableSigmoid";
+
+private:
+  fetch::math::SigmoidTable<DataType> table_;
+};
+
+}  // namespace ops
+}  // namespace ml
+}  // namespace fetch
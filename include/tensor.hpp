@@ -19,6 +19,7 @@
 
 #include <cassert>
 #include <cstdint>
+#include <algorithm>
 #include <array>
 #include <iostream>
 #include <iomanip>
@@ -36,7 +37,12 @@ namespace math {
 }
 }
 
+#include "span.hpp"
+#include "tensor_arena.hpp"
+#include "tensor_expression.hpp"
 #include "tensor_iterator.hpp"
+#include "tensor_view.hpp"
+#include "vector_kernels.hpp"
 
 namespace fetch {
 namespace math {
@@ -48,7 +54,12 @@ public:
   using Type                             = T;
   using SizeType                         = std::uint64_t;
   using SelfType                         = Tensor<T, RANK>;
-  static const SizeType DefaultAlignment = 8;  // Arbitrary picked
+  // Storage starts on an ALIGNMENT boundary and, unless a padding is given, rows are padded to
+  // a multiple of ALIGNMENT bytes : every row of an embedding matrix starts on its own cache line
+  static const SizeType ALIGNMENT        = FETCH_TENSOR_ALIGNMENT;
+  static const SizeType DefaultAlignment = ALIGNMENT > sizeof(T) ? ALIGNMENT / sizeof(T) : 1;  // in elements
+
+  static_assert((ALIGNMENT & (ALIGNMENT - 1)) == 0, "Tensor alignment must be a power of 2");
 
   friend class Tensor<T, RANK+1>; // let's us access private member of slice (Tensor<T, RANK-1>)
   
@@ -56,7 +67,8 @@ public:
   Tensor(std::array<SizeType, RANK>           shape,
          std::array<SizeType, RANK>           strides = std::array<SizeType, RANK>{{SizeType(-1)}},
 	 std::array<SizeType, RANK>           padding = std::array<SizeType, RANK>{{SizeType(-1)}},
-         std::shared_ptr<T>              storage = nullptr, SizeType offset = 0)
+         std::shared_ptr<T>              storage = nullptr, SizeType offset = 0,
+	 TensorArena                    *arena = nullptr)
     : storage_(std::move(storage))
     , offset_(offset)
   {
@@ -99,13 +111,48 @@ public:
 	  offset_ = 0;
 	  if (!shape_.empty())
 	    {
-	      storage_ = std::shared_ptr<T>(new T[Capacity()], std::default_delete<T[]>());
-	      memset(static_cast<void*>(storage_.get()), 0, Capacity() * sizeof(T));
+	      storage_ = arena ? Allocate(Capacity(), *arena) : Allocate(Capacity());
 	    }
 	}
       size_ = std::accumulate(shape_.begin(), shape_.end(), SizeType(1), std::multiplies<SizeType>());
   }
 
+  // Default layout, storage taken from arena : the tensor must not be used after arena's next Reset
+  Tensor(std::array<SizeType, RANK> shape, TensorArena &arena)
+    : Tensor(shape, std::array<SizeType, RANK>{{SizeType(-1)}}, std::array<SizeType, RANK>{{SizeType(-1)}}, nullptr, 0, &arena)
+  {}
+
+  /*
+   * Tensor for a temporary result, from the arena of the current TensorArena::Scope if any,
+   * from the heap otherwise
+   */
+  static SelfType Temporary(std::array<SizeType, RANK> shape)
+  {
+    TensorArena *arena = TensorArena::Current();
+    return arena ? SelfType(shape, *arena) : SelfType(shape);
+  }
+
+  /*
+   * n zeroed elements starting on an ALIGNMENT boundary
+   */
+  static std::shared_ptr<T> Allocate(SizeType n)
+  {
+    unsigned char *block = new unsigned char[n * sizeof(T) + ALIGNMENT];
+    std::uintptr_t address = reinterpret_cast<std::uintptr_t>(block);
+    T *data = reinterpret_cast<T *>(block + (ALIGNMENT - address % ALIGNMENT) % ALIGNMENT);
+    memset(static_cast<void*>(data), 0, n * sizeof(T));
+    return std::shared_ptr<T>(data, [block](T *) { delete[] block; });
+  }
+
+  // Same from an arena, the shared_ptr control block included
+  static std::shared_ptr<T> Allocate(SizeType n, TensorArena &arena)
+  {
+    static_assert(TensorArena::ALIGNMENT % ALIGNMENT == 0, "TensorArena is less aligned than Tensor storage");
+    T *data = static_cast<T *>(arena.Allocate(n * sizeof(T)));
+    memset(static_cast<void*>(data), 0, n * sizeof(T));
+    return std::shared_ptr<T>(data, [](T *) {}, ArenaAllocator<T>(arena));
+  }
+
   Tensor(Tensor const &t)     = default;
   Tensor(Tensor &&t) noexcept = default;
   Tensor &operator=(Tensor const &other) = default;
@@ -131,6 +178,10 @@ public:
   Tensor &Copy(SelfType const &o)
   {
     assert(Size() == o.Size());
+    if (ApplyRows(o, [](T *dst, T const *src, SizeType n) { std::copy_n(src, n, dst); }))
+      {
+	return *this;
+      }
     auto it1 = this->begin();
     auto end = this->end();
     auto it2 = o.begin();
@@ -186,6 +237,10 @@ public:
 
   void Fill(T const &value)
   {
+    if (ApplyRows([&value](T *dst, SizeType n) { std::fill_n(dst, n, value); }))
+      {
+	return;
+      }
     for (T &e : *this)
     {
       e = value;
@@ -286,13 +341,141 @@ public:
     return ret;
   }
 
+  /*
+   * Non owning views (see TensorView), they don't touch the reference count of the storage
+   * SliceView(i) is the view equivalent of Slice(i)
+   */
+  TensorView<T, RANK> View()
+  {
+    return TensorView<T, RANK>(storage_.get() + offset_, shape_, strides_);
+  }
+
+  TensorView<T const, RANK> View() const
+  {
+    return TensorView<T const, RANK>(storage_.get() + offset_, shape_, strides_);
+  }
+
+  TensorView<T, RANK-1> SliceView(SizeType i)
+  {
+    return View().Slice(i);
+  }
+
+  TensorView<T const, RANK-1> SliceView(SizeType i) const
+  {
+    return View().Slice(i);
+  }
+
   std::shared_ptr<T> Storage() const
   {
     return storage_;
   }
 
+  //////////////////
+  /// RAW ACCESS ///
+  //////////////////
+
+  /*
+   * A tensor is dense when the elements of its last dimension are contiguous in memory, with
+   * padding only at the end of the rows. Everything but transposed views is
+   * Dense tensors can be worked on one row at a time through raw pointers, which is what the
+   * element-wise operations do
+   */
+  bool IsDense() const
+  {
+    return strides_[RANK - 1] == 1;
+  }
+
+  /*
+   * Dense and without any padding between the rows : all the elements form a single Span
+   */
+  bool IsContiguous() const
+  {
+    if (!IsDense())
+      {
+	return false;
+      }
+    for (SizeType d(RANK - 1) ; d-- > 0 ; )
+      {
+	if (shape_[d] > 1 && strides_[d] != strides_[d + 1] * shape_[d + 1])
+	  {
+	    return false;
+	  }
+      }
+    return true;
+  }
+
+  // Number of rows (runs along the last dimension), numbered in iteration order
+  SizeType NbRows() const
+  {
+    return shape_[RANK - 1] ? size_ / shape_[RANK - 1] : 0;
+  }
+
+  SizeType RowSize() const
+  {
+    return shape_[RANK - 1];
+  }
+
+  // Position in the storage of the first element of a row
+  SizeType RowOffset(SizeType row) const
+  {
+    SizeType offset = offset_;
+    for (SizeType d(RANK - 1) ; d-- > 0 ; )
+      {
+	offset += (row % shape_[d]) * strides_[d];
+	row /= shape_[d];
+      }
+    return offset;
+  }
+
+  /*
+   * First element of a row, the next RowSize() - 1 follow it if the tensor IsDense()
+   */
+  T *RowPointer(SizeType row)
+  {
+    assert(row < NbRows());
+    return storage_.get() + RowOffset(row);
+  }
+
+  T const *RowPointer(SizeType row) const
+  {
+    assert(row < NbRows());
+    return storage_.get() + RowOffset(row);
+  }
+
+  Span<T> RowSpan(SizeType row)
+  {
+    assert(IsDense());
+    return Span<T>(RowPointer(row), RowSize());
+  }
+
+  Span<T const> RowSpan(SizeType row) const
+  {
+    assert(IsDense());
+    return Span<T const>(RowPointer(row), RowSize());
+  }
+
+  /*
+   * All the elements, the tensor must be IsContiguous()
+   */
+  Span<T> AsSpan()
+  {
+    assert(IsContiguous());
+    return Span<T>(storage_.get() + offset_, size_);
+  }
+
+  Span<T const> AsSpan() const
+  {
+    assert(IsContiguous());
+    return Span<T const>(storage_.get() + offset_, size_);
+  }
+
   SelfType &InlineAdd(T const &o)
   {
+    auto kernel = fetch::math::kernels::Kernels<T>().add_scalar;
+    if (ApplyRows([kernel, &o](T *dst, SizeType n) { kernel(dst, o, n); }))
+      {
+	return *this;
+      }
     for (T &e : *this)
     {
       e += o;
@@ -303,6 +486,11 @@ public:
   SelfType &InlineAdd(Tensor<T, RANK> const &o, T alpha = T(1.0f))
   {
     assert(Size() == o.Size());
+    auto kernel = fetch::math::kernels::Kernels<T>().add;
+    if (ApplyRows(o, [kernel, &alpha](T *dst, T const *src, SizeType n) { kernel(dst, src, alpha, n); }))
+      {
+	return *this;
+      }
     auto it1 = this->begin();
     auto end = this->end();
     auto it2 = o.begin();
@@ -319,6 +507,11 @@ public:
 
   SelfType &InlineSubtract(T const &o)
   {
+    auto kernel = fetch::math::kernels::Kernels<T>().subtract_scalar;
+    if (ApplyRows([kernel, &o](T *dst, SizeType n) { kernel(dst, o, n); }))
+      {
+	return *this;
+      }
     for (T &e : *this)
     {
       e -= o;
@@ -329,6 +522,11 @@ public:
   SelfType &InlineSubtract(Tensor<T, RANK> const &o)
   {
     assert(Size() == o.Size());
+    auto kernel = fetch::math::kernels::Kernels<T>().subtract;
+    if (ApplyRows(o, kernel))
+      {
+	return *this;
+      }
     auto it1 = this->begin();
     auto end = this->end();
     auto it2 = o.begin();
@@ -344,6 +542,11 @@ public:
 
   SelfType &InlineMultiply(T const &o)
   {
+    auto kernel = fetch::math::kernels::Kernels<T>().multiply_scalar;
+    if (ApplyRows([kernel, &o](T *dst, SizeType n) { kernel(dst, o, n); }))
+      {
+	return *this;
+      }
     for (T &e : *this)
     {
       e *= o;
@@ -354,6 +557,11 @@ public:
   SelfType &InlineMultiply(Tensor<T, RANK> const &o)
   {
     assert(Size() == o.Size());
+    auto kernel = fetch::math::kernels::Kernels<T>().multiply;
+    if (ApplyRows(o, kernel))
+      {
+	return *this;
+      }
     auto it1 = this->begin();
     auto end = this->end();
     auto it2 = o.begin();
@@ -369,6 +577,11 @@ public:
 
   SelfType &InlineDivide(T const &o)
   {
+    auto kernel = fetch::math::kernels::Kernels<T>().divide_scalar;
+    if (ApplyRows([kernel, &o](T *dst, SizeType n) { kernel(dst, o, n); }))
+      {
+	return *this;
+      }
     for (T &e : *this)
     {
       e /= o;
@@ -379,6 +592,11 @@ public:
   SelfType &InlineDivide(Tensor<T, RANK> const &o)
   {
     assert(Size() == o.Size());
+    auto kernel = fetch::math::kernels::Kernels<T>().divide;
+    if (ApplyRows(o, kernel))
+      {
+	return *this;
+      }
     auto it1 = this->begin();
     auto end = this->end();
     auto it2 = o.begin();
@@ -392,8 +610,66 @@ public:
     return *this;
   }
 
+  ///////////////////
+  /// EXPRESSIONS ///
+  ///////////////////
+
+  /*
+   * Evaluates an element-wise expression (see tensor_expression.hpp) into this tensor, in a single
+   * pass and without temporaries : error.Assign(ground_truth - prediction)
+   * Unlike operator=, which shares the storage of another tensor, this writes in place
+   */
+  template <typename E>
+  SelfType &Assign(E const &e)
+  {
+    Evaluate(expression::AsNode(e), [](T &dst, T value) { dst = value; });
+    return *this;
+  }
+
+  template <typename E, typename = typename std::enable_if<expression::IsNode<E>::value || std::is_arithmetic<E>::value>::type>
+  SelfType &operator+=(E const &e)
+  {
+    Evaluate(AsOperand(e), [](T &dst, T value) { dst += value; });
+    return *this;
+  }
+
+  template <typename E, typename = typename std::enable_if<expression::IsNode<E>::value || std::is_arithmetic<E>::value>::type>
+  SelfType &operator-=(E const &e)
+  {
+    Evaluate(AsOperand(e), [](T &dst, T value) { dst -= value; });
+    return *this;
+  }
+
+  template <typename E, typename = typename std::enable_if<expression::IsNode<E>::value || std::is_arithmetic<E>::value>::type>
+  SelfType &operator*=(E const &e)
+  {
+    Evaluate(AsOperand(e), [](T &dst, T value) { dst *= value; });
+    return *this;
+  }
+
+  template <typename E, typename = typename std::enable_if<expression::IsNode<E>::value || std::is_arithmetic<E>::value>::type>
+  SelfType &operator/=(E const &e)
+  {
+    Evaluate(AsOperand(e), [](T &dst, T value) { dst /= value; });
+    return *this;
+  }
+
   T Sum() const
   {
+    if (IsContiguous())
+      {
+	return fetch::math::kernels::Kernels<T>().sum(storage_.get() + offset_, size_);
+      }
+    if (IsDense())
+      {
+	auto kernel = fetch::math::kernels::Kernels<T>().sum;
+	T sum(0);
+	for (SizeType r(0) ; r < NbRows() ; ++r)
+	  {
+	    sum += kernel(storage_.get() + RowOffset(r), shape_[RANK - 1]);
+	  }
+	return sum;
+      }
     return std::accumulate(begin(), end(), T(0));
   }
 
@@ -435,6 +711,93 @@ public:
   }
 
 private:
+  template <typename E>
+  static typename expression::Operand<E, SelfType>::Type AsOperand(E const &e)
+  {
+    return expression::Operand<E, SelfType>::Make(e);
+  }
+
+  /*
+   * op(element, value) for every element and the matching value of the expression, one row at a
+   * time through raw pointers when everything is dense
+   */
+  template <typename Node, typename Op>
+  void Evaluate(Node const &node, Op const &op)
+  {
+    static_assert(expression::DrainCount<Node>::value <= 1, "A tensor can only be drained once per expression");
+    assert(node.Conforms(shape_));
+    // Draining the destination would clear it while it is being written
+    assert(!node.Drains(storage_.get()));
+    SizeType const n = RowSize();
+    if (IsDense() && node.IsDense())
+      {
+	for (SizeType r(0) ; r < NbRows() ; ++r)
+	  {
+	    T *dst = storage_.get() + RowOffset(r);
+	    auto row = node.Row(r);
+	    for (SizeType j(0) ; j < n ; ++j)
+	      {
+		op(dst[j], row[j]);
+	      }
+	  }
+	return;
+      }
+    SizeType const stride = strides_[RANK - 1];
+    for (SizeType r(0) ; r < NbRows() ; ++r)
+      {
+	T *dst = storage_.get() + RowOffset(r);
+	auto row = node.StridedRow(r);
+	for (SizeType j(0) ; j < n ; ++j)
+	  {
+	    op(dst[j * stride], row[j]);
+	  }
+      }
+  }
+
+  /*
+   * Fast path of the element-wise operations : kernel(row, n) on every row, or a single call on
+   * all the elements when there is no padding in between
+   * Returns false (doing nothing) if the tensor isn't dense
+   */
+  template <typename Kernel>
+  bool ApplyRows(Kernel const &kernel)
+  {
+    if (!IsDense())
+      {
+	return false;
+      }
+    if (IsContiguous())
+      {
+	kernel(storage_.get() + offset_, size_);
+	return true;
+      }
+    for (SizeType r(0) ; r < NbRows() ; ++r)
+      {
+	kernel(storage_.get() + RowOffset(r), shape_[RANK - 1]);
+      }
+    return true;
+  }
+
+  // kernel(row, o_row, n) on every pair of rows, both tensors must have the same shape
+  template <typename Kernel>
+  bool ApplyRows(SelfType const &o, Kernel const &kernel)
+  {
+    if (!IsDense() || !o.IsDense() || shape_ != o.shape_)
+      {
+	return false;
+      }
+    if (IsContiguous() && o.IsContiguous())
+      {
+	kernel(storage_.get() + offset_, o.storage_.get() + o.offset_, size_);
+	return true;
+      }
+    for (SizeType r(0) ; r < NbRows() ; ++r)
+      {
+	kernel(storage_.get() + RowOffset(r), o.storage_.get() + o.RowOffset(r), shape_[RANK - 1]);
+      }
+    return true;
+  }
+
   std::array<SizeType, RANK>      shape_;
   std::array<SizeType, RANK>      padding_;
   std::array<SizeType, RANK>      strides_;
@@ -443,5 +806,11 @@ private:
   SizeType                        offset_;
   SizeType                        size_;
 };
+
+template <typename T, std::uint64_t RANK>
+const typename Tensor<T, RANK>::SizeType Tensor<T, RANK>::ALIGNMENT;
+template <typename T, std::uint64_t RANK>
+const typename Tensor<T, RANK>::SizeType Tensor<T, RANK>::DefaultAlignment;
+
 }  // namespace math
 }  // namespace fetch
@@ -0,0 +1,189 @@
+#pragma once
+//------------------------------------------------------------------------------
+//
+//   Copyright 2018-2019 Fetch.AI Limited
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Alignment of Tensor storage and rows, in bytes : a cache line unless overridden at compile time
+#ifndef FETCH_TENSOR_ALIGNMENT
+#define FETCH_TENSOR_ALIGNMENT 64
+#endif
+
+namespace fetch {
+namespace math {
+
+/*
+ * Bump allocator for the temporaries of one training step : Allocate moves a pointer forward,
+ * Reset drops everything at once, typically at the start of every step
+ * Memory is only ever requested from the heap while the arena grows : once it has seen the
+ * biggest step, Reset merges its chunks into one and the following steps don't allocate at all
+ */
+class TensorArena
+{
+public:
+  static constexpr std::size_t ALIGNMENT = FETCH_TENSOR_ALIGNMENT;
+
+  explicit TensorArena(std::size_t initial_capacity = 64 * 1024)
+  {
+    AddChunk(initial_capacity);
+  }
+
+  TensorArena(TensorArena const &) = delete;
+  TensorArena &operator=(TensorArena const &) = delete;
+
+  // bytes of memory aligned on ALIGNMENT, valid until the next Reset
+  void *Allocate(std::size_t bytes)
+  {
+    bytes = (bytes + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+    if (used_ + bytes > chunks_.back().size)
+      {
+	AddChunk(std::max(bytes, 2 * chunks_.back().size));
+      }
+    void *ret = chunks_.back().data + used_;
+    used_ += bytes;
+    return ret;
+  }
+
+  void Reset()
+  {
+    if (chunks_.size() > 1)
+      {
+	std::size_t capacity = Capacity();
+	chunks_.clear();
+	AddChunk(capacity);
+      }
+    used_ = 0;
+  }
+
+  std::size_t Capacity() const
+  {
+    std::size_t capacity(0);
+    for (auto const &c : chunks_)
+      {
+	capacity += c.size;
+      }
+    return capacity;
+  }
+
+  /*
+   * Makes arena the one Tensor::Temporary allocates from on this thread, until the Scope is destroyed
+   * Scopes nest, and a Scope of nullptr sends temporaries back to the heap
+   */
+  class Scope
+  {
+  public:
+    explicit Scope(TensorArena *arena)
+      : previous_(CurrentRef())
+    {
+      CurrentRef() = arena;
+    }
+
+    ~Scope()
+    {
+      CurrentRef() = previous_;
+    }
+
+    Scope(Scope const &) = delete;
+    Scope &operator=(Scope const &) = delete;
+
+  private:
+    TensorArena *previous_;
+  };
+
+  static TensorArena *Current()
+  {
+    return CurrentRef();
+  }
+
+private:
+  struct Chunk
+  {
+    std::unique_ptr<unsigned char[]> block;
+    unsigned char *                  data;
+    std::size_t                      size;
+  };
+
+  void AddChunk(std::size_t size)
+  {
+    Chunk c;
+    c.block.reset(new unsigned char[size + ALIGNMENT]);
+    std::uintptr_t address = reinterpret_cast<std::uintptr_t>(c.block.get());
+    c.data = c.block.get() + (ALIGNMENT - address % ALIGNMENT) % ALIGNMENT;
+    c.size = size;
+    chunks_.push_back(std::move(c));
+    used_ = 0;
+  }
+
+  static TensorArena *&CurrentRef()
+  {
+    thread_local TensorArena *current = nullptr;
+    return current;
+  }
+
+  std::vector<Chunk> chunks_;
+  std::size_t        used_ = 0;
+};
+
+/*
+ * Standard allocator over a TensorArena, deallocate being a no-op
+ * Used for the shared_ptr control blocks of arena tensors, so they don't touch the heap either
+ */
+template <typename U>
+struct ArenaAllocator
+{
+  using value_type = U;
+
+  explicit ArenaAllocator(TensorArena &a)
+    : arena(&a)
+  {}
+
+  template <typename V>
+  ArenaAllocator(ArenaAllocator<V> const &o)
+    : arena(o.arena)
+  {}
+
+  U *allocate(std::size_t n)
+  {
+    return static_cast<U *>(arena->Allocate(n * sizeof(U)));
+  }
+
+  void deallocate(U *, std::size_t)
+  {}
+
+  TensorArena *arena;
+};
+
+template <typename U, typename V>
+bool operator==(ArenaAllocator<U> const &a, ArenaAllocator<V> const &b)
+{
+  return a.arena == b.arena;
+}
+
+template <typename U, typename V>
+bool operator!=(ArenaAllocator<U> const &a, ArenaAllocator<V> const &b)
+{
+  return !(a == b);
+}
+
+}  // namespace math
+}  // namespace fetch
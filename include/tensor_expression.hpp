@@ -0,0 +1,617 @@
+#pragma once
+//------------------------------------------------------------------------------
+//
+//   Copyright 2018-2019 Fetch.AI Limited
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//------------------------------------------------------------------------------
+
+#include <array>
+#include <cstdint>
+#include <type_traits>
+
+namespace fetch {
+namespace math {
+
+template <typename T, std::uint64_t RANK>
+class Tensor;
+
+/*
+ * Lazy element-wise arithmetic on tensors : a + b, a - b, a * b, a / b and -a, where either side
+ * can be a tensor, a scalar or another expression, only build a small tree of references
+ * Nothing is computed until the expression is given to Tensor::Assign or to one of Tensor's
+ * compound assignments (+=, -=, *=, /=), which evaluate it in a single loop over the rows of
+ * the destination, without any temporary tensor. For example
+ *   error.Assign(ground_truth - prediction);
+ *   weights += gradient * -learning_rate;
+ * The tensors of an expression must have the shape of the destination. Expressions hold
+ * references to their tensors, so they must be evaluated in the statement that builds them
+ * Every node gives its rows in two forms : Row(r), a raw pointer like accessor used when all the
+ * tensors are dense, which the compiler can vectorise, and StridedRow(r) for the other cases
+ * Besides the operators, Map(f, x) applies f to every element of x, and Drain(t) reads t and
+ * sets every element it read to 0, which fuses a reset into the pass that consumes the tensor :
+ *   weights += Drain(gradient) * -learning_rate;
+ * A tensor can be drained at most once per expression (checked at compile time) and never into
+ * itself (asserted at evaluation, see Drains)
+ */
+namespace expression {
+
+template <typename T>
+struct ScalarRow
+{
+  T value;
+
+  T operator[](std::uint64_t) const
+  {
+    return value;
+  }
+};
+
+template <typename T>
+struct StridedPointer
+{
+  T const *     data;
+  std::uint64_t stride;
+
+  T operator[](std::uint64_t j) const
+  {
+    return data[j * stride];
+  }
+};
+
+// Reads and clears, every element must be read exactly once
+template <typename T>
+struct DrainPointer
+{
+  T *data;
+
+  T operator[](std::uint64_t j) const
+  {
+    T value = data[j];
+    data[j] = T(0);
+    return value;
+  }
+};
+
+template <typename T>
+struct StridedDrainPointer
+{
+  T *           data;
+  std::uint64_t stride;
+
+  T operator[](std::uint64_t j) const
+  {
+    T value = data[j * stride];
+    data[j * stride] = T(0);
+    return value;
+  }
+};
+
+template <typename Op, typename L, typename R>
+struct BinaryRow
+{
+  L l;
+  R r;
+
+  auto operator[](std::uint64_t j) const
+  {
+    return Op::Apply(l[j], r[j]);
+  }
+};
+
+template <typename Op, typename A>
+struct UnaryRow
+{
+  A a;
+
+  auto operator[](std::uint64_t j) const
+  {
+    return Op::Apply(a[j]);
+  }
+};
+
+template <typename F, typename A>
+struct MapRow
+{
+  F f;
+  A a;
+
+  auto operator[](std::uint64_t j) const
+  {
+    return f(a[j]);
+  }
+};
+
+/*
+ * Leaves
+ */
+template <typename T, std::uint64_t RANK>
+class TensorLeaf
+{
+public:
+  using Type     = T;
+  using SizeType = std::uint64_t;
+
+  explicit TensorLeaf(Tensor<T, RANK> const &tensor)
+    : tensor_(tensor)
+  {}
+
+  bool Conforms(std::array<SizeType, RANK> const &shape) const
+  {
+    return tensor_.shape() == shape;
+  }
+
+  bool IsDense() const
+  {
+    return tensor_.IsDense();
+  }
+
+  T const *Row(SizeType r) const
+  {
+    return tensor_.RowPointer(r);
+  }
+
+  bool Drains(T const *) const
+  {
+    return false;
+  }
+
+  StridedPointer<T> StridedRow(SizeType r) const
+  {
+    return {tensor_.RowPointer(r), tensor_.DimensionSize(RANK - 1)};
+  }
+
+private:
+  Tensor<T, RANK> const &tensor_;
+};
+
+// Tensor that is cleared as it is read, see Drain. It must appear only once in an expression
+template <typename T, std::uint64_t RANK>
+class DrainLeaf
+{
+public:
+  using Type     = T;
+  using SizeType = std::uint64_t;
+
+  explicit DrainLeaf(Tensor<T, RANK> &tensor)
+    : tensor_(tensor)
+  {}
+
+  bool Conforms(std::array<SizeType, RANK> const &shape) const
+  {
+    return tensor_.shape() == shape;
+  }
+
+  bool IsDense() const
+  {
+    return tensor_.IsDense();
+  }
+
+  DrainPointer<T> Row(SizeType r) const
+  {
+    return {tensor_.RowPointer(r)};
+  }
+
+  StridedDrainPointer<T> StridedRow(SizeType r) const
+  {
+    return {tensor_.RowPointer(r), tensor_.DimensionSize(RANK - 1)};
+  }
+
+  // Whether the drained tensor lives in storage, views included
+  bool Drains(T const *storage) const
+  {
+    return tensor_.Storage().get() == storage;
+  }
+
+private:
+  Tensor<T, RANK> &tensor_;
+};
+
+template <typename T>
+class ScalarLeaf
+{
+public:
+  using Type     = T;
+  using SizeType = std::uint64_t;
+
+  explicit ScalarLeaf(T value)
+    : value_(value)
+  {}
+
+  template <typename Shape>
+  bool Conforms(Shape const &) const
+  {
+    return true;
+  }
+
+  bool IsDense() const
+  {
+    return true;
+  }
+
+  ScalarRow<T> Row(SizeType) const
+  {
+    return {value_};
+  }
+
+  ScalarRow<T> StridedRow(SizeType) const
+  {
+    return {value_};
+  }
+
+  bool Drains(T const *) const
+  {
+    return false;
+  }
+
+private:
+  T value_;
+};
+
+/*
+ * Inner nodes
+ */
+template <typename Op, typename L, typename R>
+class Binary
+{
+public:
+  using Type     = typename L::Type;
+  using SizeType = std::uint64_t;
+
+  Binary(L const &l, R const &r)
+    : l_(l)
+    , r_(r)
+  {}
+
+  template <typename Shape>
+  bool Conforms(Shape const &shape) const
+  {
+    return l_.Conforms(shape) && r_.Conforms(shape);
+  }
+
+  bool IsDense() const
+  {
+    return l_.IsDense() && r_.IsDense();
+  }
+
+  auto Row(SizeType r) const
+  {
+    return BinaryRow<Op, decltype(l_.Row(r)), decltype(r_.Row(r))>{l_.Row(r), r_.Row(r)};
+  }
+
+  auto StridedRow(SizeType r) const
+  {
+    return BinaryRow<Op, decltype(l_.StridedRow(r)), decltype(r_.StridedRow(r))>{l_.StridedRow(r),
+                                                                                      r_.StridedRow(r)};
+  }
+
+  bool Drains(Type const *storage) const
+  {
+    return l_.Drains(storage) || r_.Drains(storage);
+  }
+
+private:
+  L l_;
+  R r_;
+};
+
+template <typename Op, typename A>
+class Unary
+{
+public:
+  using Type     = typename A::Type;
+  using SizeType = std::uint64_t;
+
+  explicit Unary(A const &a)
+    : a_(a)
+  {}
+
+  template <typename Shape>
+  bool Conforms(Shape const &shape) const
+  {
+    return a_.Conforms(shape);
+  }
+
+  bool IsDense() const
+  {
+    return a_.IsDense();
+  }
+
+  auto Row(SizeType r) const
+  {
+    return UnaryRow<Op, decltype(a_.Row(r))>{a_.Row(r)};
+  }
+
+  auto StridedRow(SizeType r) const
+  {
+    return UnaryRow<Op, decltype(a_.StridedRow(r))>{a_.StridedRow(r)};
+  }
+
+  bool Drains(Type const *storage) const
+  {
+    return a_.Drains(storage);
+  }
+
+private:
+  A a_;
+};
+
+// f applied to every element of a, see Map
+template <typename F, typename A>
+class Mapped
+{
+public:
+  using Type     = typename A::Type;
+  using SizeType = std::uint64_t;
+
+  Mapped(F const &f, A const &a)
+    : f_(f)
+    , a_(a)
+  {}
+
+  template <typename Shape>
+  bool Conforms(Shape const &shape) const
+  {
+    return a_.Conforms(shape);
+  }
+
+  bool IsDense() const
+  {
+    return a_.IsDense();
+  }
+
+  auto Row(SizeType r) const
+  {
+    return MapRow<F, decltype(a_.Row(r))>{f_, a_.Row(r)};
+  }
+
+  auto StridedRow(SizeType r) const
+  {
+    return MapRow<F, decltype(a_.StridedRow(r))>{f_, a_.StridedRow(r)};
+  }
+
+  bool Drains(Type const *storage) const
+  {
+    return a_.Drains(storage);
+  }
+
+private:
+  F f_;
+  A a_;
+};
+
+struct Add
+{
+  template <typename T>
+  static T Apply(T a, T b)
+  {
+    return a + b;
+  }
+};
+
+struct Subtract
+{
+  template <typename T>
+  static T Apply(T a, T b)
+  {
+    return a - b;
+  }
+};
+
+struct Multiply
+{
+  template <typename T>
+  static T Apply(T a, T b)
+  {
+    return a * b;
+  }
+};
+
+struct Divide
+{
+  template <typename T>
+  static T Apply(T a, T b)
+  {
+    return a / b;
+  }
+};
+
+struct Negate
+{
+  template <typename T>
+  static T Apply(T a)
+  {
+    return -a;
+  }
+};
+
+/*
+ * IsNode : tensors and expression nodes, what the operators below accept on at least one side
+ */
+template <typename X>
+struct IsNode : std::false_type
+{
+};
+
+template <typename T, std::uint64_t RANK>
+struct IsNode<Tensor<T, RANK>> : std::true_type
+{
+};
+
+template <typename T, std::uint64_t RANK>
+struct IsNode<TensorLeaf<T, RANK>> : std::true_type
+{
+};
+
+template <typename T, std::uint64_t RANK>
+struct IsNode<DrainLeaf<T, RANK>> : std::true_type
+{
+};
+
+template <typename T>
+struct IsNode<ScalarLeaf<T>> : std::true_type
+{
+};
+
+template <typename F, typename A>
+struct IsNode<Mapped<F, A>> : std::true_type
+{
+};
+
+template <typename Op, typename L, typename R>
+struct IsNode<Binary<Op, L, R>> : std::true_type
+{
+};
+
+template <typename Op, typename A>
+struct IsNode<Unary<Op, A>> : std::true_type
+{
+};
+
+/*
+ * DrainCount : number of Drain leaves in an expression, at most one is allowed since a second
+ * read of the same tensor would see the zeros written by the first
+ */
+template <typename X>
+struct DrainCount : std::integral_constant<int, 0>
+{
+};
+
+template <typename T, std::uint64_t RANK>
+struct DrainCount<DrainLeaf<T, RANK>> : std::integral_constant<int, 1>
+{
+};
+
+template <typename F, typename A>
+struct DrainCount<Mapped<F, A>> : DrainCount<A>
+{
+};
+
+template <typename Op, typename L, typename R>
+struct DrainCount<Binary<Op, L, R>> : std::integral_constant<int, DrainCount<L>::value + DrainCount<R>::value>
+{
+};
+
+template <typename Op, typename A>
+struct DrainCount<Unary<Op, A>> : DrainCount<A>
+{
+};
+
+// Turns a tensor into a leaf, leaves nodes as they are
+template <typename T, std::uint64_t RANK>
+TensorLeaf<T, RANK> AsNode(Tensor<T, RANK> const &tensor)
+{
+  return TensorLeaf<T, RANK>(tensor);
+}
+
+template <typename Node, typename = typename std::enable_if<IsNode<Node>::value>::type>
+Node const &AsNode(Node const &node)
+{
+  return node;
+}
+
+template <typename X>
+using NodeType = typename std::decay<decltype(AsNode(std::declval<X const &>()))>::type;
+
+// The other side of a binary operation : a scalar becomes a ScalarLeaf of the tensor's type
+template <typename X, typename Other, bool = IsNode<X>::value>
+struct Operand
+{
+  using Type = NodeType<X>;
+
+  static Type Make(X const &x)
+  {
+    return AsNode(x);
+  }
+};
+
+template <typename X, typename Other>
+struct Operand<X, Other, false>
+{
+  using Type = ScalarLeaf<typename NodeType<Other>::Type>;
+
+  static Type Make(X const &x)
+  {
+    return Type(typename Type::Type(x));
+  }
+};
+
+template <typename Op, typename L, typename R>
+using BinaryType = Binary<Op, typename Operand<L, R>::Type, typename Operand<R, L>::Type>;
+
+template <typename Op, typename L, typename R>
+BinaryType<Op, L, R> MakeBinary(L const &l, R const &r)
+{
+  return BinaryType<Op, L, R>(Operand<L, R>::Make(l), Operand<R, L>::Make(r));
+}
+
+template <typename L, typename R>
+using EnableIfOperands = typename std::enable_if<(IsNode<L>::value && (IsNode<R>::value || std::is_arithmetic<R>::value)) ||
+                                                 (IsNode<R>::value && std::is_arithmetic<L>::value)>::type;
+
+template <typename L, typename R, typename = EnableIfOperands<L, R>>
+BinaryType<Add, L, R> operator+(L const &l, R const &r)
+{
+  return MakeBinary<Add>(l, r);
+}
+
+template <typename L, typename R, typename = EnableIfOperands<L, R>>
+BinaryType<Subtract, L, R> operator-(L const &l, R const &r)
+{
+  return MakeBinary<Subtract>(l, r);
+}
+
+template <typename L, typename R, typename = EnableIfOperands<L, R>>
+BinaryType<Multiply, L, R> operator*(L const &l, R const &r)
+{
+  return MakeBinary<Multiply>(l, r);
+}
+
+template <typename L, typename R, typename = EnableIfOperands<L, R>>
+BinaryType<Divide, L, R> operator/(L const &l, R const &r)
+{
+  return MakeBinary<Divide>(l, r);
+}
+
+template <typename A, typename = typename std::enable_if<IsNode<A>::value>::type>
+Unary<Negate, NodeType<A>> operator-(A const &a)
+{
+  return Unary<Negate, NodeType<A>>(AsNode(a));
+}
+
+template <typename F, typename A, typename = typename std::enable_if<IsNode<A>::value>::type>
+Mapped<F, NodeType<A>> Map(F const &f, A const &a)
+{
+  return Mapped<F, NodeType<A>>(f, AsNode(a));
+}
+
+template <typename T, std::uint64_t RANK>
+DrainLeaf<T, RANK> Drain(Tensor<T, RANK> &tensor)
+{
+  return DrainLeaf<T, RANK>(tensor);
+}
+
+}  // namespace expression
+
+using expression::Drain;
+using expression::Map;
+
+// So that argument dependent lookup finds the operators for tensors as well as for expressions
+using expression::operator+;
+using expression::operator-;
+using expression::operator*;
+using expression::operator/;
+
+}  // namespace math
+}  // namespace fetch
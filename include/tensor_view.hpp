@@ -0,0 +1,245 @@
+#pragma once
+//------------------------------------------------------------------------------
+//
+//   Copyright 2018-2019 Fetch.AI Limited
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//------------------------------------------------------------------------------
+
+#include "vector_kernels.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <type_traits>
+
+namespace fetch {
+namespace math {
+
+/*
+ * Non owning view of a tensor : a raw pointer, a shape and strides
+ * Slicing a Tensor copies its shared_ptr to the storage, which costs two atomic operations per
+ * slice, a view doesn't touch the reference count so it's what the ops use in their inner loops
+ * The view must not outlive the tensor it was taken from
+ * T is const for read only views, a TensorView<T> converts to a TensorView<T const>
+ */
+template <typename T, std::uint64_t RANK>
+class TensorView
+{
+public:
+  using Type      = T;
+  using ValueType = typename std::remove_const<T>::type;
+  using SizeType  = std::uint64_t;
+  using SelfType  = TensorView<T, RANK>;
+
+  TensorView(T *data, std::array<SizeType, RANK> const &shape, std::array<SizeType, RANK> const &strides)
+    : data_(data)
+    , shape_(shape)
+    , strides_(strides)
+  {}
+
+  template <typename U, typename = typename std::enable_if<std::is_same<U const, T>::value &&
+							   !std::is_same<U, T>::value>::type>
+  TensorView(TensorView<U, RANK> const &o)
+    : data_(o.data())
+    , shape_(o.shape())
+    , strides_(o.strides())
+  {}
+
+  T *data() const
+  {
+    return data_;
+  }
+
+  std::array<SizeType, RANK> const &shape() const
+  {
+    return shape_;
+  }
+
+  std::array<SizeType, RANK> const &strides() const
+  {
+    return strides_;
+  }
+
+  SizeType Size() const
+  {
+    SizeType size(1);
+    for (SizeType d : shape_)
+      {
+	size *= d;
+      }
+    return size;
+  }
+
+  template <typename... Indices>
+  T &Get(Indices... indices) const
+  {
+    static_assert(sizeof...(Indices) == RANK, "Number of indexes in Get() doesn't match view rank");
+    std::array<SizeType, RANK> idx{{SizeType(indices)...}};
+    SizeType offset(0);
+    for (SizeType d(0) ; d < RANK ; ++d)
+      {
+	assert(idx[d] < shape_[d]);
+	offset += idx[d] * strides_[d];
+      }
+    return data_[offset];
+  }
+
+  /*
+   * View of the i-th element along the first dimension, the equivalent of Tensor::Slice
+   */
+  TensorView<T, RANK - 1> Slice(SizeType i) const
+  {
+    static_assert(RANK > 1, "Can't slice a rank 1 view");
+    assert(i < shape_[0]);
+    std::array<SizeType, RANK - 1> shape;
+    std::array<SizeType, RANK - 1> strides;
+    std::copy(std::next(shape_.begin()), shape_.end(), shape.begin());
+    std::copy(std::next(strides_.begin()), strides_.end(), strides.begin());
+    return TensorView<T, RANK - 1>(data_ + i * strides_[0], shape, strides);
+  }
+
+  // Reversed dimensions, the result isn't dense for RANK > 1
+  SelfType Transpose() const
+  {
+    std::array<SizeType, RANK> shape;
+    std::array<SizeType, RANK> strides;
+    std::reverse_copy(shape_.begin(), shape_.end(), shape.begin());
+    std::reverse_copy(strides_.begin(), strides_.end(), strides.begin());
+    return SelfType(data_, shape, strides);
+  }
+
+  // Same meaning as for Tensor : the elements of the last dimension are contiguous
+  bool IsDense() const
+  {
+    return strides_[RANK - 1] == 1;
+  }
+
+  SizeType NbRows() const
+  {
+    return shape_[RANK - 1] ? Size() / shape_[RANK - 1] : 0;
+  }
+
+  SizeType RowSize() const
+  {
+    return shape_[RANK - 1];
+  }
+
+  T *RowPointer(SizeType row) const
+  {
+    assert(row < NbRows());
+    SizeType offset(0);
+    for (SizeType d(RANK - 1) ; d-- > 0 ; )
+      {
+	offset += (row % shape_[d]) * strides_[d];
+	row /= shape_[d];
+      }
+    return data_ + offset;
+  }
+
+  ///////////////////////////
+  /// ELEMENT-WISE INLINE ///
+  ///////////////////////////
+
+  SelfType const &Fill(ValueType const &value) const
+  {
+    ApplyRows([&value](T *dst, SizeType n) { std::fill_n(dst, n, value); },
+	      [&value](T &dst) { dst = value; });
+    return *this;
+  }
+
+  SelfType const &Copy(TensorView<ValueType const, RANK> const &o) const
+  {
+    ApplyRows(o, [](T *dst, ValueType const *src, SizeType n) { std::copy_n(src, n, dst); },
+	      [](T &dst, ValueType const &src) { dst = src; });
+    return *this;
+  }
+
+  SelfType const &InlineAdd(TensorView<ValueType const, RANK> const &o, ValueType alpha = ValueType(1)) const
+  {
+    auto kernel = kernels::Kernels<ValueType>().add;
+    ApplyRows(o, [kernel, &alpha](T *dst, ValueType const *src, SizeType n) { kernel(dst, src, alpha, n); },
+	      [&alpha](T &dst, ValueType const &src) { dst += src * alpha; });
+    return *this;
+  }
+
+  SelfType const &InlineMultiply(ValueType const &value) const
+  {
+    auto kernel = kernels::Kernels<ValueType>().multiply_scalar;
+    ApplyRows([kernel, &value](T *dst, SizeType n) { kernel(dst, value, n); },
+	      [&value](T &dst) { dst *= value; });
+    return *this;
+  }
+
+  SelfType const &InlineDivide(ValueType const &value) const
+  {
+    auto kernel = kernels::Kernels<ValueType>().divide_scalar;
+    ApplyRows([kernel, &value](T *dst, SizeType n) { kernel(dst, value, n); },
+	      [&value](T &dst) { dst /= value; });
+    return *this;
+  }
+
+private:
+  /*
+   * kernel(row, n) on every row when the view is dense, element(e) on every element otherwise
+   */
+  template <typename Kernel, typename Element>
+  void ApplyRows(Kernel const &kernel, Element const &element) const
+  {
+    SizeType const n = RowSize();
+    for (SizeType r(0) ; r < NbRows() ; ++r)
+      {
+	T *row = RowPointer(r);
+	if (IsDense())
+	  {
+	    kernel(row, n);
+	    continue;
+	  }
+	for (SizeType i(0) ; i < n ; ++i)
+	  {
+	    element(row[i * strides_[RANK - 1]]);
+	  }
+      }
+  }
+
+  // Same on pairs of rows, both views must have the same shape
+  template <typename Kernel, typename Element>
+  void ApplyRows(TensorView<ValueType const, RANK> const &o, Kernel const &kernel, Element const &element) const
+  {
+    assert(shape_ == o.shape());
+    SizeType const n = RowSize();
+    for (SizeType r(0) ; r < NbRows() ; ++r)
+      {
+	T *row = RowPointer(r);
+	ValueType const *o_row = o.RowPointer(r);
+	if (IsDense() && o.IsDense())
+	  {
+	    kernel(row, o_row, n);
+	    continue;
+	  }
+	for (SizeType i(0) ; i < n ; ++i)
+	  {
+	    element(row[i * strides_[RANK - 1]], o_row[i * o.strides()[RANK - 1]]);
+	  }
+      }
+  }
+
+  T *                        data_;
+  std::array<SizeType, RANK> shape_;
+  std::array<SizeType, RANK> strides_;
+};
+
+}  // namespace math
+}  // namespace fetch
@@ -0,0 +1,209 @@
+#pragma once
+//------------------------------------------------------------------------------
+//
+//   Copyright 2018-2019 Fetch.AI Limited
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace fetch {
+namespace math {
+
+/*
+ * Persistent worker threads for data parallel loops : ParallelFor(n, f) runs f(0) ... f(n - 1)
+ * on the workers and the calling thread, and returns once all of them are done
+ * The threads are created once and sleep between loops, so a loop costs a wake up, not a spawn
+ * One loop runs at a time : a ParallelFor issued while the pool is busy (from another thread,
+ * or from inside f) runs serially on its caller instead of waiting
+ * If f throws, the other indices still run, then ParallelFor rethrows the first exception on its
+ * caller, leaving the pool free for the next loop
+ */
+class ThreadPool
+{
+public:
+  // @param nb_workers threads besides the caller, 0 makes every loop serial
+  explicit ThreadPool(std::size_t nb_workers)
+  {
+    for (std::size_t i(0) ; i < nb_workers ; ++i)
+      {
+	workers_.emplace_back([this]() { Work(); });
+      }
+  }
+
+  ThreadPool(ThreadPool const &) = delete;
+  ThreadPool &operator=(ThreadPool const &) = delete;
+
+  ~ThreadPool()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    wake_.notify_all();
+    for (auto &w : workers_)
+      {
+	w.join();
+      }
+  }
+
+  // Number of threads a loop runs on, the caller included
+  std::size_t NbThreads() const
+  {
+    return workers_.size() + 1;
+  }
+
+  template <typename F>
+  void ParallelFor(std::size_t n, F const &f)
+  {
+    // A flag, not a mutex : the caller of the running loop may get here again from inside f
+    bool owner = !busy_.exchange(true, std::memory_order_acquire);
+    if (!owner || workers_.empty() || n < 2)
+      {
+	try
+	  {
+	    for (std::size_t i(0) ; i < n ; ++i)
+	      {
+		f(i);
+	      }
+	  }
+	catch (...)
+	  {
+	    if (owner)
+	      {
+		busy_.store(false, std::memory_order_release);
+	      }
+	    throw;
+	  }
+	if (owner)
+	  {
+	    busy_.store(false, std::memory_order_release);
+	  }
+	return;
+      }
+
+    std::function<void(std::size_t)> task(std::cref(f));
+    Job job(task, n);
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      job_ = &job;
+      ++generation_;
+    }
+    wake_.notify_all();
+    Run(job);
+
+    // The job lives on this stack : wait for the last worker to let go of it
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_.wait(lock, [&]() { return job.done == n && active_ == 0; });
+    job_ = nullptr;
+    busy_.store(false, std::memory_order_release);
+    if (job.error)
+      {
+	std::rethrow_exception(job.error);
+      }
+  }
+
+  // Shared pool with one thread per core, created on first use
+  static ThreadPool &Default()
+  {
+    static ThreadPool pool(std::max(1u, std::thread::hardware_concurrency()) - 1);
+    return pool;
+  }
+
+private:
+  struct Job
+  {
+    Job(std::function<void(std::size_t)> const &t, std::size_t size)
+      : task(t), n(size)
+    {}
+
+    std::function<void(std::size_t)> const &task;
+    std::size_t                             n;
+    std::atomic<std::size_t>                next{0};
+    std::size_t                             done{0};  // guarded by mutex_
+    std::exception_ptr                      error;    // first exception thrown by task, guarded by mutex_
+  };
+
+  // Never throws : an exception from the task is kept in the job and the index counts as done
+  void Run(Job &job)
+  {
+    std::size_t ran(0);
+    for (std::size_t i = job.next.fetch_add(1) ; i < job.n ; i = job.next.fetch_add(1))
+      {
+	try
+	  {
+	    job.task(i);
+	  }
+	catch (...)
+	  {
+	    std::lock_guard<std::mutex> lock(mutex_);
+	    if (!job.error)
+	      {
+		job.error = std::current_exception();
+	      }
+	  }
+	++ran;
+      }
+    if (ran > 0)
+      {
+	std::lock_guard<std::mutex> lock(mutex_);
+	job.done += ran;
+      }
+  }
+
+  void Work()
+  {
+    std::uint64_t seen(0);
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true)
+      {
+	wake_.wait(lock, [&]() { return stop_ || (job_ && generation_ != seen); });
+	if (stop_)
+	  {
+	    return;
+	  }
+	seen = generation_;
+	Job *job = job_;
+	++active_;
+	lock.unlock();
+	Run(*job);
+	lock.lock();
+	--active_;
+	done_.notify_all();
+      }
+  }
+
+  std::vector<std::thread> workers_;
+  std::atomic<bool>        busy_{false};  // set by the caller of the running loop
+  std::mutex               mutex_;
+  std::condition_variable  wake_;
+  std::condition_variable  done_;
+  Job                     *job_ = nullptr;
+  std::uint64_t            generation_ = 0;
+  std::size_t              active_ = 0;
+  bool                     stop_ = false;
+};
+
+}  // namespace math
+}  // namespace fetch
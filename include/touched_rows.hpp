@@ -0,0 +1,187 @@
+#pragma once
+//------------------------------------------------------------------------------
+//
+//   Copyright 2018-2019 Fetch.AI Limited
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace fetch {
+namespace ml {
+
+/**
+ * Set of the rows of a matrix touched since the last Clear, giving each one a slot number
+ * (0, 1, 2... in order of first insertion)
+ * A small open addressing hash table : no allocation once it reached its working size, no
+ * pointer chasing, and Clear() only bumps a generation counter instead of freeing nodes
+ * Entries stamped with an older generation are considered empty
+ */
+class TouchedRows
+{
+public:
+  using SizeType = std::uint64_t;
+
+  explicit TouchedRows(SizeType initial_capacity = 64)
+  {
+    SizeType capacity(16);
+    while (capacity < 2 * initial_capacity)
+      {
+	capacity <<= 1;
+      }
+    table_.resize(capacity);
+  }
+
+  /**
+   * @return the slot of row, and whether it was just inserted
+   */
+  std::pair<SizeType, bool> Insert(SizeType row)
+  {
+    // Keeps the table at most half full, so probe sequences stay short
+    if (2 * (rows_.size() + 1) > table_.size())
+      {
+	Grow();
+      }
+    SizeType mask = table_.size() - 1;
+    for (SizeType i = Hash(row) & mask ; ; i = (i + 1) & mask)
+      {
+	Entry &e = table_[i];
+	if (e.generation != generation_)
+	  {
+	    e.row        = row;
+	    e.slot       = static_cast<uint32_t>(rows_.size());
+	    e.generation = generation_;
+	    rows_.push_back(row);
+	    return {e.slot, true};
+	  }
+	if (e.row == row)
+	  {
+	    return {e.slot, false};
+	  }
+      }
+  }
+
+  /**
+   * @return the slot of row, or Size() if it wasn't touched
+   */
+  SizeType Find(SizeType row) const
+  {
+    SizeType mask = table_.size() - 1;
+    for (SizeType i = Hash(row) & mask ; ; i = (i + 1) & mask)
+      {
+	Entry const &e = table_[i];
+	if (e.generation != generation_)
+	  {
+	    return rows_.size();
+	  }
+	if (e.row == row)
+	  {
+	    return e.slot;
+	  }
+      }
+  }
+
+  void Clear()
+  {
+    rows_.clear();
+    if (++generation_ == 0)
+      {
+	// The counter wrapped around, entries from 2^32 clears ago would look valid again
+	std::fill(table_.begin(), table_.end(), Entry());
+	generation_ = 1;
+      }
+  }
+
+  /**
+   * Touched rows in slot order : Rows()[slot] is the row of slot
+   */
+  std::vector<SizeType> const &Rows() const
+  {
+    return rows_;
+  }
+
+  /**
+   * Slots ordered by increasing row, for when updates must happen in a deterministic order that
+   * doesn't depend on the order rows were touched in
+   */
+  std::vector<SizeType> const &SortedSlots()
+  {
+    sorted_slots_.resize(rows_.size());
+    for (SizeType i(0) ; i < rows_.size() ; ++i)
+      {
+	sorted_slots_[i] = i;
+      }
+    std::sort(sorted_slots_.begin(), sorted_slots_.end(),
+	      [this](SizeType a, SizeType b) { return rows_[a] < rows_[b]; });
+    return sorted_slots_;
+  }
+
+  SizeType Size() const
+  {
+    return rows_.size();
+  }
+
+  bool Empty() const
+  {
+    return rows_.empty();
+  }
+
+private:
+  struct Entry
+  {
+    SizeType row        = 0;
+    uint32_t slot       = 0;
+    uint32_t generation = 0;
+  };
+
+  static SizeType Hash(SizeType row)
+  {
+    // Fibonacci hashing, the high bits are the best mixed ones
+    return (row * 0x9E3779B97F4A7C15ull) >> 32;
+  }
+
+  void Grow()
+  {
+    std::vector<Entry> old;
+    old.swap(table_);
+    table_.resize(old.size() * 2);
+    SizeType mask = table_.size() - 1;
+    for (Entry const &e : old)
+      {
+	if (e.generation != generation_)
+	  {
+	    continue;
+	  }
+	SizeType i = Hash(e.row) & mask;
+	while (table_[i].generation == generation_)
+	  {
+	    i = (i + 1) & mask;
+	  }
+	table_[i] = e;
+      }
+  }
+
+  std::vector<Entry>    table_;
+  std::vector<SizeType> rows_;
+  std::vector<SizeType> sorted_slots_;
+  uint32_t              generation_ = 1;
+};
+
+}  // namespace ml
+}  // namespace fetch
@@ -2,6 +2,15 @@
 
 #include "lcg.hpp"
 
+#include <cassert>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+/*
+ * Copies of a table share the (large) lookup array but each have their own random generator
+ * so every training thread can sample from the same distribution independently
+ */
 class UnigramTable
 {
 public:
@@ -14,7 +23,8 @@ public:
   {
     if (size && frequencies.size())
       {
-	data_.resize(size);
+	data_ = std::make_shared<std::vector<uint64_t>>(size);
+	std::vector<uint64_t> &data = *data_;
 	double total(0);
 	for (auto const &e : frequencies)
 	  {
@@ -24,7 +34,7 @@ public:
 	double n = pow(frequencies[i], 0.75) / total;
 	for (std::size_t j(0) ; j < size ; ++j)
 	  {
-	    data_[j] = i;
+	    data[j] = i;
 	    if (j / (double)size > n)
 	      {
 		i++;
@@ -35,23 +45,28 @@ public:
       }
   }
   
+  void Seed(uint64_t seed)
+  {
+    rng_.Seed(seed);
+  }
+
   uint64_t Sample()
   {
-    return data_[rng_() % data_.size()];
+    return (*data_)[rng_() % data_->size()];
   }
 
   uint64_t SampleNegative(uint64_t positiveIndex)
   {
-    uint64_t sample = data_[rng_() % data_.size()];
+    uint64_t sample = (*data_)[rng_() % data_->size()];
     while (sample == positiveIndex)
       {
-	sample = data_[rng_() % data_.size()];
+	sample = (*data_)[rng_() % data_->size()];
       }
     return sample;
   }
 
   
 private:
-  std::vector<uint64_t> data_;
+  std::shared_ptr<std::vector<uint64_t>> data_;
   fetch::random::LinearCongruentialGenerator rng_;
 };
@@ -0,0 +1,301 @@
+#pragma once
+//------------------------------------------------------------------------------
+//
+//   Copyright 2018-2019 Fetch.AI Limited
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//------------------------------------------------------------------------------
+
+#include <cstddef>
+#include <cstring>
+
+/*
+ * Element-wise kernels on contiguous arrays, used by Tensor whenever its rows are contiguous
+ * On x86-64 with GCC or Clang the float and double kernels come in SSE2, AVX2 and AVX-512
+ * versions, the best one supported by the CPU is picked at runtime (cpuid). Other types and
+ * platforms use the scalar loops
+ * All the kernels do the same operations in the same order as the scalar loops, with contraction
+ * to FMA disabled, so they give bit identical results. The only exception is Sum, which keeps one
+ * partial sum per lane
+ */
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define FETCH_VECTOR_KERNELS 1
+#if defined(__clang__)
+#define FETCH_KERNEL_TARGET(ISA) __attribute__((target(ISA)))
+#define FETCH_KERNEL_NO_CONTRACT _Pragma("clang fp contract(off)")
+#else
+#define FETCH_KERNEL_TARGET(ISA) __attribute__((target(ISA), optimize("fp-contract=off")))
+#define FETCH_KERNEL_NO_CONTRACT
+#endif
+#else
+#define FETCH_VECTOR_KERNELS 0
+#endif
+
+namespace fetch {
+namespace math {
+namespace kernels {
+
+enum class InstructionSet
+{
+  SCALAR,
+  SSE2,
+  AVX2,
+  AVX512
+};
+
+template <typename T>
+struct KernelTable
+{
+  void (*add)(T *dst, T const *src, T alpha, std::size_t n);   // dst += src * alpha
+  void (*subtract)(T *dst, T const *src, std::size_t n);        // dst -= src
+  void (*multiply)(T *dst, T const *src, std::size_t n);        // dst *= src
+  void (*divide)(T *dst, T const *src, std::size_t n);          // dst /= src
+  void (*add_scalar)(T *dst, T value, std::size_t n);
+  void (*subtract_scalar)(T *dst, T value, std::size_t n);
+  void (*multiply_scalar)(T *dst, T value, std::size_t n);
+  void (*divide_scalar)(T *dst, T value, std::size_t n);
+  T    (*sum)(T const *src, std::size_t n);
+};
+
+template <typename T>
+struct Scalar
+{
+  static void Add(T *dst, T const *src, T alpha, std::size_t n)
+  {
+    for (std::size_t i(0) ; i < n ; ++i) dst[i] += (src[i] * alpha);
+  }
+  static void Subtract(T *dst, T const *src, std::size_t n)
+  {
+    for (std::size_t i(0) ; i < n ; ++i) dst[i] -= src[i];
+  }
+  static void Multiply(T *dst, T const *src, std::size_t n)
+  {
+    for (std::size_t i(0) ; i < n ; ++i) dst[i] *= src[i];
+  }
+  static void Divide(T *dst, T const *src, std::size_t n)
+  {
+    for (std::size_t i(0) ; i < n ; ++i) dst[i] /= src[i];
+  }
+  static void AddScalar(T *dst, T value, std::size_t n)
+  {
+    for (std::size_t i(0) ; i < n ; ++i) dst[i] += value;
+  }
+  static void SubtractScalar(T *dst, T value, std::size_t n)
+  {
+    for (std::size_t i(0) ; i < n ; ++i) dst[i] -= value;
+  }
+  static void MultiplyScalar(T *dst, T value, std::size_t n)
+  {
+    for (std::size_t i(0) ; i < n ; ++i) dst[i] *= value;
+  }
+  static void DivideScalar(T *dst, T value, std::size_t n)
+  {
+    for (std::size_t i(0) ; i < n ; ++i) dst[i] /= value;
+  }
+  static T Sum(T const *src, std::size_t n)
+  {
+    T sum(0);
+    for (std::size_t i(0) ; i < n ; ++i) sum += src[i];
+    return sum;
+  }
+};
+
+template <typename Kernels, typename T>
+KernelTable<T> MakeTable()
+{
+  return {&Kernels::Add, &Kernels::Subtract, &Kernels::Multiply, &Kernels::Divide,
+	  &Kernels::AddScalar, &Kernels::SubtractScalar, &Kernels::MultiplyScalar, &Kernels::DivideScalar,
+	  &Kernels::Sum};
+}
+
+#if FETCH_VECTOR_KERNELS
+
+/*
+ * Same loops as Scalar on BYTES wide vectors (GCC vector extensions), compiled for ISA
+ * Loads and stores go through memcpy, which becomes unaligned vector moves
+ */
+#define FETCH_DEFINE_VECTOR_KERNELS(NAME, ISA, BYTES)					\
+  template <typename T>									\
+  struct NAME										\
+  {											\
+    typedef T Vector __attribute__((vector_size(BYTES)));				\
+    static constexpr std::size_t WIDTH = BYTES / sizeof(T);				\
+											\
+    FETCH_KERNEL_TARGET(ISA) static void Add(T *dst, T const *src, T alpha, std::size_t n) \
+    {											\
+      FETCH_KERNEL_NO_CONTRACT								\
+      std::size_t i(0);									\
+      for ( ; i + WIDTH <= n ; i += WIDTH)						\
+	{										\
+	  Vector d, s;									\
+	  std::memcpy(&d, dst + i, BYTES);						\
+	  std::memcpy(&s, src + i, BYTES);						\
+	  d += (s * alpha);								\
+	  std::memcpy(dst + i, &d, BYTES);						\
+	}										\
+      for ( ; i < n ; ++i) dst[i] += (src[i] * alpha);					\
+    }											\
+											\
+    FETCH_DEFINE_BINARY_KERNEL(Subtract, ISA, BYTES, -=)				\
+    FETCH_DEFINE_BINARY_KERNEL(Multiply, ISA, BYTES, *=)				\
+    FETCH_DEFINE_BINARY_KERNEL(Divide, ISA, BYTES, /=)					\
+    FETCH_DEFINE_SCALAR_KERNEL(AddScalar, ISA, BYTES, +=)				\
+    FETCH_DEFINE_SCALAR_KERNEL(SubtractScalar, ISA, BYTES, -=)				\
+    FETCH_DEFINE_SCALAR_KERNEL(MultiplyScalar, ISA, BYTES, *=)				\
+    FETCH_DEFINE_SCALAR_KERNEL(DivideScalar, ISA, BYTES, /=)				\
+											\
+    FETCH_KERNEL_TARGET(ISA) static T Sum(T const *src, std::size_t n)		\
+    {											\
+      Vector partial = {};								\
+      std::size_t i(0);									\
+      for ( ; i + WIDTH <= n ; i += WIDTH)						\
+	{										\
+	  Vector s;									\
+	  std::memcpy(&s, src + i, BYTES);						\
+	  partial += s;									\
+	}										\
+      T sum(0);										\
+      for (std::size_t j(0) ; j < WIDTH ; ++j) sum += partial[j];			\
+      for ( ; i < n ; ++i) sum += src[i];						\
+      return sum;									\
+    }											\
+  };
+
+#define FETCH_DEFINE_BINARY_KERNEL(NAME, ISA, BYTES, OP)				\
+    FETCH_KERNEL_TARGET(ISA) static void NAME(T *dst, T const *src, std::size_t n)	\
+    {											\
+      std::size_t i(0);									\
+      for ( ; i + WIDTH <= n ; i += WIDTH)						\
+	{										\
+	  Vector d, s;									\
+	  std::memcpy(&d, dst + i, BYTES);						\
+	  std::memcpy(&s, src + i, BYTES);						\
+	  d OP s;									\
+	  std::memcpy(dst + i, &d, BYTES);						\
+	}										\
+      for ( ; i < n ; ++i) dst[i] OP src[i];						\
+    }
+
+#define FETCH_DEFINE_SCALAR_KERNEL(NAME, ISA, BYTES, OP)				\
+    FETCH_KERNEL_TARGET(ISA) static void NAME(T *dst, T value, std::size_t n)	\
+    {											\
+      std::size_t i(0);									\
+      for ( ; i + WIDTH <= n ; i += WIDTH)						\
+	{										\
+	  Vector d;									\
+	  std::memcpy(&d, dst + i, BYTES);						\
+	  d OP value;									\
+	  std::memcpy(dst + i, &d, BYTES);						\
+	}										\
+      for ( ; i < n ; ++i) dst[i] OP value;						\
+    }
+
+FETCH_DEFINE_VECTOR_KERNELS(SSE2, "sse2", 16)
+FETCH_DEFINE_VECTOR_KERNELS(AVX2, "avx2", 32)
+FETCH_DEFINE_VECTOR_KERNELS(AVX512, "avx512f", 64)
+
+#undef FETCH_DEFINE_VECTOR_KERNELS
+#undef FETCH_DEFINE_BINARY_KERNEL
+#undef FETCH_DEFINE_SCALAR_KERNEL
+
+#endif
+
+/*
+ * Whether the CPU (and the OS) can run the given instruction set
+ */
+inline bool Supports(InstructionSet isa)
+{
+#if FETCH_VECTOR_KERNELS
+  switch (isa)
+    {
+    case InstructionSet::SCALAR:
+    case InstructionSet::SSE2:
+      return true;
+    case InstructionSet::AVX2:
+      return __builtin_cpu_supports("avx2");
+    case InstructionSet::AVX512:
+      return __builtin_cpu_supports("avx512f");
+    }
+  return false;
+#else
+  return isa == InstructionSet::SCALAR;
+#endif
+}
+
+/*
+ * Best instruction set of the CPU, looked up once
+ */
+inline InstructionSet BestInstructionSet()
+{
+  static InstructionSet const best = Supports(InstructionSet::AVX512) ? InstructionSet::AVX512
+    : Supports(InstructionSet::AVX2) ? InstructionSet::AVX2
+    : Supports(InstructionSet::SSE2) ? InstructionSet::SSE2
+    : InstructionSet::SCALAR;
+  return best;
+}
+
+/*
+ * Kernels of a given instruction set, which must be supported
+ * Types without vector kernels always get the scalar ones
+ */
+template <typename T>
+KernelTable<T> Kernels(InstructionSet /*isa*/)
+{
+  return MakeTable<Scalar<T>, T>();
+}
+
+#if FETCH_VECTOR_KERNELS
+template <typename T>
+KernelTable<T> VectorKernels(InstructionSet isa)
+{
+  switch (isa)
+    {
+    case InstructionSet::AVX512:
+      return MakeTable<AVX512<T>, T>();
+    case InstructionSet::AVX2:
+      return MakeTable<AVX2<T>, T>();
+    case InstructionSet::SSE2:
+      return MakeTable<SSE2<T>, T>();
+    default:
+      return MakeTable<Scalar<T>, T>();
+    }
+}
+
+template <>
+inline KernelTable<float> Kernels<float>(InstructionSet isa)
+{
+  return VectorKernels<float>(isa);
+}
+
+template <>
+inline KernelTable<double> Kernels<double>(InstructionSet isa)
+{
+  return VectorKernels<double>(isa);
+}
+#endif
+
+/*
+ * Kernels of the best instruction set of the CPU
+ */
+template <typename T>
+KernelTable<T> const &Kernels()
+{
+  static KernelTable<T> const table = Kernels<T>(BestInstructionSet());
+  return table;
+}
+
+}  // namespace kernels
+}  // namespace math
+}  // namespace fetch
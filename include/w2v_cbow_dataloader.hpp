@@ -17,248 +17,114 @@
 //
 //------------------------------------------------------------------------------
 
-#include "dataloader.hpp"
-#include "lcg.hpp"
-#include "tensor.hpp"
-#include "unigram_table.hpp"
-
-#include <exception>
-#include <fstream>
-#include <map>
-#include <random>
-#include <string>
-#include <utility>
+#include "w2v_dataloader.hpp"
 
 namespace fetch {
 namespace ml {
 
+/*
+ * Generates CBOW samples : the context words around a target word ([1 x 2 * window_size], padded
+ * with -1) and the target word followed by negative samples ([1 x negative_samples])
+ * GetNextBatch stacks several of those samples as the rows of [BATCH x ...] tensors
+ */
 template <typename T>
-class CBOWLoader : public DataLoader<fetch::math::Tensor<T, 2>, fetch::math::Tensor<T, 2>>
+class CBOWLoader : public W2VLoader<T>
 {
 public:
-  using ReturnType = std::pair<fetch::math::Tensor<T, 2>, fetch::math::Tensor<T, 2>>;
-  
-public:
+  using ReturnType = typename W2VLoader<T>::ReturnType;
+
   CBOWLoader(uint64_t window_size, uint64_t negative_samples)
-    : currentSentence_(0)
-    , currentWord_(0)
-    , window_size_(window_size)
-    , negative_samples_(negative_samples)
+    : W2VLoader<T>(window_size, negative_samples)
   {}
 
-  virtual uint64_t Size() const
+  /*
+   * Fills every row of t with a sample, so a [BATCH x ...] pair gets BATCH consecutive samples
+   * Wraps around to the beginning of the corpus if it runs out in the middle of a batch
+   */
+  virtual ReturnType &GetNext(ReturnType &t)
   {
-    uint64_t size(0);
-    for (auto const &s : data_)
-    {
-      if ((uint64_t)s.size() > (2 * window_size_))
+    for (uint64_t b(0); b < t.first.shape()[0]; ++b)
       {
-        size += (uint64_t)s.size() - (2 * window_size_);
+	if (b > 0 && this->IsDone())
+	  {
+	    this->Reset();
+	  }
+	FillRow(t, b);
       }
-    }
-    return size;
+    return t;
   }
 
-  virtual bool IsDone() const
+  virtual ReturnType GetNext()
   {
-    if (currentSentence_ >= data_.size())
-    {
-      return true;
-    }
-    else if (currentSentence_ >= data_.size() - 1)  // In the last sentence
-    {
-      if (currentWord_ > data_.at(currentSentence_).size() - (2 * window_size_ + 1))
-      {
-        return true;
-      }
-    }
-    return false;
+    fetch::math::Tensor<T, 2> t({1, this->window_size_ * 2});
+    fetch::math::Tensor<T, 2> label({1, this->negative_samples_});
+    ReturnType p(t, label);
+    return GetNext(p);
   }
 
-  virtual void Reset()
+  ReturnType GetNextBatch(uint64_t batch_size)
   {
-    //    std::random_shuffle(data_.begin(), data_.end());
-    currentSentence_ = 0;
-    currentWord_     = 0;
+    fetch::math::Tensor<T, 2> t({batch_size, this->window_size_ * 2});
+    fetch::math::Tensor<T, 2> label({batch_size, this->negative_samples_});
+    ReturnType p(t, label);
+    return GetNext(p);
   }
 
   /*
-   * Advance the cursor by offset
-   * Used to train on different part of the dataset in a multithreaded environment
+   * Mini-batch where all the samples share the same negatives : t.first is [BATCH x 2 * window_size]
+   * and t.second is [1 x BATCH + K], the target of each row of t.first followed by K negatives
    */
-  void SetOffset(unsigned int offset)
+  ReturnType &GetNextSharedNegatives(ReturnType &t)
   {
-    offset = offset % Size();
-    while (offset > data_[currentSentence_].size())
-      {
-	offset -= data_[currentSentence_].size();
-	currentSentence_++;
-      }
-    if (offset < data_[currentSentence_].size() - window_size_)
+    uint64_t batch_size = t.first.shape()[0];
+    assert(t.second.shape()[0] == 1 && t.second.shape()[1] >= batch_size);
+    for (uint64_t b(0); b < batch_size; ++b)
       {
-	currentWord_ = offset;
-      }
-    else
-      {
-	currentSentence_++;
-	currentWord_ = 0;
-      }
-  }
-  
-  /*
-   * Remove words that appears less than MIN times
-   * This is a destructive operation
-   */
-  void RemoveInfrequent(unsigned int min)
-  {
-    // Removing words while keeping indexes consecutive takes too long
-    // So creating a new object, not the most efficient, but good enought for now
-    CBOWLoader new_loader(window_size_, negative_samples_);
-    std::map<uint64_t, std::pair<std::string, uint64_t>> reverse_vocab;
-    for (auto const &kvp : vocab_)
-      {
-	reverse_vocab[kvp.second.first] = std::make_pair(kvp.first, kvp.second.second);
-      }
-    for (auto const & sentence : data_)
-      {
-	std::string s;
-	for (auto const & word : sentence)
+	if (b > 0 && this->IsDone())
 	  {
-	    if (reverse_vocab[word].second >= min)
-	      {
-		s += reverse_vocab[word].first + " ";
-	      }
+	    this->Reset();
 	  }
-	new_loader.AddData(s);
+	t.second.Set(0, b, T(FillContext(t.first, b)));
+      }
+    for (uint64_t i(batch_size); i < t.second.shape()[1] ; ++i)
+      {
+	t.second.Set(0, i, T(this->unigram_table_.Sample()));
       }
-    data_ = std::move(new_loader.data_);
-    vocab_ = std::move(new_loader.vocab_);
+    return t;
   }
 
-  void InitUnigramTable()
+private:
+  void FillRow(ReturnType &t, uint64_t b)
   {
-    std::vector<uint64_t> frequencies(VocabSize());
-    for (auto const &kvp : GetVocab())
+    t.second.Set(b, 0, T(FillContext(t.first, b)));
+    for (uint64_t i(1); i < this->negative_samples_ ; ++i)
       {
-	frequencies[kvp.second.first] = kvp.second.second;
+	t.second.Set(b, i, T(this->unigram_table_.SampleNegative(t.second.Get(b, 0))));
       }
-    unigram_table_.Reset(1e8, frequencies);
   }
 
-  ReturnType &GetNext(ReturnType &t)
+  // Writes the context words of the current sample in row b, moves to the next one and returns its target word
+  uint64_t FillContext(fetch::math::Tensor<T, 2> &context, uint64_t b)
   {
     // This seems to be one of the most important tricks to get word2vec to train
     // The number of context words changes at each iteration with values in range [1 * 2,
     // window_size_ * 2]
-    uint64_t dynamic_size = rng_() % window_size_ + 1;
-    t.second.Set(0, 0, T(data_[currentSentence_][currentWord_ + dynamic_size]));
+    uint64_t dynamic_size = this->rng_() % this->window_size_ + 1;
+    std::vector<uint64_t> const &sentence = this->CurrentSentence();
+    uint64_t target = sentence[this->currentWord_ + dynamic_size];
     for (uint64_t i(0); i < dynamic_size; ++i)
       {
-	t.first.Set(0, i, T(data_[currentSentence_][currentWord_ + i]));
-	t.first.Set(0, i + dynamic_size, T(data_[currentSentence_][currentWord_ + dynamic_size + i + 1]));
-      }
-    for (uint64_t i(dynamic_size * 2); i < t.first.Size() ; ++i)
-      {
-	t.first.Set(0, i, -1);
-      }
-    for (uint64_t i(1); i < negative_samples_ ; ++i)
-      {
-	t.second.Set(0, i, T(unigram_table_.SampleNegative(t.second.Get(0, 0))));
+	context.Set(b, i, T(sentence[this->currentWord_ + i]));
+	context.Set(b, i + dynamic_size, T(sentence[this->currentWord_ + dynamic_size + i + 1]));
       }
-    currentWord_++;
-    if (currentWord_ >= data_.at(currentSentence_).size() - (2 * window_size_))
-    {
-      currentWord_ = 0;
-      currentSentence_++;
-    }
-    return t;
-  }
-
-  ReturnType GetNext()
-  {
-    fetch::math::Tensor<T, 2> t({1, window_size_ * 2});
-    fetch::math::Tensor<T, 2> label({1, negative_samples_});
-    ReturnType p(t, label);
-    return GetNext(p);
-  }  
-
-  std::size_t VocabSize() const
-  {
-    return vocab_.size();
-  }
-
-  bool AddData(std::string const &s)
-  {
-    std::vector<uint64_t> indexes = StringsToIndexes(PreprocessString(s));
-    if (indexes.size() >= 2 * window_size_ + 1)
-    {
-      data_.push_back(std::move(indexes));
-      return true;
-    }
-    return false;
-  }
-
-  std::map<std::string, std::pair<uint64_t, uint64_t>> const &GetVocab() const
-  {
-    return vocab_;
-  }
-
-  std::string WordFromIndex(uint64_t index)
-  {
-    for (auto const &kvp : vocab_)
-      {
-	if (kvp.second.first == index)
-	  {
-	    return kvp.first;
-	  }
-      }
-    return "";
-  }
-
-private:
-  std::vector<uint64_t> StringsToIndexes(std::vector<std::string> const &strings)
-  {
-    std::vector<uint64_t> indexes;
-    if (strings.size() >= 2 * window_size_ + 1)  // Don't bother processing too short inputs
-    {
-      indexes.reserve(strings.size());
-      for (std::string const &s : strings)
+    for (uint64_t i(dynamic_size * 2); i < context.shape()[1] ; ++i)
       {
-        auto value = vocab_.insert(std::make_pair(s, std::make_pair((uint64_t)(vocab_.size()), 0)));
-        indexes.push_back((*value.first).second.first);
-	value.first->second.second++;
+	context.Set(b, i, -1);
       }
-    }
-    return indexes;
-  }
-
-  std::vector<std::string> PreprocessString(std::string const &s)
-  {
-    std::string result;
-    result.reserve(s.size());
-    for (auto const &c : s)
-    {
-      result.push_back(std::isalpha(c) ? (char)std::tolower(c) : ' ');
-    }
-
-    std::string              word;
-    std::vector<std::string> words;
-    for (std::stringstream ss(result); ss >> word;)
-    {
-      words.push_back(word);
-    }
-    return words;
+    this->Advance();
+    return target;
   }
-
-private:
-  uint64_t                                                currentSentence_;
-  uint64_t                                                currentWord_;
-  uint64_t                                                window_size_;
-  uint64_t                                                negative_samples_;
-  std::map<std::string, std::pair<uint64_t, uint64_t>>    vocab_;
-  std::vector<std::vector<uint64_t>>                      data_;
-  fetch::random::LinearCongruentialGenerator              rng_;
-  UnigramTable                                            unigram_table_;
 };
+
 }  // namespace ml
 }  // namespace fetch
@@ -0,0 +1,412 @@
+#pragma once
+//------------------------------------------------------------------------------
+//
+//   Copyright 2018-2019 Fetch.AI Limited
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//------------------------------------------------------------------------------
+
+#include "dataloader.hpp"
+#include "lcg.hpp"
+#include "tensor.hpp"
+#include "unigram_table.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <string>
+#include <utility>
+
+namespace fetch {
+namespace ml {
+
+/*
+ * Common part of the word2vec data loaders : corpus, vocabulary, unigram table and cursor
+ * A sample is a window of 2 * window_size + 1 words, the derived classes decide how to turn it
+ * into tensors
+ * Copies of a loader share the corpus, the vocabulary and the unigram table, but each copy has its own cursor and
+ * random generator. This is what allows several threads to walk the same dataset concurrently
+ * Data must be added (and subsampling set) before taking copies
+ */
+template <typename T>
+class W2VLoader : public DataLoader<fetch::math::Tensor<T, 2>, fetch::math::Tensor<T, 2>>
+{
+public:
+  using ReturnType = std::pair<fetch::math::Tensor<T, 2>, fetch::math::Tensor<T, 2>>;
+
+  // Subsampling draws words by segments of that many words, to bound memory on one line corpora
+  static constexpr uint64_t SUBSAMPLING_SEGMENT_SIZE = 10000;
+  
+public:
+  W2VLoader(uint64_t window_size, uint64_t negative_samples)
+    : currentSentence_(0)
+    , currentWord_(0)
+    , sentence_offset_(0)
+    , segment_begin_(0)
+    , segment_end_(0)
+    , window_size_(window_size)
+    , negative_samples_(negative_samples)
+    , vocab_(std::make_shared<std::map<std::string, std::pair<uint64_t, uint64_t>>>())
+    , data_(std::make_shared<std::vector<std::vector<uint64_t>>>())
+  {}
+
+  virtual uint64_t Size() const
+  {
+    uint64_t size(0);
+    for (auto const &s : *data_)
+    {
+      if ((uint64_t)s.size() > (2 * window_size_))
+      {
+        size += (uint64_t)s.size() - (2 * window_size_);
+      }
+    }
+    return size;
+  }
+
+  virtual bool IsDone() const
+  {
+    if (currentSentence_ >= data_->size())
+    {
+      return true;
+    }
+    else if (currentSentence_ >= data_->size() - 1)  // In the last sentence
+    {
+      if (currentWord_ > CurrentSentence().size() - (2 * window_size_ + 1))
+      {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  virtual void Reset()
+  {
+    //    std::random_shuffle(data_.begin(), data_.end());
+    currentSentence_ = 0;
+    currentWord_     = 0;
+    sentence_offset_ = 0;
+    segment_begin_   = 0;
+    LoadSegment();
+  }
+
+  /*
+   * Move the cursor to the offset-th sample of the dataset
+   * Used to train on different part of the dataset in a multithreaded environment
+   */
+  void SetOffset(uint64_t offset)
+  {
+    currentSentence_ = 0;
+    currentWord_     = 0;
+    sentence_offset_ = 0;
+    offset = offset % Size();
+    while (offset >= SentenceSize(currentSentence_))
+      {
+	offset -= SentenceSize(currentSentence_);
+	sentence_offset_ += SentenceSize(currentSentence_);
+	currentSentence_++;
+      }
+    if (!keep_probabilities_)
+      {
+	currentWord_ = offset;
+	return;
+      }
+    segment_begin_ = offset - offset % SUBSAMPLING_SEGMENT_SIZE;
+    uint64_t sentence = currentSentence_;
+    uint64_t segment  = segment_begin_;
+    LoadSegment();
+    if (currentSentence_ == sentence && segment_begin_ == segment)
+      {
+	// Start at the same relative position in the shortened segment
+	currentWord_ = (offset - segment_begin_) * (subsampled_segment_.size() - 2 * window_size_) / (segment_end_ - segment_begin_);
+      }
+  }
+
+  /*
+   * Index of the current sample in the full dataset, in [0, Size()]
+   * With subsampling, samples skip the discarded words, so this moves faster than GetNext is called
+   */
+  uint64_t Position() const
+  {
+    if (!keep_probabilities_ || currentSentence_ >= data_->size())
+      {
+	return sentence_offset_ + currentWord_;
+      }
+    uint64_t position = segment_begin_ + currentWord_ * (segment_end_ - segment_begin_) / subsampled_segment_.size();
+    return sentence_offset_ + std::min(position, SentenceSize(currentSentence_) - 1);
+  }
+
+  /*
+   * Randomly discard frequent words as in the original word2vec : a word that makes a fraction f
+   * of the corpus is kept with probability (sqrt(f / sample) + 1) * sample / f
+   * Discarded words are drawn again every time the cursor reaches a new segment of a sentence, so
+   * every epoch sees a different subset. Only the current segment (SUBSAMPLING_SEGMENT_SIZE words
+   * at most, like the original implementation cuts sentences) is kept in memory
+   * sample <= 0 disables subsampling
+   * Must be called after RemoveInfrequent
+   */
+  void SetSubsampling(double sample)
+  {
+    if (sample <= 0)
+      {
+	keep_probabilities_.reset();
+      }
+    else
+      {
+	std::vector<uint64_t> frequencies = Frequencies();
+	double threshold = sample * double(std::accumulate(frequencies.begin(), frequencies.end(), uint64_t(0)));
+	keep_probabilities_ = std::make_shared<std::vector<double>>(frequencies.size());
+	for (std::size_t i(0) ; i < frequencies.size() ; ++i)
+	  {
+	    (*keep_probabilities_)[i] = (std::sqrt(double(frequencies[i]) / threshold) + 1) * threshold / double(frequencies[i]);
+	  }
+      }
+    Reset();
+  }
+
+  /*
+   * Reseed the random generators (window size and negative sampling)
+   * Each copy of a loader used by a different thread should get its own seed
+   */
+  void Seed(uint64_t seed)
+  {
+    rng_.Seed(seed);
+    unigram_table_.Seed(seed);
+  }
+  
+  /*
+   * Remove words that appears less than MIN times
+   * This is a destructive operation
+   */
+  void RemoveInfrequent(unsigned int min)
+  {
+    // Removing words while keeping indexes consecutive takes too long
+    // So rebuilding the dataset from scratch, not the most efficient, but good enought for now
+    std::map<uint64_t, std::pair<std::string, uint64_t>> reverse_vocab;
+    for (auto const &kvp : *vocab_)
+      {
+	reverse_vocab[kvp.second.first] = std::make_pair(kvp.first, kvp.second.second);
+      }
+    std::shared_ptr<std::vector<std::vector<uint64_t>>> old_data = data_;
+    data_ = std::make_shared<std::vector<std::vector<uint64_t>>>();
+    vocab_ = std::make_shared<std::map<std::string, std::pair<uint64_t, uint64_t>>>();
+    for (auto const & sentence : *old_data)
+      {
+	std::string s;
+	for (auto const & word : sentence)
+	  {
+	    if (reverse_vocab[word].second >= min)
+	      {
+		s += reverse_vocab[word].first + " ";
+	      }
+	  }
+	AddData(s);
+      }
+  }
+
+  void InitUnigramTable()
+  {
+    unigram_table_.Reset(1e8, Frequencies());
+  }
+
+  /*
+   * Number of occurences of each word, indexed by word index
+   */
+  std::vector<uint64_t> Frequencies() const
+  {
+    std::vector<uint64_t> frequencies(VocabSize());
+    for (auto const &kvp : GetVocab())
+      {
+	frequencies[kvp.second.first] = kvp.second.second;
+      }
+    return frequencies;
+  }
+
+  virtual ReturnType &GetNext(ReturnType &t) = 0;
+
+  using DataLoader<fetch::math::Tensor<T, 2>, fetch::math::Tensor<T, 2>>::GetNext;
+
+  std::size_t VocabSize() const
+  {
+    return vocab_->size();
+  }
+
+  bool AddData(std::string const &s)
+  {
+    std::vector<uint64_t> indexes = StringsToIndexes(PreprocessString(s));
+    if (indexes.size() >= 2 * window_size_ + 1)
+    {
+      data_->push_back(std::move(indexes));
+      return true;
+    }
+    return false;
+  }
+
+  std::map<std::string, std::pair<uint64_t, uint64_t>> const &GetVocab() const
+  {
+    return *vocab_;
+  }
+
+  std::string WordFromIndex(uint64_t index)
+  {
+    for (auto const &kvp : *vocab_)
+      {
+	if (kvp.second.first == index)
+	  {
+	    return kvp.first;
+	  }
+      }
+    return "";
+  }
+
+protected:
+  /*
+   * Move the cursor to the next window, possibly in the next sentence
+   */
+  void Advance()
+  {
+    currentWord_++;
+    if (currentWord_ >= CurrentSentence().size() - (2 * window_size_))
+    {
+      currentWord_ = 0;
+      if (keep_probabilities_ && segment_end_ < (*data_)[currentSentence_].size())
+	{
+	  segment_begin_ = segment_end_;
+	}
+      else
+	{
+	  sentence_offset_ += SentenceSize(currentSentence_);
+	  currentSentence_++;
+	  segment_begin_ = 0;
+	}
+      LoadSegment();
+    }
+  }
+
+  /*
+   * Words under the cursor : the current sentence, or the current segment of it after subsampling
+   */
+  std::vector<uint64_t> const &CurrentSentence() const
+  {
+    return keep_probabilities_ ? subsampled_segment_ : (*data_)[currentSentence_];
+  }
+
+  /*
+   * Number of samples that can be generated from a sentence
+   */
+  uint64_t SentenceSize(uint64_t sentence) const
+  {
+    return (*data_)[sentence].size() - (2 * window_size_);
+  }
+
+private:
+  /*
+   * Draw which words of the segment starting at segment_begin_ are kept
+   * Segments left too short to contain a full window are skipped
+   */
+  void LoadSegment()
+  {
+    if (!keep_probabilities_)
+      {
+	return;
+      }
+    while (currentSentence_ < data_->size())
+      {
+	std::vector<uint64_t> const &sentence = (*data_)[currentSentence_];
+	segment_end_ = std::min<uint64_t>(segment_begin_ + SUBSAMPLING_SEGMENT_SIZE, sentence.size());
+	subsampled_segment_.clear();
+	for (uint64_t i(segment_begin_) ; i < segment_end_ ; ++i)
+	  {
+	    if ((*keep_probabilities_)[sentence[i]] > rng_.AsDouble())
+	      {
+		subsampled_segment_.push_back(sentence[i]);
+	      }
+	  }
+	if (subsampled_segment_.size() > 2 * window_size_)
+	  {
+	    return;
+	  }
+	currentWord_ = 0;
+	if (segment_end_ < sentence.size())
+	  {
+	    segment_begin_ = segment_end_;
+	  }
+	else
+	  {
+	    sentence_offset_ += SentenceSize(currentSentence_);
+	    currentSentence_++;
+	    segment_begin_ = 0;
+	  }
+      }
+  }
+
+  std::vector<uint64_t> StringsToIndexes(std::vector<std::string> const &strings)
+  {
+    std::vector<uint64_t> indexes;
+    if (strings.size() >= 2 * window_size_ + 1)  // Don't bother processing too short inputs
+    {
+      indexes.reserve(strings.size());
+      for (std::string const &s : strings)
+      {
+        auto value = vocab_->insert(std::make_pair(s, std::make_pair((uint64_t)(vocab_->size()), 0)));
+        indexes.push_back((*value.first).second.first);
+	value.first->second.second++;
+      }
+    }
+    return indexes;
+  }
+
+  std::vector<std::string> PreprocessString(std::string const &s)
+  {
+    std::string result;
+    result.reserve(s.size());
+    for (auto const &c : s)
+    {
+      result.push_back(std::isalpha(c) ? (char)std::tolower(c) : ' ');
+    }
+
+    std::string              word;
+    std::vector<std::string> words;
+    for (std::stringstream ss(result); ss >> word;)
+    {
+      words.push_back(word);
+    }
+    return words;
+  }
+
+protected:
+  uint64_t                                                currentSentence_;
+  uint64_t                                                currentWord_;
+  uint64_t                                                sentence_offset_; // Samples in the sentences before the current one
+  uint64_t                                                segment_begin_;   // Subsampling only, range of the current sentence
+  uint64_t                                                segment_end_;     // in subsampled_segment_
+  uint64_t                                                window_size_;
+  uint64_t                                                negative_samples_;
+  std::shared_ptr<std::map<std::string, std::pair<uint64_t, uint64_t>>> vocab_; // Shared by copies
+  std::shared_ptr<std::vector<std::vector<uint64_t>>>     data_;
+  fetch::random::LinearCongruentialGenerator              rng_;
+  UnigramTable                                            unigram_table_;
+  std::shared_ptr<std::vector<double>>                    keep_probabilities_; // Shared by copies, null without subsampling
+  std::vector<uint64_t>                                   subsampled_segment_;
+};
+
+template <typename T>
+constexpr uint64_t W2VLoader<T>::SUBSAMPLING_SEGMENT_SIZE;
+
+}  // namespace ml
+}  // namespace fetch
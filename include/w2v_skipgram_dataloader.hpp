@@ -0,0 +1,83 @@
+#pragma once
+//------------------------------------------------------------------------------
+//
+//   Copyright 2018-2019 Fetch.AI Limited
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//------------------------------------------------------------------------------
+
+#include "w2v_dataloader.hpp"
+
+namespace fetch {
+namespace ml {
+
+/*
+ * Generates Skip-gram samples : the center word of a window ([1 x 1]) and, for every context word
+ * of that window, one row made of the context word followed by negative samples
+ * ([2 * window_size x negative_samples]). Unused rows (dynamic window) start with -1
+ * Grouping all the pairs of a window in one sample lets the trainer load the center row only once
+ */
+template <typename T>
+class SkipGramLoader : public W2VLoader<T>
+{
+public:
+  using ReturnType = typename W2VLoader<T>::ReturnType;
+
+  SkipGramLoader(uint64_t window_size, uint64_t negative_samples)
+    : W2VLoader<T>(window_size, negative_samples)
+  {}
+
+  virtual ReturnType &GetNext(ReturnType &t)
+  {
+    // Same dynamic window trick as CBOW, the number of context words is in range [1 * 2,
+    // window_size_ * 2]
+    uint64_t dynamic_size = this->rng_() % this->window_size_ + 1;
+    std::vector<uint64_t> const &sentence = this->CurrentSentence();
+    uint64_t center = this->currentWord_ + this->window_size_;
+    t.first.Set(0, 0, T(sentence[center]));
+    uint64_t row(0);
+    for (uint64_t i(1); i <= dynamic_size; ++i)
+      {
+	SetRow(t.second, row++, sentence[center - i]);
+	SetRow(t.second, row++, sentence[center + i]);
+      }
+    for (; row < t.second.shape()[0] ; ++row)
+      {
+	t.second.Set(row, 0, -1);
+      }
+    this->Advance();
+    return t;
+  }
+
+  virtual ReturnType GetNext()
+  {
+    fetch::math::Tensor<T, 2> t({1, 1});
+    fetch::math::Tensor<T, 2> label({this->window_size_ * 2, this->negative_samples_});
+    ReturnType p(t, label);
+    return GetNext(p);
+  }
+
+private:
+  void SetRow(fetch::math::Tensor<T, 2> &labels, uint64_t row, uint64_t context_word)
+  {
+    labels.Set(row, 0, T(context_word));
+    for (uint64_t i(1); i < this->negative_samples_ ; ++i)
+      {
+	labels.Set(row, i, T(this->unigram_table_.SampleNegative(context_word)));
+      }
+  }
+};
+
+}  // namespace ml
+}  // namespace fetch
@@ -50,6 +50,17 @@ public:
   virtual void                           Step(typename T::Type learningRate) = 0;
   virtual struct fetch::ml::StateDict<T> StateDict() const                   = 0;
   virtual void LoadStateDict(struct fetch::ml::StateDict<T> const &dict)     = 0;
+
+  /**
+   * Direct-update SGD : Backward applies learningRate * gradient straight to the weights instead
+   * of accumulating it for Step, which then has nothing left to do
+   * A learning rate of 0 goes back to accumulating
+   * @return false if the op doesn't support it (it keeps accumulating)
+   */
+  virtual bool SetDirectUpdate(typename T::Type /*learningRate*/)
+  {
+    return false;
+  }
 };
 
 template <class T, std::uint64_t OUTPUT_RANK>
@@ -66,7 +77,7 @@ public:
   Weights()          = default;
   virtual ~Weights() = default;
 
-  virtual std::vector<ArrayType> Backward(
+  virtual std::vector<ArrayType> &Backward(
       std::vector<std::reference_wrapper<ArrayType const>> const &inputs,
       ArrayType const &                                           errorSignal,
       std::vector<ArrayType>                                     &output)
@@ -87,13 +98,15 @@ public:
     return ret;
   }
 
+  /*
+   * weights -= learningRate * gradient, then gradient = 0, in a single pass : Drain clears each
+   * element of the gradient right after reading it
+   */
   virtual void Step(typename T::Type learningRate)
   {
-    this->gradient_accumulation_->InlineMultiply(-learningRate);
-    this->output_->InlineAdd(*gradient_accumulation_);
     // Major DL framework do not do that, but as I can't think of any reason why, I'll leave it here
     // for convenience. Remove if needed -- Pierre
-    gradient_accumulation_->Fill(typename T::Type(0));
+    *this->output_ += fetch::math::Drain(*gradient_accumulation_) * -learningRate;
   }
 
   /**
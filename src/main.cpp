@@ -1,15 +1,30 @@
+#include <atomic>
+#include <chrono>
 #include <fstream>
 #include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <thread>
 
 #include "averaged_embeddings.hpp"
+#include "cbow_hierarchical_softmax_trainer.hpp"
+#include "cbow_negative_sampling_trainer.hpp"
+#include "cbow_shared_negatives_trainer.hpp"
 #include "embeddings.hpp"
 #include "graph.hpp"
+#include "huffman_tree.hpp"
 #include "matrix_multiply.hpp"
 #include "inplace_transpose.hpp"
 #include "placeholder.hpp"
 #include "sigmoid.hpp"
+#include "shared_memory_averager.hpp"
+#include "sigmoid_table.hpp"
+#include "skipgram_negative_sampling_trainer.hpp"
+#include "spsc_ring_buffer.hpp"
+#include "table_sigmoid.hpp"
 #include "tensor.hpp"
 #include "w2v_cbow_dataloader.hpp"
+#include "w2v_skipgram_dataloader.hpp"
 
 using namespace fetch::ml;
 using namespace fetch::ml::ops;
@@ -18,8 +33,36 @@ using namespace fetch::ml::ops;
 #define NB_EPOCH 10
 #define NEGATIVE_SAMPLES 25
 #define MINIMUM_WORD_FREQUENCY 5
+#define WINDOW_SIZE 5
+#define NB_THREADS 1
+#define NB_PROCESSES 1
+#define SYNC_INTERVAL 1000000
 #define OUTPUT_FILE "vector.bin"
 
+// Number of samples a thread processes before publishing its progress to the others
+#define PROGRESS_UPDATE_INTERVAL 10000
+
+using ArrayType = fetch::math::Tensor<float, 2>;
+
+/*
+ * Command line options
+ */
+struct Options
+{
+  unsigned int             nb_threads           = NB_THREADS;    // Per process
+  unsigned int             nb_processes         = NB_PROCESSES;
+  uint64_t                 sync_interval        = SYNC_INTERVAL; // Words each process trains on between two averagings
+  bool                     use_graph            = false;
+  uint64_t                 batch_size           = 1;    // Graph or shared negatives only
+  bool                     shared_negatives     = false;
+  bool                     exact_sigmoid        = false;
+  double                   sample               = 0;    // Subsampling threshold, 0 to disable
+  std::size_t              prefetch             = 0;    // Ring capacity, 0 loads samples on the training thread
+  bool                     skipgram             = false;
+  bool                     hierarchical_softmax = false;
+  std::vector<std::string> corpus_files;
+};
+
 std::string readFile(std::string const &path)
 {
   std::ifstream t(path);
@@ -42,78 +85,515 @@ void saveVectors(std::string const &output_file,
   myfile.close();
 }
 
-int main(int ac, char **av)
+/*
+ * State owned by a single training thread : its own cursor on the dataset and its own model
+ * All the models are built on top of the same embedding matrices, which are updated without
+ * any locking (Hogwild). Collisions are rare as each step only touches a few rows
+ * The model is one of the fused trainers (default) or the generic graph (for experimentation)
+ */
+template <typename LoaderType>
+struct Worker
 {
-  std::cout << "Word2Vec" << std::endl;
-  if (ac < 2)
+  Worker(LoaderType const &l, uint64_t seed, ArrayType &words, ArrayType &weights,
+	 HuffmanTree const &tree, fetch::math::SigmoidTable<float> const *sigmoid_table, Options const &options)
+    : loader(l)
+  {
+    loader.Seed(seed);
+    if (options.hierarchical_softmax)
+      {
+	cbow_hs.reset(new CBOWHierarchicalSoftmaxTrainer<float>(words, weights, tree));
+	cbow_hs->SetSigmoidTable(sigmoid_table);
+      }
+    else if (options.use_graph)
+      {
+	graph.reset(new Graph<ArrayType>());
+	context_node = graph->AddNode<PlaceHolder<ArrayType, 2>>("Context", {});
+	if (options.skipgram)
+	  {
+	    // The center word alone is the input of Skip-gram, a plain embedding lookup
+	    graph->AddNode<Embeddings<ArrayType>>("Words", {"Context"}, words);
+	    pairs = true;
+	  }
+	else
+	  {
+	    graph->AddNode<AveragedEmbeddings<ArrayType>>("Words", {"Context"}, words);
+	  }
+	target_node = graph->AddNode<PlaceHolder<ArrayType, 2>>("Target", {});
+	graph->AddNode<Embeddings<ArrayType>>("Weights", {"Target"}, weights);
+	graph->AddNode<InplaceTranspose<ArrayType>>("WeightsTranspose", {"Weights"});
+	dot_product_node = graph->AddNode<MatrixMultiply<ArrayType>>("DotProduct", {"Words", "WeightsTranspose"});
+	if (sigmoid_table)
+	  {
+	    sigmoid_node = graph->AddNode<TableSigmoid<ArrayType>>("Sigmoid", {"DotProduct"}, sigmoid_table->Size(), sigmoid_table->Clamp());
+	  }
+	else
+	  {
+	    sigmoid_node = graph->AddNode<Sigmoid<ArrayType>>("Sigmoid", {"DotProduct"});
+	  }
+	graph->Compile();
+	ResizeTargets(options.batch_size);
+      }
+    else if (options.skipgram)
+      {
+	skipgram.reset(new SkipGramNegativeSamplingTrainer<float>(words, weights));
+	skipgram->SetSigmoidTable(sigmoid_table);
+      }
+    else if (options.shared_negatives)
+      {
+	cbow_shared.reset(new CBOWSharedNegativesTrainer<float>(words, weights));
+	cbow_shared->SetSigmoidTable(sigmoid_table);
+      }
+    else
+      {
+	cbow.reset(new CBOWNegativeSamplingTrainer<float>(words, weights));
+	cbow->SetSigmoidTable(sigmoid_table);
+      }
+  }
+
+  void Step(typename LoaderType::ReturnType const &sample, float learning_rate)
+  {
+    if (cbow)
+      {
+	cbow->Step(sample.first, sample.second, learning_rate);
+      }
+    else if (skipgram)
+      {
+	skipgram->Step(sample.first, sample.second, learning_rate);
+      }
+    else if (cbow_shared)
+      {
+	cbow_shared->Step(sample.first, sample.second, learning_rate);
+      }
+    else if (cbow_hs)
+      {
+	cbow_hs->Step(sample.first, sample.second, learning_rate);
+      }
+    else if (pairs)
+      {
+	// Skip-gram : one graph step per (center, context word) pair of the window
+	for (uint64_t p(0) ; p < sample.second.shape()[0] ; ++p)
+	  {
+	    if (sample.second.Get(p, 0) < 0)
+	      {
+		continue; // Unused row of the dynamic window
+	      }
+	    pair_targets.Slice(0).Copy(sample.second.Slice(p));
+	    GraphStep(sample.first, pair_targets, learning_rate);
+	  }
+      }
+    else
+      {
+	GraphStep(sample.first, sample.second, learning_rate);
+      }
+  }
+
+  void GraphStep(ArrayType const &context, ArrayType const &targets, float learning_rate)
+  {
+    // Several samples are stacked as rows when training with mini-batches
+    bool batch = context.shape()[0] > 1;
+    if (error.shape()[0] != context.shape()[0])
+      {
+	ResizeTargets(context.shape()[0]); // Last, partial batch of a chunk
+      }
+    graph->BindInput(context_node, context, batch);
+    graph->BindInput(target_node, targets, batch);
+
+    auto const &prediction = graph->Evaluate(sigmoid_node);
+    error.Assign(ground_truth - prediction);
+    // This is not a mistake : the original Google C code does this very strange thing
+    // They clamp the output using a sigmoid, but never actually run the backward pass for it
+    // The embeddings apply their updates during the backward pass, like the fused trainers,
+    // so Step only has the ops that can't do that left to update
+    graph->SetDirectUpdate(learning_rate);
+    graph->BackPropagate(dot_product_node, error);
+    graph->Step(learning_rate);
+  }
+
+  // Graph only, one row per sample of a batch
+  void ResizeTargets(uint64_t batch_size)
+  {
+    error = ArrayType({batch_size, NEGATIVE_SAMPLES});
+    ground_truth = ArrayType({batch_size, NEGATIVE_SAMPLES});
+    for (uint64_t b(0) ; b < batch_size ; ++b)
+      {
+	ground_truth.Set(b, 0, 1.0f); // First sample is positive, all others are negatives
+      }
+  }
+
+  // The graph reads the samples given to Step in place, they must not be used after this
+  void ReleaseSamples()
+  {
+    if (graph)
+      {
+	graph->UnbindInput(context_node);
+	graph->UnbindInput(target_node);
+      }
+  }
+
+  LoaderType                                              loader;
+  std::unique_ptr<CBOWNegativeSamplingTrainer<float>>     cbow;
+  std::unique_ptr<SkipGramNegativeSamplingTrainer<float>> skipgram;
+  std::unique_ptr<CBOWHierarchicalSoftmaxTrainer<float>>  cbow_hs;
+  std::unique_ptr<CBOWSharedNegativesTrainer<float>>      cbow_shared;
+  std::unique_ptr<Graph<ArrayType>>                       graph;
+  NodeHandle<PlaceHolder<ArrayType, 2>>                   context_node;         // Graph only
+  NodeHandle<PlaceHolder<ArrayType, 2>>                   target_node;          // Graph only
+  NodeHandle<MatrixMultiply<ArrayType>>                   dot_product_node;     // Graph only
+  NodeHandle<>                                            sigmoid_node;         // Graph only
+  ArrayType                                               error{{1, 1}};        // Graph only
+  ArrayType                                               ground_truth{{1, 1}}; // Graph only
+  bool                                                    pairs = false;        // Skip-gram graph
+  ArrayType                                               pair_targets{{1, NEGATIVE_SAMPLES}}; // Skip-gram graph
+
+  // Prefetching statistics
+  uint64_t                                                data_waits        = 0; // Trainer found no sample ready
+  double                                                  data_wait_seconds = 0;
+  uint64_t                                                loader_waits      = 0; // Loader found the ring full
+};
+
+/*
+ * A sample (or mini-batch) ready for training, and how far it moved the cursor in the dataset
+ */
+template <typename LoaderType>
+struct Sample
+{
+  typename LoaderType::ReturnType data;
+  uint64_t                        advance = 0;
+};
+
+/*
+ * Allocate a sample with the shapes expected by the worker's model
+ * Moves the cursor of the loader
+ */
+template <typename LoaderType>
+Sample<LoaderType> makeSample(Worker<LoaderType> &worker, uint64_t batch_size)
+{
+  worker.loader.Reset();
+  Sample<LoaderType> sample{worker.loader.GetNext()};
+  if (batch_size > 1)
     {
-      std::cerr << "Usage : " << av[0] << " CORPUS_FILES ..." << std::endl;
-      return 1;
+      sample.data.first = ArrayType({batch_size, sample.data.first.shape()[1]});
+      sample.data.second = ArrayType({batch_size, sample.data.second.shape()[1]});
+    }
+  if (worker.cbow_shared)
+    {
+      // One row with the target of each context, followed by the negatives shared by the whole batch
+      sample.data.second = ArrayType({1, batch_size + sample.data.second.shape()[1] - 1});
     }
+  return sample;
+}
+
+/*
+ * Keep only the first rows samples of a mini-batch, for the last batch of a chunk
+ * With shared negatives the targets are a single row : one per sample, then the negatives
+ */
+template <typename LoaderType>
+void shrinkBatch(Sample<LoaderType> &sample, uint64_t rows)
+{
+  uint64_t batch_size = sample.data.first.shape()[0];
+  if (rows >= batch_size)
+    {
+      return;
+    }
+  auto &targets = sample.data.second;
+  targets = (targets.shape()[0] == 1) ? ArrayType({1, targets.shape()[1] - batch_size + rows})
+                                      : ArrayType({rows, targets.shape()[1]});
+  sample.data.first = ArrayType({rows, sample.data.first.shape()[1]});
+}
 
+/*
+ * Load the next sample(s) of a worker
+ * Only the CBOW loader knows how to share the negatives between the samples of a mini-batch
+ */
+template <typename LoaderType>
+void nextSample(Worker<LoaderType> &worker, typename LoaderType::ReturnType &sample)
+{
+  worker.loader.GetNext(sample);
+}
+
+void nextSample(Worker<CBOWLoader<float>> &worker, CBOWLoader<float>::ReturnType &sample)
+{
+  if (worker.cbow_shared)
+    {
+      worker.loader.GetNextSharedNegatives(sample);
+    }
+  else
+    {
+      worker.loader.GetNext(sample);
+    }
+}
+
+/*
+ * Fill sample with the next data of the worker, going back to the beginning at the end of the dataset
+ * Progress is measured as a position in the dataset, so words discarded by subsampling count as
+ * processed as well (like in the original implementation)
+ */
+template <typename LoaderType>
+void loadSample(Worker<LoaderType> &worker, Sample<LoaderType> &sample, uint64_t epoch_size)
+{
+  if (worker.loader.IsDone())
+    {
+      worker.loader.Reset();
+    }
+  // Retrieve next data sample
+  // For CBOW the data consits of the context words [1x10] (sample.first)
+  //                  and the words to predict [1x25] (sample.second) where :
+  // the first one is the positive sample (the word that was actually part of the corpus)
+  // the 24th others are negatives samples, choosen according to the unigram table
+  // For Skip-gram there is one row of words to predict per context word
+  // With mini-batches, the loader fills one row per sample
+  uint64_t position = worker.loader.Position();
+  nextSample(worker, sample.data);
+  uint64_t new_position = worker.loader.Position();
+  sample.advance = (new_position >= position) ? new_position - position : epoch_size - position + new_position;
+}
+
+/*
+ * Loader thread of the prefetching pipeline : pushes the samples of a chunk into the ring
+ * Blocks whenever the trainer is more than a ring behind
+ */
+template <typename LoaderType>
+void prefetch(Worker<LoaderType> &worker, uint64_t first_sample, uint64_t nb_samples,
+	      SPSCRingBuffer<Sample<LoaderType>> &ring)
+{
+  uint64_t epoch_size = worker.loader.Size();
+  worker.loader.SetOffset(first_sample);
+  uint64_t chunk_processed(0);
+  while (chunk_processed < nb_samples)
+    {
+      Sample<LoaderType> *sample = ring.BeginPush();
+      if (!sample)
+	{
+	  break;
+	}
+      shrinkBatch(*sample, nb_samples - chunk_processed);
+      loadSample(worker, *sample, epoch_size);
+      chunk_processed += sample->advance;
+      ring.EndPush();
+    }
+  ring.Close();
+}
+
+/*
+ * Train a worker on nb_samples consecutive samples starting at first_sample, batch_size at a time
+ * processed is shared between all threads (and processes) and drives the learning rate decay
+ * With prefetching, samples are prepared by a separate loader thread and this one only trains
+ */
+template <typename LoaderType>
+void train(Worker<LoaderType> &worker, uint64_t first_sample, uint64_t nb_samples, Options const &options,
+	   std::atomic<uint64_t> &processed, uint64_t total_number_iterations,
+	   float initial_learning_rate)
+{
+  float learning_rate = initial_learning_rate;
+  float minimum_learning_rate = initial_learning_rate * 0.0001;
+  uint64_t global_processed = processed.load(std::memory_order_relaxed);
+  uint64_t local_processed(0);
+
+  auto step = [&](Sample<LoaderType> const &sample)
+    {
+      // Adjust the learning rate
+      uint64_t done = std::min(global_processed + local_processed, total_number_iterations);
+      learning_rate = std::max((static_cast<float>(total_number_iterations - done) / total_number_iterations) * initial_learning_rate, minimum_learning_rate);
+      worker.Step(sample.data, learning_rate);
+
+      local_processed += sample.advance;
+      if (local_processed >= PROGRESS_UPDATE_INTERVAL)
+	{
+	  global_processed = processed.fetch_add(local_processed, std::memory_order_relaxed) + local_processed;
+	  local_processed = 0;
+	}
+    };
+
+  if (options.prefetch)
+    {
+      // Every slot gets its own buffers, cloned from a single sample to only build it once
+      Sample<LoaderType> prototype = makeSample(worker, options.batch_size);
+      SPSCRingBuffer<Sample<LoaderType>> ring(options.prefetch, [&]() {
+	  return Sample<LoaderType>{{prototype.data.first.Clone(), prototype.data.second.Clone()}, 0};
+	});
+      std::thread loader_thread(prefetch<LoaderType>, std::ref(worker), first_sample, nb_samples, std::ref(ring));
+      while (Sample<LoaderType> const *sample = ring.BeginPop())
+	{
+	  step(*sample);
+	  ring.EndPop();
+	}
+      loader_thread.join();
+      worker.data_waits += ring.ConsumerWaits();
+      worker.data_wait_seconds += ring.ConsumerWaitSeconds();
+      worker.loader_waits += ring.ProducerWaits();
+    }
+  else
+    {
+      uint64_t epoch_size = worker.loader.Size();
+      Sample<LoaderType> sample = makeSample(worker, options.batch_size);
+      worker.loader.SetOffset(first_sample);
+      uint64_t chunk_processed(0);
+      while (chunk_processed < nb_samples)
+	{
+	  shrinkBatch(sample, nb_samples - chunk_processed);
+	  loadSample(worker, sample, epoch_size);
+	  step(sample);
+	  chunk_processed += sample.advance;
+	}
+    }
+  // The samples are gone with this scope
+  worker.ReleaseSamples();
+  processed.fetch_add(local_processed, std::memory_order_relaxed);
+}
+
+template <typename LoaderType>
+int run(Options const &options)
+{
   // Loading the text data
-  fetch::ml::CBOWLoader<float> loader(5, NEGATIVE_SAMPLES);
-  for (int i(1) ; i < ac ; ++i)
-    loader.AddData(readFile(av[i]));
+  // Hierarchical softmax only needs the target word, so no negative samples are drawn
+  LoaderType loader(WINDOW_SIZE, options.hierarchical_softmax ? 1 : NEGATIVE_SAMPLES);
+  for (auto const &f : options.corpus_files)
+    loader.AddData(readFile(f));
   loader.RemoveInfrequent(MINIMUM_WORD_FREQUENCY);
-  loader.InitUnigramTable();
+  loader.SetSubsampling(options.sample);
+  HuffmanTree tree;
+  if (options.hierarchical_softmax)
+    {
+      tree.Build(loader.Frequencies());
+    }
+  else
+    {
+      loader.InitUnigramTable();
+    }
   std::cout << "Vocab size : " << loader.VocabSize() << std::endl;
 
   // Allocating and initialising the matrix that contains word vectors
-  fetch::math::Tensor<float, 2> word_embeding_matrix = fetch::math::Tensor<float, 2>({loader.VocabSize(), EMBEDDINGS_SIZE});
+  ArrayType word_embeding_matrix = ArrayType({loader.VocabSize(), EMBEDDINGS_SIZE});
   for (auto &e : word_embeding_matrix)
     e = static_cast <float> (rand()) / static_cast <float> (RAND_MAX) / EMBEDDINGS_SIZE;
 
-  // Setting up the graph
-  Graph<fetch::math::Tensor<float, 2>> graph;
-  graph.AddNode<PlaceHolder<fetch::math::Tensor<float, 2>, 2>>("Context", {});
-  graph.AddNode<AveragedEmbeddings<fetch::math::Tensor<float, 2>>>("Words", {"Context"}, word_embeding_matrix);
-  graph.AddNode<PlaceHolder<fetch::math::Tensor<float, 2>, 2>>("Target", {});
-  graph.AddNode<Embeddings<fetch::math::Tensor<float, 2>>>("Weights", {"Target"}, loader.VocabSize(), EMBEDDINGS_SIZE);
-  graph.AddNode<InplaceTranspose<fetch::math::Tensor<float, 2>>>("WeightsTranspose", {"Weights"});  
-  graph.AddNode<MatrixMultiply<fetch::math::Tensor<float, 2>>>("DotProduct", {"Words", "WeightsTranspose"});
-  graph.AddNode<Sigmoid<fetch::math::Tensor<float, 2>>>("Sigmoid", {"DotProduct"});
+  // The output weights are shared between all workers as well
+  // With hierarchical softmax there is one row per inner node of the tree, initialised to zero
+  ArrayType weights_matrix = ArrayType({options.hierarchical_softmax ? std::max<uint64_t>(tree.NbInnerNodes(), 1) : loader.VocabSize(), EMBEDDINGS_SIZE});
+  if (!options.hierarchical_softmax)
+    {
+      Weights<ArrayType, 2>::Initialise(weights_matrix, loader.VocabSize(), EMBEDDINGS_SIZE);
+    }
+
+  // Precomputed sigmoid shared by all the models, unless the exact one was asked for
+  fetch::math::SigmoidTable<float> sigmoid_table;
+
+  // With several processes, each one trains its own copy of the matrices on a shard of the dataset
+  // and they are averaged every sync_interval words. They all start from the same initialisation
+  StateDict<ArrayType> model;
+  model.dict_["Words"].weights_ = std::make_shared<ArrayType>(word_embeding_matrix);
+  model.dict_["Weights"].weights_ = std::make_shared<ArrayType>(weights_matrix);
+  std::unique_ptr<SharedMemoryAverager<ArrayType>> averager;
+  unsigned int rank(0);
+  unsigned int nb_processes = options.nb_processes;
+  std::atomic<uint64_t> processed_counter(0);
+  if (nb_processes > 1)
+    {
+      averager.reset(new SharedMemoryAverager<ArrayType>(model, nb_processes));
+      std::cout << "Processes : " << nb_processes << std::endl;
+      rank = averager->Fork();
+    }
+  // The learning rate decays with the progress of all the processes
+  std::atomic<uint64_t> &processed = averager ? averager->Processed() : processed_counter;
+  bool verbose = (rank == 0);
+
+  // Setting up one model and one data cursor per thread
+  unsigned int nb_threads = options.nb_threads;
+  std::vector<std::unique_ptr<Worker<LoaderType>>> workers;
+  for (unsigned int t(0) ; t < nb_threads ; ++t)
+    {
+      workers.emplace_back(new Worker<LoaderType>(loader, rank * nb_threads + t + 1, word_embeding_matrix, weights_matrix, tree,
+					      options.exact_sigmoid ? nullptr : &sigmoid_table, options));
+    }
+  if (verbose)
+    {
+      std::cout << "Threads : " << nb_threads << std::endl;
+    }
 
   // Learning rate
-  float initial_learning_rate = 0.05f;
-  float learning_rate = initial_learning_rate;
-  float minimum_learning_rate = initial_learning_rate * 0.0001;
+  float initial_learning_rate = options.skipgram ? 0.025f : 0.05f;
 
   // Training loop
-  auto sample = loader.GetNext();
-  fetch::math::Tensor<float, 2> error({1, 25}); // This buffer store the error
-  fetch::math::Tensor<float, 2> ground_truth({1, 25}); // This one the ground truth
-  ground_truth.Fill(0); // All negative samples
-  ground_truth.Set(0, 0, 1.0f); // Except first one
-  unsigned int total_number_iterations = NB_EPOCH * loader.Size();
-  unsigned int i(0);
+  uint64_t epoch_size = loader.Size();
+  uint64_t total_number_iterations = NB_EPOCH * epoch_size;
+  // Each process trains on its own contiguous shard of the dataset, in rounds separated by averagings
+  // All the processes must average the same number of times, so that only depends on the shard size
+  uint64_t shard_size = epoch_size / nb_processes;
+  uint64_t shard_begin = rank * shard_size;
+  uint64_t nb_rounds = averager ? std::max<uint64_t>(1, (shard_size + options.sync_interval - 1) / options.sync_interval) : 1;
+  if (rank == nb_processes - 1)
+    {
+      shard_size = epoch_size - shard_begin;
+    }
   for (int epoch(0) ; epoch < NB_EPOCH ; ++epoch)
     {
-      std::cout << "Epoch " << epoch << std::endl;
-      loader.Reset();
-      while (!loader.IsDone())
+      if (verbose)
 	{
-	  // Retrieve next data sample
-	  // The data consits of an averged context vector [1x200] (sample.first)
-	  //                  and a matrix of [25x200] where :
-	  // the first row correspond to the weight vector of the positive sample (the word that was actually part of the corpus)
-	  // the 24th others are weight vectors for negatives samples, choosen according to the unigram table
-	  loader.GetNext(sample);
-	  graph.SetInput("Context", sample.first);
-	  graph.SetInput("Target", sample.second);
-
-	  auto const &prediction = graph.Evaluate("Sigmoid");
-	  error.Copy(ground_truth);
-	  error.InlineSubtract(prediction);
-	  // This is not a mistake : the original Google C code does this very strange thing
-	  // They clamp the output using a sigmoid, but never actually run the backward pass for it
-	  graph.BackPropagate("DotProduct", error);
-
-	  // Adjust the learning rate
-	  learning_rate = std::max((static_cast<float>(total_number_iterations - i) / total_number_iterations) * initial_learning_rate, minimum_learning_rate);
-	  graph.Step(learning_rate);
-	  i++;
+	  std::cout << "Epoch " << epoch << std::flush;
+	}
+      auto start = std::chrono::steady_clock::now();
+      for (uint64_t round(0) ; round < nb_rounds ; ++round)
+	{
+	  // Each thread trains on its own contiguous chunk of the round
+	  uint64_t round_begin = shard_begin + shard_size * round / nb_rounds;
+	  uint64_t round_size = shard_begin + shard_size * (round + 1) / nb_rounds - round_begin;
+	  std::vector<std::thread> threads;
+	  uint64_t chunk_size = round_size / nb_threads;
+	  for (unsigned int t(0) ; t < nb_threads ; ++t)
+	    {
+	      uint64_t nb_samples = (t == nb_threads - 1) ? round_size - t * chunk_size : chunk_size;
+	      threads.emplace_back(train<LoaderType>, std::ref(*workers[t]), round_begin + t * chunk_size, nb_samples, std::cref(options),
+				   std::ref(processed), total_number_iterations, initial_learning_rate);
+	    }
+	  for (auto &t : threads)
+	    {
+	      t.join();
+	    }
+	  if (averager)
+	    {
+	      try
+		{
+		  averager->Average(model);
+		}
+	      catch (std::runtime_error const &e)
+		{
+		  std::cerr << e.what() << std::endl;
+		  return 1;
+		}
+	    }
+	}
+      if (!verbose)
+	{
+	  continue;
+	}
+      std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+      std::cout << " - " << static_cast<uint64_t>(epoch_size / elapsed.count()) << " words/sec";
+      if (options.prefetch)
+	{
+	  uint64_t data_waits(0), loader_waits(0);
+	  double data_wait_seconds(0);
+	  for (auto &w : workers)
+	    {
+	      data_waits += w->data_waits;
+	      data_wait_seconds += w->data_wait_seconds;
+	      loader_waits += w->loader_waits;
+	      w->data_waits = w->loader_waits = 0;
+	      w->data_wait_seconds = 0;
+	    }
+	  std::cout << " - trainers waited " << data_waits << " times for data (" << data_wait_seconds << "s), loaders waited " << loader_waits << " times";
 	}
+      std::cout << std::endl;
+    }
+
+  // All the processes end up with the same averaged model, the first one saves it
+  if (rank != 0)
+    {
+      return 0;
+    }
+  if (averager && !averager->Join())
+    {
+      std::cerr << "A training process failed" << std::endl;
+      return 1;
     }
 
   // Saving the trained vectors to disk
@@ -121,3 +601,93 @@ int main(int ac, char **av)
   
   return 0;
 }
+
+int main(int ac, char **av)
+{
+  std::cout << "Word2Vec" << std::endl;
+
+  Options options;
+  for (int i(1) ; i < ac ; ++i)
+    {
+      std::string arg(av[i]);
+      if (arg == "--threads" && i + 1 < ac)
+	{
+	  options.nb_threads = std::max(1, std::atoi(av[++i]));
+	}
+      else if (arg == "--processes" && i + 1 < ac)
+	{
+	  options.nb_processes = std::max(1, std::atoi(av[++i]));
+	}
+      else if (arg == "--sync-interval" && i + 1 < ac)
+	{
+	  options.sync_interval = std::max(1ll, std::atoll(av[++i]));
+	}
+      else if (arg == "--graph")
+	{
+	  options.use_graph = true;
+	}
+      else if (arg == "--batch" && i + 1 < ac)
+	{
+	  options.batch_size = std::max(1, std::atoi(av[++i]));
+	}
+      else if (arg == "--shared-negatives")
+	{
+	  options.shared_negatives = true;
+	}
+      else if (arg == "--prefetch" && i + 1 < ac)
+	{
+	  options.prefetch = std::max(0, std::atoi(av[++i]));
+	}
+      else if (arg == "--sample" && i + 1 < ac)
+	{
+	  options.sample = std::atof(av[++i]);
+	}
+      else if (arg == "--exact-sigmoid")
+	{
+	  options.exact_sigmoid = true;
+	}
+      else if (arg == "--skipgram")
+	{
+	  options.skipgram = true;
+	}
+      else if (arg == "--hs")
+	{
+	  options.hierarchical_softmax = true;
+	}
+      else
+	{
+	  options.corpus_files.push_back(arg);
+	}
+    }
+  if (options.corpus_files.empty())
+    {
+      std::cerr << "Usage : " << av[0] << " [--threads N] [--processes P] [--sync-interval K] [--graph] [--shared-negatives] [--batch B] [--skipgram] [--hs] [--exact-sigmoid] [--sample S] [--prefetch N] CORPUS_FILES ..." << std::endl;
+      return 1;
+    }
+  if (options.skipgram && options.batch_size > 1)
+    {
+      std::cerr << "Skip-gram already groups the pairs of a window, --batch can't be used with it" << std::endl;
+      return 1;
+    }
+  if (options.batch_size > 1 && !options.use_graph && !options.shared_negatives)
+    {
+      std::cerr << "Mini-batches are only implemented by the graph and the shared negatives trainer, --batch requires --graph or --shared-negatives" << std::endl;
+      return 1;
+    }
+  if (options.shared_negatives && (options.use_graph || options.skipgram || options.hierarchical_softmax))
+    {
+      std::cerr << "Shared negatives are only implemented for CBOW, without --graph or --hs" << std::endl;
+      return 1;
+    }
+  if (options.hierarchical_softmax && (options.skipgram || options.use_graph))
+    {
+      std::cerr << "Hierarchical softmax is only implemented for the fused CBOW trainer" << std::endl;
+      return 1;
+    }
+
+  if (options.skipgram)
+    {
+      return run<SkipGramLoader<float>>(options);
+    }
+  return run<CBOWLoader<float>>(options);
+}
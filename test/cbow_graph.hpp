@@ -0,0 +1,79 @@
+#pragma once
+//------------------------------------------------------------------------------
+//
+//   Copyright 2018-2019 Fetch.AI Limited
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//------------------------------------------------------------------------------
+
+#include "averaged_embeddings.hpp"
+#include "embeddings.hpp"
+#include "graph.hpp"
+#include "inplace_transpose.hpp"
+#include "matrix_multiply.hpp"
+#include "placeholder.hpp"
+#include "sigmoid.hpp"
+#include "tensor.hpp"
+
+/*
+ * Test helpers shared by the tests of the CBOW models : the graph trained by main and a
+ * deterministic stream of samples to feed it (or the fused trainers) with
+ */
+
+// Handles of the nodes the tests drive
+template <typename ArrayType>
+struct CBOWGraph
+{
+  fetch::ml::NodeHandle<fetch::ml::ops::PlaceHolder<ArrayType, 2>> context;
+  fetch::ml::NodeHandle<fetch::ml::ops::PlaceHolder<ArrayType, 2>> target;
+  fetch::ml::NodeHandle<fetch::ml::ops::MatrixMultiply<ArrayType>> dot_product;
+  fetch::ml::NodeHandle<fetch::ml::ops::Sigmoid<ArrayType>>        sigmoid;
+};
+
+/*
+ * Adds [AveragedEmbeddings(words) -> MatrixMultiply(Embeddings(weights)^T) -> Sigmoid] to g, with
+ * the node names used by main : Context, Target, DotProduct and Sigmoid
+ */
+template <typename ArrayType>
+CBOWGraph<ArrayType> AddCBOW(fetch::ml::Graph<ArrayType> &g, ArrayType &words, ArrayType &weights)
+{
+  CBOWGraph<ArrayType> cbow;
+  cbow.context = g.template AddNode<fetch::ml::ops::PlaceHolder<ArrayType, 2>>("Context", {});
+  g.template AddNode<fetch::ml::ops::AveragedEmbeddings<ArrayType>>("Words", {"Context"}, words);
+  cbow.target = g.template AddNode<fetch::ml::ops::PlaceHolder<ArrayType, 2>>("Target", {});
+  g.template AddNode<fetch::ml::ops::Embeddings<ArrayType>>("Weights", {"Target"}, weights);
+  g.template AddNode<fetch::ml::ops::InplaceTranspose<ArrayType>>("WeightsTranspose", {"Weights"});
+  cbow.dot_product = g.template AddNode<fetch::ml::ops::MatrixMultiply<ArrayType>>("DotProduct", {"Words", "WeightsTranspose"});
+  cbow.sigmoid = g.template AddNode<fetch::ml::ops::Sigmoid<ArrayType>>("Sigmoid", {"DotProduct"});
+  return cbow;
+}
+
+/*
+ * Writes sample number n of the stream in row row of context and targets : as many context
+ * words and targets as the tensors have columns, all in [0, vocab_size)
+ * Every other sample, the context words after the fourth one are padding (-1)
+ */
+template <typename ArrayType>
+void FillCBOWSample(ArrayType &context, ArrayType &targets, std::uint64_t n, std::uint64_t vocab_size, std::uint64_t row = 0)
+{
+  using DataType = typename ArrayType::Type;
+  for (std::uint64_t i(0) ; i < context.shape()[1] ; ++i)
+    {
+      context.Set(row, i, (n % 2 && i >= 4) ? DataType(-1) : DataType((n * 7 + i * 3) % vocab_size));
+    }
+  for (std::uint64_t i(0) ; i < targets.shape()[1] ; ++i)
+    {
+      targets.Set(row, i, DataType((n * 5 + i * 11) % vocab_size));
+    }
+}
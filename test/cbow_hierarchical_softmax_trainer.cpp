@@ -0,0 +1,124 @@
+//------------------------------------------------------------------------------
+//
+//   Copyright 2018-2019 Fetch.AI Limited
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//------------------------------------------------------------------------------
+
+#include "cbow_hierarchical_softmax_trainer.hpp"
+#include "huffman_tree.hpp"
+#include "tensor.hpp"
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <vector>
+
+using ArrayType = fetch::math::Tensor<float, 2>;
+
+/*
+ * One step on a 4 words vocabulary, checked against the update computed by hand :
+ * h = average of the context rows, then at each inner node v on the path to the target
+ *   g = (1 - code - s(h.v)) * lr, v += g * h and every context row += g * v (v before its update)
+ */
+TEST(cbow_hierarchical_softmax_trainer_test, one_step_by_hand)
+{
+  // Counts 5 3 1 1 : 2 and 3 are merged first (inner node 0), then with 1 (inner node 1), then
+  // with 0 at the root (inner node 2)
+  fetch::ml::HuffmanTree tree({5, 3, 1, 1});
+  ASSERT_EQ(tree.NbInnerNodes(), 3);
+  ASSERT_EQ(tree.CodeLength(0), 1);
+  ASSERT_EQ(tree.CodeLength(1), 2);
+  ASSERT_EQ(tree.CodeLength(2), 3);
+  ASSERT_EQ(tree.CodeLength(3), 3);
+  std::uint64_t const target(1);
+  ASSERT_EQ(tree.Points(target)[0], 2);
+  ASSERT_EQ(tree.Points(target)[1], 1);
+
+  std::uint64_t const dimensions(4);
+  float const learning_rate(0.5f);
+  ArrayType words({4, dimensions});
+  ArrayType inner_nodes({3, dimensions});
+  for (std::uint64_t i(0) ; i < 4 ; ++i)
+    {
+      for (std::uint64_t j(0) ; j < dimensions ; ++j)
+	{
+	  words.Set(i, j, 0.1f * float(i + 1) - 0.05f * float(j));
+	  if (i < 3)
+	    {
+	      inner_nodes.Set(i, j, 0.2f * float(j) - 0.1f * float(i));
+	    }
+	}
+    }
+  ArrayType initial_words = words.Clone();
+  ArrayType initial_inner_nodes = inner_nodes.Clone();
+
+  // Context words 0 and 3, the third one is padding
+  ArrayType context({1, 3});
+  context.Set(0, 0, 0.0f);
+  context.Set(0, 1, 3.0f);
+  context.Set(0, 2, -1.0f);
+  ArrayType targets({1, 2});
+  targets.Set(0, 0, float(target));
+  targets.Set(0, 1, 2.0f);
+
+  fetch::ml::CBOWHierarchicalSoftmaxTrainer<float> trainer(words, inner_nodes, tree);
+  trainer.Step(context, targets, learning_rate);
+
+  // Expected update, in double
+  std::vector<double> hidden(dimensions), hidden_error(dimensions, 0.0);
+  for (std::uint64_t j(0) ; j < dimensions ; ++j)
+    {
+      hidden[j] = (double(initial_words.Get(0, j)) + double(initial_words.Get(3, j))) / 2;
+    }
+  std::vector<std::vector<double>> expected_inner_nodes(3, std::vector<double>(dimensions));
+  for (std::uint64_t n(0) ; n < 3 ; ++n)
+    {
+      for (std::uint64_t j(0) ; j < dimensions ; ++j)
+	{
+	  expected_inner_nodes[n][j] = initial_inner_nodes.Get(n, j);
+	}
+    }
+  for (std::uint64_t d(0) ; d < tree.CodeLength(target) ; ++d)
+    {
+      std::vector<double> &v = expected_inner_nodes[tree.Points(target)[d]];
+      double dot(0);
+      for (std::uint64_t j(0) ; j < dimensions ; ++j)
+	{
+	  dot += hidden[j] * v[j];
+	}
+      double g = (1.0 - double(tree.Codes(target)[d]) - 1.0 / (1.0 + std::exp(-dot))) * learning_rate;
+      for (std::uint64_t j(0) ; j < dimensions ; ++j)
+	{
+	  hidden_error[j] += g * v[j];
+	  v[j] += g * hidden[j];
+	}
+    }
+
+  for (std::uint64_t j(0) ; j < dimensions ; ++j)
+    {
+      // Inner nodes on the path
+      EXPECT_NEAR(inner_nodes.Get(2, j), expected_inner_nodes[2][j], 1e-6);
+      EXPECT_NEAR(inner_nodes.Get(1, j), expected_inner_nodes[1][j], 1e-6);
+      EXPECT_NE(inner_nodes.Get(2, j), initial_inner_nodes.Get(2, j));
+      // Inner node off the path
+      EXPECT_EQ(inner_nodes.Get(0, j), initial_inner_nodes.Get(0, j));
+
+      // Context words
+      EXPECT_NEAR(words.Get(0, j), initial_words.Get(0, j) + hidden_error[j], 1e-6);
+      EXPECT_NEAR(words.Get(3, j), initial_words.Get(3, j) + hidden_error[j], 1e-6);
+      // Other words, the target included
+      EXPECT_EQ(words.Get(1, j), initial_words.Get(1, j));
+      EXPECT_EQ(words.Get(2, j), initial_words.Get(2, j));
+    }
+}
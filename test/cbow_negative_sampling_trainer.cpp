@@ -0,0 +1,83 @@
+//------------------------------------------------------------------------------
+//
+//   Copyright 2018-2019 Fetch.AI Limited
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//------------------------------------------------------------------------------
+
+#include "cbow_graph.hpp"
+#include "cbow_negative_sampling_trainer.hpp"
+#include "tensor.hpp"
+#include <gtest/gtest.h>
+
+using ArrayType = fetch::math::Tensor<float, 2>;
+
+void CheckSameResultsAsGraph(std::uint64_t dimensions)
+{
+  std::uint64_t vocab_size(20);
+  ArrayType graph_words({vocab_size, dimensions});
+  ArrayType graph_weights({vocab_size, dimensions});
+  fetch::ml::ops::Weights<ArrayType, 2>::Initialise(graph_words, vocab_size, dimensions);
+  fetch::ml::ops::Weights<ArrayType, 2>::Initialise(graph_weights, vocab_size, dimensions);
+  ArrayType fused_words = graph_words.Clone();
+  ArrayType fused_weights = graph_weights.Clone();
+  ArrayType initial_words = graph_words.Clone();
+
+  fetch::ml::Graph<ArrayType> g;
+  AddCBOW(g, graph_words, graph_weights);
+
+  fetch::ml::CBOWNegativeSamplingTrainer<float> trainer(fused_words, fused_weights);
+
+  ArrayType context({1, 6});
+  ArrayType targets({1, 5});
+  ArrayType ground_truth({1, 5});
+  ArrayType error({1, 5});
+  ground_truth.Set(0, 0, 1.0f);
+  for (std::uint64_t step(0) ; step < 20 ; ++step)
+    {
+      // Last two context words are padding every other step
+      FillCBOWSample(context, targets, step, vocab_size);
+      g.SetInput("Context", context);
+      g.SetInput("Target", targets);
+      error.Copy(ground_truth);
+      error.InlineSubtract(g.Evaluate("Sigmoid"));
+      g.BackPropagate("DotProduct", error);
+      g.Step(0.1f);
+
+      trainer.Step(context, targets, 0.1f);
+    }
+
+  float total_update(0);
+  for (std::uint64_t i(0) ; i < vocab_size ; ++i)
+    {
+      for (std::uint64_t j(0) ; j < dimensions ; ++j)
+	{
+	  total_update += std::abs(graph_words.Get(i, j) - initial_words.Get(i, j));
+	  EXPECT_NEAR(fused_words.Get(i, j), graph_words.Get(i, j), 1e-6);
+	  EXPECT_NEAR(fused_weights.Get(i, j), graph_weights.Get(i, j), 1e-6);
+	}
+    }
+  EXPECT_GT(total_update, 0.0f);
+}
+
+TEST(cbow_negative_sampling_trainer_test, same_results_as_graph)
+{
+  CheckSameResultsAsGraph(10);
+}
+
+// Goes through the FixedRow<float, 100> kernels instead of the generic ones
+TEST(cbow_negative_sampling_trainer_test, same_results_as_graph_fixed_dimension)
+{
+  CheckSameResultsAsGraph(100);
+}
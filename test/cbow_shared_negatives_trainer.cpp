@@ -0,0 +1,137 @@
+//------------------------------------------------------------------------------
+//
+//   Copyright 2018-2019 Fetch.AI Limited
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//------------------------------------------------------------------------------
+
+#include "cbow_graph.hpp"
+#include "cbow_negative_sampling_trainer.hpp"
+#include "cbow_shared_negatives_trainer.hpp"
+#include "tensor.hpp"
+#include "weights.hpp"
+#include <gtest/gtest.h>
+
+using ArrayType = fetch::math::Tensor<float, 2>;
+
+TEST(cbow_shared_negatives_trainer_test, single_context_same_as_cbow_trainer)
+{
+  std::uint64_t vocab_size(20), dimensions(10);
+  ArrayType words({vocab_size, dimensions});
+  ArrayType weights({vocab_size, dimensions});
+  fetch::ml::ops::Weights<ArrayType, 2>::Initialise(words, vocab_size, dimensions);
+  fetch::ml::ops::Weights<ArrayType, 2>::Initialise(weights, vocab_size, dimensions);
+  ArrayType shared_words = words.Clone();
+  ArrayType shared_weights = weights.Clone();
+
+  fetch::ml::CBOWNegativeSamplingTrainer<float> trainer(words, weights);
+  fetch::ml::CBOWSharedNegativesTrainer<float>  shared_trainer(shared_words, shared_weights);
+
+  ArrayType context({1, 6});
+  ArrayType targets({1, 5});
+  for (std::uint64_t step(0) ; step < 20 ; ++step)
+    {
+      FillCBOWSample(context, targets, step, vocab_size);
+      trainer.Step(context, targets, 0.1f);
+      shared_trainer.Step(context, targets, 0.1f);
+    }
+
+  for (std::uint64_t i(0) ; i < vocab_size ; ++i)
+    {
+      for (std::uint64_t j(0) ; j < dimensions ; ++j)
+	{
+	  EXPECT_NEAR(words.Get(i, j), shared_words.Get(i, j), 1e-6);
+	  EXPECT_NEAR(weights.Get(i, j), shared_weights.Get(i, j), 1e-6);
+	}
+    }
+}
+
+TEST(cbow_shared_negatives_trainer_test, batch_is_sum_of_individual_updates)
+{
+  // Each context of the batch only sees its own target and the shared negatives,
+  // so the batch update is the sum of the updates of each context taken alone
+  std::uint64_t vocab_size(20), dimensions(10), batch_size(3), nb_negatives(4);
+  ArrayType words({vocab_size, dimensions});
+  ArrayType weights({vocab_size, dimensions});
+  fetch::ml::ops::Weights<ArrayType, 2>::Initialise(words, vocab_size, dimensions);
+  fetch::ml::ops::Weights<ArrayType, 2>::Initialise(weights, vocab_size, dimensions);
+
+  ArrayType context({batch_size, 4});
+  ArrayType targets({1, batch_size + nb_negatives});
+  std::vector<float> positives({1, 7, 1}); // The same target twice and one negative equal to a target
+  std::vector<float> negatives({3, 7, 12, 15});
+  for (std::uint64_t b(0) ; b < batch_size ; ++b)
+    {
+      for (std::uint64_t i(0) ; i < 4 ; ++i)
+	{
+	  context.Set(b, i, (b == 2 && i == 3) ? -1.0f : float((b * 5 + i * 3 + 2) % vocab_size));
+	}
+      targets.Set(0, b, positives[b]);
+    }
+  for (std::uint64_t k(0) ; k < nb_negatives ; ++k)
+    {
+      targets.Set(0, batch_size + k, negatives[k]);
+    }
+
+  ArrayType batch_words = words.Clone();
+  ArrayType batch_weights = weights.Clone();
+  fetch::ml::CBOWSharedNegativesTrainer<float> batch_trainer(batch_words, batch_weights);
+  batch_trainer.Step(context, targets, 0.1f);
+
+  ArrayType expected_words = words.Clone();
+  ArrayType expected_weights = weights.Clone();
+  for (std::uint64_t b(0) ; b < batch_size ; ++b)
+    {
+      ArrayType sample_context({1, 4});
+      ArrayType sample_targets({1, 1 + nb_negatives});
+      sample_context.Slice(0).Copy(context.Slice(b));
+      sample_targets.Set(0, 0, positives[b]);
+      std::uint64_t k(1);
+      for (float n : negatives)
+	{
+	  // The batch trainer masks the negatives equal to the target, the reference just leaves them out
+	  if (n != positives[b])
+	    {
+	      sample_targets.Set(0, k++, n);
+	    }
+	}
+      ArrayType trimmed_targets({1, k});
+      for (std::uint64_t i(0) ; i < k ; ++i)
+	{
+	  trimmed_targets.Set(0, i, sample_targets.Get(0, i));
+	}
+
+      ArrayType sample_words = words.Clone();
+      ArrayType sample_weights = weights.Clone();
+      fetch::ml::CBOWNegativeSamplingTrainer<float> trainer(sample_words, sample_weights);
+      trainer.Step(sample_context, trimmed_targets, 0.1f);
+      for (std::uint64_t i(0) ; i < vocab_size ; ++i)
+	{
+	  for (std::uint64_t j(0) ; j < dimensions ; ++j)
+	    {
+	      expected_words.Set(i, j, expected_words.Get(i, j) + sample_words.Get(i, j) - words.Get(i, j));
+	      expected_weights.Set(i, j, expected_weights.Get(i, j) + sample_weights.Get(i, j) - weights.Get(i, j));
+	    }
+	}
+    }
+
+  for (std::uint64_t i(0) ; i < vocab_size ; ++i)
+    {
+      for (std::uint64_t j(0) ; j < dimensions ; ++j)
+	{
+	  EXPECT_NEAR(batch_words.Get(i, j), expected_words.Get(i, j), 1e-5);
+	  EXPECT_NEAR(batch_weights.Get(i, j), expected_weights.Get(i, j), 1e-5);
+	}
+    }
+}
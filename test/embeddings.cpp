@@ -125,3 +125,45 @@ TYPED_TEST(EmbeddingsTest, backward)
       EXPECT_EQ(output.Get(1, j), TypeParam(row2_gt[j]));
     }  
 }
+
+TYPED_TEST(EmbeddingsTest, backward_keeps_only_touched_rows)
+{
+  using ArrayType = fetch::math::Tensor<TypeParam, 2>;
+  using SizeType = typename ArrayType::SizeType;
+  fetch::ml::ops::Embeddings<ArrayType> e(SizeType(1000), SizeType(6));
+
+  // Row 7 is looked up twice, its gradients add up
+  ArrayType input({1, 3});
+  input.Set(0, 0, TypeParam(7));
+  input.Set(0, 1, TypeParam(2));
+  input.Set(0, 2, TypeParam(7));
+  ArrayType before = e.fetch::ml::template Ops<ArrayType, 2>::Forward({std::cref(input)});
+
+  ArrayType errorSignal({3, 6});
+  for (unsigned int j(0); j < 6; ++j)
+  {
+    errorSignal.Set(0, j, TypeParam(1));
+    errorSignal.Set(1, j, TypeParam(2));
+    errorSignal.Set(2, j, TypeParam(3));
+  }
+  e.fetch::ml::template Ops<ArrayType, 2>::Backward({input}, errorSignal);
+  ASSERT_EQ(e.Gradient().NbRows(), 2);
+  ASSERT_EQ(e.Gradient().PoolSize(), 2 * 6);
+  ASSERT_EQ(e.Gradient().Row(3), nullptr);
+  EXPECT_EQ(e.Gradient().Row(7)[0], TypeParam(4));
+  EXPECT_EQ(e.Gradient().Row(2)[5], TypeParam(2));
+
+  e.Step(TypeParam(1));
+  ASSERT_EQ(e.Gradient().NbRows(), 0);
+  ArrayType after = e.fetch::ml::template Ops<ArrayType, 2>::Forward({std::cref(input)});
+  for (unsigned int j(0); j < 6; ++j)
+    {
+      EXPECT_EQ(after.Get(0, j), TypeParam(before.Get(0, j) + 4));
+      EXPECT_EQ(after.Get(1, j), TypeParam(before.Get(1, j) + 2));
+    }
+
+  // The pool is reused by the next steps
+  e.fetch::ml::template Ops<ArrayType, 2>::Backward({input}, errorSignal);
+  EXPECT_EQ(e.Gradient().Row(7)[0], TypeParam(4));
+  ASSERT_EQ(e.Gradient().PoolSize(), 2 * 6);
+}
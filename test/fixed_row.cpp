@@ -0,0 +1,105 @@
+//------------------------------------------------------------------------------
+//
+//   Copyright 2018-2019 Fetch.AI Limited
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//------------------------------------------------------------------------------
+
+#include "fixed_row.hpp"
+#include <gtest/gtest.h>
+
+#include <vector>
+
+template <typename T>
+class FixedRowTest : public ::testing::Test
+{
+};
+
+using MyTypes = ::testing::Types<float, double>;
+TYPED_TEST_CASE(FixedRowTest, MyTypes);
+
+// Runs every kernel of Row on n elements and compares with plain loops
+template <typename T, typename Row>
+void CheckRow(std::size_t n)
+{
+  std::vector<T> x(n), y(n), expected(n);
+  for (std::size_t j(0) ; j < n ; ++j)
+    {
+      x[j] = T(j % 7) - T(3);
+      y[j] = T(j % 5) * T(0.5);
+    }
+
+  T dot(0);
+  for (std::size_t j(0) ; j < n ; ++j)
+    {
+      dot += x[j] * y[j];
+    }
+  EXPECT_NEAR(Row::Dot(x.data(), y.data(), n), dot, 1e-4);
+
+  expected = y;
+  for (std::size_t j(0) ; j < n ; ++j)
+    {
+      expected[j] += x[j] * T(0.25);
+    }
+  Row::Axpy(y.data(), x.data(), T(0.25), n);
+  EXPECT_EQ(y, expected);
+
+  for (std::size_t j(0) ; j < n ; ++j)
+    {
+      expected[j] += x[j];
+    }
+  Row::Add(y.data(), x.data(), n);
+  EXPECT_EQ(y, expected);
+
+  for (std::size_t j(0) ; j < n ; ++j)
+    {
+      expected[j] /= T(3);
+    }
+  Row::Divide(y.data(), T(3), n);
+  EXPECT_EQ(y, expected);
+
+  Row::Copy(y.data(), x.data(), n);
+  EXPECT_EQ(y, x);
+
+  Row::Fill(y.data(), T(2), n);
+  EXPECT_EQ(y, std::vector<T>(n, T(2)));
+}
+
+TYPED_TEST(FixedRowTest, fixed_sizes)
+{
+  CheckRow<TypeParam, fetch::math::FixedRow<TypeParam, 64>>(64);
+  CheckRow<TypeParam, fetch::math::FixedRow<TypeParam, 100>>(100);
+  CheckRow<TypeParam, fetch::math::FixedRow<TypeParam, 128>>(128);
+  CheckRow<TypeParam, fetch::math::FixedRow<TypeParam, 200>>(200);
+  CheckRow<TypeParam, fetch::math::FixedRow<TypeParam, 300>>(300);
+}
+
+TYPED_TEST(FixedRowTest, generic_sizes)
+{
+  for (std::size_t n : {0, 1, 7, 8, 9, 50, 100, 301})
+    {
+      CheckRow<TypeParam, fetch::math::FixedRow<TypeParam, 0>>(n);
+    }
+}
+
+TYPED_TEST(FixedRowTest, dispatch)
+{
+  for (std::size_t n : {1, 64, 99, 100, 128, 200, 256, 300})
+    {
+      std::size_t dimension(1);
+      fetch::math::WithFixedRow<TypeParam>(n, [&dimension](auto row) { dimension = decltype(row)::DIMENSION; });
+      bool const common = n == 64 || n == 100 || n == 128 || n == 200 || n == 300;
+      EXPECT_EQ(dimension, common ? n : 0);
+    }
+}
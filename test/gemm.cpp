@@ -0,0 +1,234 @@
+//------------------------------------------------------------------------------
+//
+//   Copyright 2018-2019 Fetch.AI Limited
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//------------------------------------------------------------------------------
+
+#include "matrix_operations.hpp"
+#include "tensor.hpp"
+#include <gtest/gtest.h>
+
+#include <random>
+
+template <typename T>
+class GemmTest : public ::testing::Test
+{
+};
+
+using MyTypes = ::testing::Types<float, double>;
+TYPED_TEST_CASE(GemmTest, MyTypes);
+
+template <typename T>
+fetch::math::Tensor<T, 2> Random(std::uint64_t rows, std::uint64_t cols, std::mt19937 &rng)
+{
+  std::uniform_real_distribution<double> distribution(-1.0, 1.0);
+  fetch::math::Tensor<T, 2> t({rows, cols});
+  for (std::uint64_t i(0) ; i < rows ; ++i)
+    {
+      for (std::uint64_t j(0) ; j < cols ; ++j)
+	{
+	  t.Set(i, j, T(distribution(rng)));
+	}
+    }
+  return t;
+}
+
+// c + a.b computed in double through Get, whatever the strides
+template <typename T>
+std::vector<double> Expected(fetch::math::Tensor<T, 2> const &a, fetch::math::Tensor<T, 2> const &b, fetch::math::Tensor<T, 2> const &c)
+{
+  std::vector<double> ret;
+  for (std::uint64_t i(0) ; i < a.shape()[0] ; ++i)
+    {
+      for (std::uint64_t j(0) ; j < b.shape()[1] ; ++j)
+	{
+	  double sum = c.Get(i, j);
+	  for (std::uint64_t k(0) ; k < a.shape()[1] ; ++k)
+	    {
+	      sum += double(a.Get(i, k)) * double(b.Get(k, j));
+	    }
+	  ret.push_back(sum);
+	}
+    }
+  return ret;
+}
+
+template <typename T>
+void ExpectNear(std::vector<double> const &expected, fetch::math::Tensor<T, 2> const &c, std::uint64_t k)
+{
+  double tolerance = (sizeof(T) == 4 ? 1e-5 : 1e-12) * double(k + 1);
+  for (std::uint64_t i(0) ; i < c.shape()[0] ; ++i)
+    {
+      for (std::uint64_t j(0) ; j < c.shape()[1] ; ++j)
+	{
+	  ASSERT_NEAR(c.Get(i, j), expected[i * c.shape()[1] + j], tolerance) << i << " " << j;
+	}
+    }
+}
+
+// Sizes below and above the packing threshold, and across the MC, KC and NC blocks
+static std::vector<std::array<std::uint64_t, 3>> const SIZES({{1, 100, 25}, {1, 1, 1}, {7, 3, 5},
+      {37, 53, 29}, {130, 300, 70}, {13, 600, 1100}});
+
+TYPED_TEST(GemmTest, dot)
+{
+  std::mt19937 rng(1);
+  for (auto const &s : SIZES)
+    {
+      auto a = Random<TypeParam>(s[0], s[1], rng);
+      auto b = Random<TypeParam>(s[1], s[2], rng);
+      auto c = Random<TypeParam>(s[0], s[2], rng);
+      fetch::math::Tensor<TypeParam, 2> zero({s[0], s[2]});
+      std::vector<double> expected = Expected(a, b, zero);
+      fetch::math::Dot(a, b, c);
+      ExpectNear(expected, c, s[1]);
+    }
+}
+
+TYPED_TEST(GemmTest, dot_transpose)
+{
+  std::mt19937 rng(2);
+  for (auto const &s : SIZES)
+    {
+      auto a = Random<TypeParam>(s[0], s[1], rng);
+      auto b = Random<TypeParam>(s[2], s[1], rng);
+      auto c = Random<TypeParam>(s[0], s[2], rng);
+      std::vector<double> expected = Expected(a, b.Transpose(), c);
+      fetch::math::DotTranspose(a, b, c);
+      ExpectNear(expected, c, s[1]);
+    }
+}
+
+TYPED_TEST(GemmTest, transpose_dot)
+{
+  std::mt19937 rng(3);
+  for (auto const &s : SIZES)
+    {
+      auto a = Random<TypeParam>(s[1], s[0], rng);
+      auto b = Random<TypeParam>(s[1], s[2], rng);
+      auto c = Random<TypeParam>(s[0], s[2], rng);
+      std::vector<double> expected = Expected(a.Transpose(), b, c);
+      fetch::math::TransposeDot(a, b, c);
+      ExpectNear(expected, c, s[1]);
+    }
+}
+
+// Transposed views are read in place, including as the output
+TYPED_TEST(GemmTest, transposed_views)
+{
+  std::mt19937 rng(4);
+  for (auto const &s : SIZES)
+    {
+      auto a = Random<TypeParam>(s[1], s[0], rng).Transpose();
+      auto b = Random<TypeParam>(s[2], s[1], rng).Transpose();
+      auto c = Random<TypeParam>(s[2], s[0], rng).Transpose();
+      fetch::math::Tensor<TypeParam, 2> zero({s[0], s[2]});
+      std::vector<double> expected = Expected(a, b, zero);
+      fetch::math::Dot(a, b, c);
+      ExpectNear(expected, c, s[1]);
+    }
+}
+
+TYPED_TEST(GemmTest, batch_dot)
+{
+  std::mt19937 rng(5);
+  std::uint64_t batch(9), n(40), m(30);
+  auto a = Random<TypeParam>(batch, n, rng);
+  auto b = Random<TypeParam>(n, batch * m, rng);
+  fetch::math::Tensor<TypeParam, 2> c({batch, m});
+  fetch::math::BatchDot(a, b, c);
+  for (std::uint64_t i(0) ; i < batch ; ++i)
+    {
+      for (std::uint64_t j(0) ; j < m ; ++j)
+	{
+	  double sum(0);
+	  for (std::uint64_t k(0) ; k < n ; ++k)
+	    {
+	      sum += double(a.Get(i, k)) * double(b.Get(k, i * m + j));
+	    }
+	  ASSERT_NEAR(c.Get(i, j), sum, 1e-4);
+	}
+    }
+}
+
+TYPED_TEST(GemmTest, batch_transpose_dot)
+{
+  std::mt19937 rng(6);
+  std::uint64_t batch(9), n(40), m(5);
+  auto a = Random<TypeParam>(batch, n, rng);
+  auto b = Random<TypeParam>(batch, m, rng);
+  // ret accumulates, in a dense tensor and in a transposed view
+  auto dense = Random<TypeParam>(n, batch * m, rng);
+  auto storage = Random<TypeParam>(batch * m, n, rng);
+  auto transposed = storage.Transpose();
+  for (auto *c : {&dense, &transposed})
+    {
+      auto initial = c->Clone();
+      fetch::math::BatchTransposeDot(a, b, *c);
+      for (std::uint64_t p(0) ; p < n ; ++p)
+	{
+	  for (std::uint64_t i(0) ; i < batch ; ++i)
+	    {
+	      for (std::uint64_t j(0) ; j < m ; ++j)
+		{
+		  double expected = double(initial.Get(p, i * m + j)) + double(a.Get(i, p)) * double(b.Get(i, j));
+		  ASSERT_NEAR(c->Get(p, i * m + j), expected, 1e-5);
+		}
+	    }
+	}
+    }
+}
+
+TEST(GemmTest, reference_matches_blocked)
+{
+  std::mt19937 rng(6);
+  auto a = Random<float>(67, 301, rng);
+  auto b = Random<float>(301, 45, rng);
+  auto c = Random<float>(67, 45, rng);
+  fetch::math::Tensor<float, 2> d = c.Clone();
+  fetch::math::gemm::Reference(fetch::math::gemm::View(a), fetch::math::gemm::View(b), fetch::math::gemm::View(c));
+  fetch::math::gemm::MultiplyAdd(fetch::math::gemm::View(a), fetch::math::gemm::View(b), fetch::math::gemm::View(d));
+  for (std::uint64_t i(0) ; i < 67 ; ++i)
+    {
+      for (std::uint64_t j(0) ; j < 45 ; ++j)
+	{
+	  ASSERT_NEAR(c.Get(i, j), d.Get(i, j), 1e-4);
+	}
+    }
+}
+
+// Bands split by rows and by columns give the single threaded result
+TYPED_TEST(GemmTest, parallel)
+{
+  fetch::math::ThreadPool serial(0);
+  fetch::math::ThreadPool pool(3);
+  std::mt19937 rng(7);
+  for (auto const &s : std::vector<std::array<std::uint64_t, 3>>({{301, 70, 40}, {20, 1000, 50}, {100, 100, 100}}))
+    {
+      auto a = Random<TypeParam>(s[0], s[1], rng);
+      auto b = Random<TypeParam>(s[2], s[1], rng);
+      auto c = Random<TypeParam>(s[0], s[2], rng);
+      fetch::math::Tensor<TypeParam, 2> d = c.Clone();
+      fetch::math::gemm::MultiplyAdd(fetch::math::gemm::View(a), fetch::math::gemm::View(b).Transposed(), fetch::math::gemm::View(c), serial);
+      fetch::math::gemm::MultiplyAdd(fetch::math::gemm::View(a), fetch::math::gemm::View(b).Transposed(), fetch::math::gemm::View(d), pool);
+      for (std::uint64_t i(0) ; i < s[0] ; ++i)
+	{
+	  for (std::uint64_t j(0) ; j < s[2] ; ++j)
+	    {
+	      ASSERT_EQ(c.Get(i, j), d.Get(i, j));
+	    }
+	}
+    }
+}
@@ -16,9 +16,12 @@
 //
 //------------------------------------------------------------------------------
 
+#include "cbow_graph.hpp"
+#include "embeddings.hpp"
 #include "graph.hpp"
 #include "tensor.hpp"
 #include "placeholder.hpp"
+#include "sigmoid.hpp"
 
 #include <gtest/gtest.h>
 
@@ -63,3 +66,343 @@ TEST(graph_test, no_such_node_test)  // Use the class as a Node
   g.SetInput("Input", data);
   ASSERT_ANY_THROW(g.Evaluate("FullyConnected"));
 }
+
+TEST(graph_test, cbow_batch_same_as_accumulated_samples)
+{
+  using FloatArrayType = fetch::math::Tensor<float, 2>;
+  std::uint64_t vocab_size(20), dimensions(10), batch_size(4);
+  FloatArrayType words({vocab_size, dimensions});
+  FloatArrayType weights({vocab_size, dimensions});
+  fetch::ml::ops::Weights<FloatArrayType, 2>::Initialise(words, vocab_size, dimensions);
+  fetch::ml::ops::Weights<FloatArrayType, 2>::Initialise(weights, vocab_size, dimensions);
+  std::vector<FloatArrayType> all_words({words, words.Clone()});
+  std::vector<FloatArrayType> all_weights({weights, weights.Clone()});
+
+  std::vector<std::unique_ptr<fetch::ml::Graph<FloatArrayType>>> graphs;
+  for (std::uint64_t i(0) ; i < 2 ; ++i)
+    {
+      graphs.emplace_back(new fetch::ml::Graph<FloatArrayType>());
+      AddCBOW(*graphs[i], all_words[i], all_weights[i]);
+    }
+
+  FloatArrayType context({batch_size, 6});
+  FloatArrayType targets({batch_size, 5});
+  for (std::uint64_t b(0) ; b < batch_size ; ++b)
+    {
+      FillCBOWSample(context, targets, b, vocab_size, b);
+    }
+
+  // Whole batch in one evaluation
+  graphs[1]->SetInput("Context", context, true);
+  graphs[1]->SetInput("Target", targets, true);
+  FloatArrayType batch_prediction = graphs[1]->Evaluate("Sigmoid").Clone();
+  ASSERT_EQ(batch_prediction.shape(), (std::array<std::uint64_t, 2>({batch_size, 5})));
+  FloatArrayType batch_error = batch_prediction.Clone();
+  batch_error.InlineMultiply(batch_prediction);
+  graphs[1]->BackPropagate("DotProduct", batch_error);
+  graphs[1]->Step(0.1f);
+
+  // One sample at a time, gradients accumulated until the final step
+  for (std::uint64_t b(0) ; b < batch_size ; ++b)
+    {
+      FloatArrayType sample_context({1, 6});
+      FloatArrayType sample_targets({1, 5});
+      sample_context.Slice(0).Copy(context.Slice(b));
+      sample_targets.Slice(0).Copy(targets.Slice(b));
+      graphs[0]->SetInput("Context", sample_context);
+      graphs[0]->SetInput("Target", sample_targets);
+      FloatArrayType prediction = graphs[0]->Evaluate("Sigmoid").Clone();
+      for (std::uint64_t i(0) ; i < 5 ; ++i)
+	{
+	  EXPECT_NEAR(prediction.Get(0, i), batch_prediction.Get(b, i), 1e-6);
+	}
+      FloatArrayType error = prediction.Clone();
+      error.InlineMultiply(prediction);
+      graphs[0]->BackPropagate("DotProduct", error);
+    }
+  graphs[0]->Step(0.1f);
+
+  for (std::uint64_t i(0) ; i < vocab_size ; ++i)
+    {
+      for (std::uint64_t j(0) ; j < dimensions ; ++j)
+	{
+	  EXPECT_NEAR(all_words[0].Get(i, j), all_words[1].Get(i, j), 1e-6);
+	  EXPECT_NEAR(all_weights[0].Get(i, j), all_weights[1].Get(i, j), 1e-6);
+	}
+    }
+}
+
+TEST(graph_test, cbow_direct_update_same_as_step)
+{
+  using FloatArrayType = fetch::math::Tensor<float, 2>;
+  std::uint64_t vocab_size(20), dimensions(10);
+  FloatArrayType words({vocab_size, dimensions});
+  FloatArrayType weights({vocab_size, dimensions});
+  fetch::ml::ops::Weights<FloatArrayType, 2>::Initialise(words, vocab_size, dimensions);
+  fetch::ml::ops::Weights<FloatArrayType, 2>::Initialise(weights, vocab_size, dimensions);
+  FloatArrayType initial_words = words.Clone();
+  FloatArrayType initial_weights = weights.Clone();
+  std::vector<FloatArrayType> all_words({words, words.Clone()});
+  std::vector<FloatArrayType> all_weights({weights, weights.Clone()});
+
+  std::vector<std::unique_ptr<fetch::ml::Graph<FloatArrayType>>> graphs;
+  for (std::uint64_t i(0) ; i < 2 ; ++i)
+    {
+      graphs.emplace_back(new fetch::ml::Graph<FloatArrayType>());
+      AddCBOW(*graphs[i], all_words[i], all_weights[i]);
+    }
+  ASSERT_TRUE(graphs[1]->SetDirectUpdate(0.1f));
+
+  // Words 3 and 9 appear twice, in the context and among the targets
+  FloatArrayType context({1, 6});
+  FloatArrayType targets({1, 5});
+  std::vector<float> context_words({3, 7, 3, 12, 9, -1});
+  std::vector<float> target_words({9, 1, 9, 15, 3});
+  for (std::uint64_t i(0) ; i < 6 ; ++i)
+    {
+      context.Set(0, i, context_words[i]);
+    }
+  for (std::uint64_t i(0) ; i < 5 ; ++i)
+    {
+      targets.Set(0, i, target_words[i]);
+    }
+
+  for (std::uint64_t i(0) ; i < 2 ; ++i)
+    {
+      graphs[i]->SetInput("Context", context);
+      graphs[i]->SetInput("Target", targets);
+      FloatArrayType error = graphs[i]->Evaluate("Sigmoid").Clone();
+      error.InlineMultiply(-1.0f);
+      error.Set(0, 0, error.Get(0, 0) + 1.0f);
+      graphs[i]->BackPropagate("DotProduct", error);
+      graphs[i]->Step(0.1f);
+    }
+
+  for (std::uint64_t i(0) ; i < vocab_size ; ++i)
+    {
+      for (std::uint64_t j(0) ; j < dimensions ; ++j)
+	{
+	  EXPECT_NEAR(all_words[0].Get(i, j), all_words[1].Get(i, j), 1e-6);
+	  EXPECT_NEAR(all_weights[0].Get(i, j), all_weights[1].Get(i, j), 1e-6);
+	}
+    }
+  EXPECT_NE(all_words[1].Get(3, 0), initial_words.Get(3, 0));
+  EXPECT_NE(all_weights[1].Get(9, 0), initial_weights.Get(9, 0));
+}
+
+TEST(graph_test, compiled_same_as_recursive)
+{
+  using FloatArrayType = fetch::math::Tensor<float, 2>;
+  std::uint64_t vocab_size(20), dimensions(10);
+  FloatArrayType words({vocab_size, dimensions});
+  FloatArrayType weights({vocab_size, dimensions});
+  fetch::ml::ops::Weights<FloatArrayType, 2>::Initialise(words, vocab_size, dimensions);
+  fetch::ml::ops::Weights<FloatArrayType, 2>::Initialise(weights, vocab_size, dimensions);
+  std::vector<FloatArrayType> all_words({words, words.Clone()});
+  std::vector<FloatArrayType> all_weights({weights, weights.Clone()});
+
+  std::vector<std::unique_ptr<fetch::ml::Graph<FloatArrayType>>> graphs;
+  for (std::uint64_t i(0) ; i < 2 ; ++i)
+    {
+      graphs.emplace_back(new fetch::ml::Graph<FloatArrayType>());
+      AddCBOW(*graphs[i], all_words[i], all_weights[i]);
+    }
+  graphs[1]->Compile();
+  ASSERT_ANY_THROW(graphs[1]->Evaluate("FullyConnected"));
+
+  FloatArrayType context({1, 6});
+  FloatArrayType targets({1, 5});
+  for (std::uint64_t step(0) ; step < 10 ; ++step)
+    {
+      FillCBOWSample(context, targets, step, vocab_size);
+      std::vector<FloatArrayType> predictions;
+      for (std::uint64_t i(0) ; i < 2 ; ++i)
+	{
+	  graphs[i]->SetInput("Context", context);
+	  graphs[i]->SetInput("Target", targets);
+	  predictions.push_back(graphs[i]->Evaluate("Sigmoid").Clone());
+	  FloatArrayType error = predictions.back().Clone();
+	  error.InlineMultiply(-1.0f);
+	  error.Set(0, 0, error.Get(0, 0) + 1.0f);
+	  graphs[i]->BackPropagate("DotProduct", error);
+	  graphs[i]->Step(0.1f);
+	}
+      for (std::uint64_t i(0) ; i < 5 ; ++i)
+	{
+	  ASSERT_EQ(predictions[0].Get(0, i), predictions[1].Get(0, i));
+	}
+    }
+
+  for (std::uint64_t i(0) ; i < vocab_size ; ++i)
+    {
+      for (std::uint64_t j(0) ; j < dimensions ; ++j)
+	{
+	  EXPECT_EQ(all_words[0].Get(i, j), all_words[1].Get(i, j));
+	  EXPECT_EQ(all_weights[0].Get(i, j), all_weights[1].Get(i, j));
+	}
+    }
+}
+
+// Words feeds two nodes : the compiled plan sums both error signals before back propagating once
+TEST(graph_test, compiled_node_with_several_outputs)
+{
+  using FloatArrayType = fetch::math::Tensor<float, 2>;
+  std::uint64_t vocab_size(20), dimensions(10);
+  FloatArrayType words({vocab_size, dimensions});
+  fetch::ml::ops::Weights<FloatArrayType, 2>::Initialise(words, vocab_size, dimensions);
+  FloatArrayType initial_words = words.Clone();
+  std::vector<FloatArrayType> all_words({words, words.Clone()});
+
+  std::vector<std::unique_ptr<fetch::ml::Graph<FloatArrayType>>> graphs;
+  for (std::uint64_t i(0) ; i < 2 ; ++i)
+    {
+      graphs.emplace_back(new fetch::ml::Graph<FloatArrayType>());
+      graphs[i]->AddNode<fetch::ml::ops::PlaceHolder<FloatArrayType, 2>>("Context", {});
+      graphs[i]->AddNode<fetch::ml::ops::Embeddings<FloatArrayType>>("Words", {"Context"}, all_words[i]);
+      graphs[i]->AddNode<fetch::ml::ops::InplaceTranspose<FloatArrayType>>("WordsTranspose", {"Words"});
+      graphs[i]->AddNode<fetch::ml::ops::MatrixMultiply<FloatArrayType>>("Gram", {"Words", "WordsTranspose"});
+    }
+  graphs[1]->Compile();
+
+  FloatArrayType context({1, 4});
+  for (std::uint64_t i(0) ; i < 4 ; ++i)
+    {
+      context.Set(0, i, float(i * 3 + 1));
+    }
+  for (std::uint64_t i(0) ; i < 2 ; ++i)
+    {
+      graphs[i]->SetInput("Context", context);
+      FloatArrayType gram = graphs[i]->Evaluate("Gram");
+      ASSERT_EQ(gram.shape(), (std::array<std::uint64_t, 2>({4, 4})));
+      FloatArrayType error({4, 4});
+      error.Fill(0.5f);
+      graphs[i]->BackPropagate("Gram", error);
+      graphs[i]->Step(0.1f);
+    }
+
+  for (std::uint64_t i(0) ; i < vocab_size ; ++i)
+    {
+      for (std::uint64_t j(0) ; j < dimensions ; ++j)
+	{
+	  EXPECT_NEAR(all_words[0].Get(i, j), all_words[1].Get(i, j), 1e-6);
+	}
+    }
+  EXPECT_NE(all_words[1].Get(1, 0), initial_words.Get(1, 0));
+}
+
+TEST(graph_test, node_handles)
+{
+  using FloatArrayType = fetch::math::Tensor<float, 2>;
+  std::uint64_t vocab_size(20), dimensions(10);
+  FloatArrayType words({vocab_size, dimensions});
+  FloatArrayType weights({vocab_size, dimensions});
+  fetch::ml::ops::Weights<FloatArrayType, 2>::Initialise(words, vocab_size, dimensions);
+  fetch::ml::ops::Weights<FloatArrayType, 2>::Initialise(weights, vocab_size, dimensions);
+
+  for (bool compile : {false, true})
+    {
+      fetch::ml::Graph<FloatArrayType> g;
+      CBOWGraph<FloatArrayType> cbow = AddCBOW(g, words, weights);
+      // Typed handles convert to untyped ones
+      fetch::ml::NodeHandle<> sigmoid = cbow.sigmoid;
+      if (compile)
+	{
+	  g.Compile();
+	}
+
+      FloatArrayType context_words({1, 4});
+      FloatArrayType target_words({1, 3});
+      FillCBOWSample(context_words, target_words, 0, vocab_size);
+
+      g.SetInput(cbow.context, context_words);
+      g.SetInput(cbow.target, target_words);
+      FloatArrayType by_handle = g.Evaluate(sigmoid).Clone();
+      FloatArrayType dot_by_handle = g.Evaluate(cbow.dot_product).Clone();
+      g.SetInput("Context", context_words);
+      g.SetInput("Target", target_words);
+      FloatArrayType by_name = g.Evaluate("Sigmoid").Clone();
+      ASSERT_EQ(by_handle.shape(), by_name.shape());
+      for (std::uint64_t i(0) ; i < 3 ; ++i)
+	{
+	  EXPECT_EQ(by_handle.Get(0, i), by_name.Get(0, i));
+	  EXPECT_EQ(dot_by_handle.Get(0, i), g.Evaluate("DotProduct").Get(0, i));
+	}
+
+      // The handle and the name reach the same node
+      std::uint64_t target_word(std::uint64_t(target_words.Get(0, 0)));
+      FloatArrayType initial_weights = weights.Clone();
+      FloatArrayType error({1, 3});
+      error.Fill(0.5f);
+      g.BackPropagate(cbow.dot_product, error);
+      g.Step(0.1f);
+      EXPECT_NE(weights.Get(target_word, 0), initial_weights.Get(target_word, 0));
+    }
+}
+
+TEST(graph_test, bound_inputs)
+{
+  using FloatArrayType = fetch::math::Tensor<float, 2>;
+  std::uint64_t vocab_size(20), dimensions(10);
+  FloatArrayType words({vocab_size, dimensions});
+  FloatArrayType weights({vocab_size, dimensions});
+  fetch::ml::ops::Weights<FloatArrayType, 2>::Initialise(words, vocab_size, dimensions);
+  fetch::ml::ops::Weights<FloatArrayType, 2>::Initialise(weights, vocab_size, dimensions);
+
+  for (bool compile : {false, true})
+    {
+      fetch::ml::Graph<FloatArrayType> g;
+      CBOWGraph<FloatArrayType> cbow = AddCBOW(g, words, weights);
+      if (compile)
+	{
+	  g.Compile();
+	}
+
+      FloatArrayType context_words({1, 4});
+      FloatArrayType target_words({1, 3});
+      g.BindInput(cbow.context, context_words);
+      g.BindInput(cbow.target, target_words);
+      for (std::uint64_t sample(0) ; sample < 3 ; ++sample)
+	{
+	  // Refilled in place, the graph only needs to know the content changed
+	  FillCBOWSample(context_words, target_words, sample, vocab_size);
+	  g.InputUpdated(cbow.context);
+	  g.InputUpdated(cbow.target);
+	  FloatArrayType bound = g.Evaluate(cbow.sigmoid).Clone();
+
+	  g.SetInput("Context", context_words.Clone());
+	  g.SetInput("Target", target_words.Clone());
+	  FloatArrayType set = g.Evaluate(cbow.sigmoid).Clone();
+	  for (std::uint64_t i(0) ; i < 3 ; ++i)
+	    {
+	      EXPECT_EQ(bound.Get(0, i), set.Get(0, i));
+	    }
+	  g.BindInput(cbow.context, context_words);
+	  g.BindInput(cbow.target, target_words);
+	}
+    }
+}
+
+TEST(graph_test, node_handles_convert_to_names)
+{
+  using FloatArrayType = fetch::math::Tensor<float, 2>;
+  fetch::ml::Graph<FloatArrayType> g;
+  // Code written when AddNode returned the name of the node
+  std::string input = g.AddNode<fetch::ml::ops::PlaceHolder<FloatArrayType, 2>>("Input", {});
+  std::string output = g.AddNode<fetch::ml::ops::Sigmoid<FloatArrayType>>("Output", {input});
+  EXPECT_EQ(input, "Input");
+  EXPECT_EQ(output, "Output");
+
+  // Names and handles can be mixed
+  auto handle = g.AddNode<fetch::ml::ops::Sigmoid<FloatArrayType>>("Twice", {output});
+  FloatArrayType data({1, 2});
+  data.Set(0, 0, 0.0f);
+  data.Set(0, 1, 2.0f);
+  g.SetInput(input, data);
+  FloatArrayType by_name = g.Evaluate("Twice").Clone();
+  FloatArrayType by_handle = g.Evaluate(handle).Clone();
+  for (std::uint64_t i(0) ; i < 2 ; ++i)
+    {
+      EXPECT_EQ(by_name.Get(0, i), by_handle.Get(0, i));
+    }
+  EXPECT_NEAR(by_name.Get(0, 0), 1.0f / (1.0f + std::exp(-0.5f)), 1e-6);
+}
@@ -0,0 +1,93 @@
+//------------------------------------------------------------------------------
+//
+//   Copyright 2018-2019 Fetch.AI Limited
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//------------------------------------------------------------------------------
+
+#include "huffman_tree.hpp"
+#include <gtest/gtest.h>
+
+#include <set>
+
+TEST(huffman_tree_test, known_tree)
+{
+  // Classic example : a:45 b:13 c:12 d:16 e:9 f:5
+  fetch::ml::HuffmanTree tree({45, 13, 12, 16, 9, 5});
+  ASSERT_EQ(tree.VocabSize(), 6);
+  ASSERT_EQ(tree.NbInnerNodes(), 5);
+
+  std::vector<std::uint64_t> expected_lengths({1, 3, 3, 3, 4, 4});
+  for (std::uint64_t w(0) ; w < 6 ; ++w)
+    {
+      EXPECT_EQ(tree.CodeLength(w), expected_lengths[w]);
+      // Every path starts at the root
+      EXPECT_EQ(tree.Points(w)[0], 4);
+    }
+}
+
+TEST(huffman_tree_test, prefix_free_codes)
+{
+  std::vector<std::uint64_t> frequencies;
+  for (std::uint64_t i(0) ; i < 100 ; ++i)
+    {
+      frequencies.push_back((i * 37) % 101 + 1);
+    }
+  fetch::ml::HuffmanTree tree(frequencies);
+
+  std::set<std::string> codes;
+  double average_length(0), total(0);
+  for (std::uint64_t w(0) ; w < frequencies.size() ; ++w)
+    {
+      std::string code;
+      for (std::uint64_t d(0) ; d < tree.CodeLength(w) ; ++d)
+	{
+	  code += char('0' + tree.Codes(w)[d]);
+	  EXPECT_LT(tree.Points(w)[d], tree.NbInnerNodes());
+	}
+      codes.insert(code);
+      average_length += double(code.size() * frequencies[w]);
+      total += double(frequencies[w]);
+    }
+  ASSERT_EQ(codes.size(), frequencies.size());
+  for (auto const &a : codes)
+    {
+      for (auto const &b : codes)
+	{
+	  if (a != b)
+	    {
+	      EXPECT_NE(b.compare(0, a.size(), a), 0) << a << " is a prefix of " << b;
+	    }
+	}
+    }
+  // Weighted average code length can't be more than 1 bit above the entropy, ~log2(100)
+  EXPECT_LT(average_length / total, 8.0);
+
+  // Two words sharing the same code prefix go through the same inner nodes
+  for (std::uint64_t w(0) ; w < frequencies.size() ; ++w)
+    {
+      for (std::uint64_t v(0) ; v < frequencies.size() ; ++v)
+	{
+	  std::uint64_t d(0);
+	  while (d < tree.CodeLength(w) && d < tree.CodeLength(v) && tree.Codes(w)[d] == tree.Codes(v)[d])
+	    {
+	      d++;
+	    }
+	  if (d < tree.CodeLength(w) && d < tree.CodeLength(v))
+	    {
+	      EXPECT_EQ(tree.Points(w)[d], tree.Points(v)[d]);
+	    }
+	}
+    }
+}
@@ -112,3 +112,76 @@ TYPED_TEST(MatrixMultiplyTest, backward_test)
 	}
     }
 }
+
+TYPED_TEST(MatrixMultiplyTest, batch_forward_backward_test)
+{
+  // Two samples, each one multiplied by its own [5 x 4] block of columns
+  TypeParam a({2, 5});
+  TypeParam b({5, 8});
+  TypeParam error({2, 4});
+
+  std::vector<int> data({1, 2, -3, 4, 5, 2, 0, 1, -1, 3});
+  for (std::uint64_t i(0); i < 2; ++i)
+  {
+    for (std::uint64_t j(0); j < 5; ++j)
+    {
+      a.Set(i, j, typename TypeParam::Type(data[i * 5 + j]));
+    }
+  }
+  for (std::uint64_t i(0); i < 5; ++i)
+  {
+    for (std::uint64_t j(0); j < 8; ++j)
+    {
+      b.Set(i, j, typename TypeParam::Type(int(i * 8 + j) - 17));
+    }
+  }
+  for (std::uint64_t j(0); j < 8; ++j)
+  {
+    error.Set(j / 4, j % 4, typename TypeParam::Type(int(j) - 3));
+  }
+
+  fetch::ml::ops::MatrixMultiply<TypeParam> op;
+  TypeParam prediction = op.fetch::ml::template Ops<TypeParam, 2>::ForwardBatch({std::cref(a), std::cref(b)});
+  std::vector<TypeParam> backpropagatedSignals =
+    op.fetch::ml::template Ops<TypeParam, 2>::BackwardBatch(std::vector<std::reference_wrapper<TypeParam const>>({a, b}), error);
+
+  ASSERT_EQ(prediction.shape(), (std::array<typename TypeParam::SizeType, 2>({2, 4})));
+  ASSERT_EQ(backpropagatedSignals[0].shape(), (std::array<typename TypeParam::SizeType, 2>({2, 5})));
+  ASSERT_EQ(backpropagatedSignals[1].shape(), (std::array<typename TypeParam::SizeType, 2>({5, 8})));
+
+  // Each sample must give the same results as the non batch version on its own block
+  for (std::uint64_t s(0); s < 2; ++s)
+  {
+    TypeParam a_s({1, 5});
+    TypeParam b_s({5, 4});
+    TypeParam error_s({1, 4});
+    for (std::uint64_t j(0); j < 5; ++j)
+    {
+      a_s.Set(0, j, a.Get(s, j));
+      for (std::uint64_t k(0); k < 4; ++k)
+      {
+        b_s.Set(j, k, b.Get(j, s * 4 + k));
+      }
+    }
+    for (std::uint64_t k(0); k < 4; ++k)
+    {
+      error_s.Set(0, k, error.Get(s, k));
+    }
+
+    TypeParam expected = op.fetch::ml::template Ops<TypeParam, 2>::Forward({std::cref(a_s), std::cref(b_s)});
+    std::vector<TypeParam> expected_signals =
+      op.fetch::ml::template Ops<TypeParam, 2>::Backward(std::vector<std::reference_wrapper<TypeParam const>>({a_s, b_s}), error_s);
+    for (std::uint64_t k(0); k < 4; ++k)
+    {
+      EXPECT_EQ(prediction.Get(s, k), expected.Get(0, k));
+    }
+    for (std::uint64_t j(0); j < 5; ++j)
+    {
+      EXPECT_EQ(backpropagatedSignals[0].Get(s, j), expected_signals[0].Get(0, j));
+      for (std::uint64_t k(0); k < 4; ++k)
+      {
+        EXPECT_EQ(backpropagatedSignals[1].Get(j, s * 4 + k), expected_signals[1].Get(j, k));
+      }
+    }
+  }
+}
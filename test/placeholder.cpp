@@ -19,9 +19,21 @@
 #include "placeholder.hpp"
 #include "tensor.hpp"
 #include <gtest/gtest.h>
+#include <type_traits>
+#include <utility>
 
 using ArrayType = fetch::math::Tensor<int, 1>;
 
+template <typename Op, typename Arg, typename = void>
+struct CanBind : std::false_type
+{
+};
+
+template <typename Op, typename Arg>
+struct CanBind<Op, Arg, decltype(void(std::declval<Op &>().Bind(std::declval<Arg>())))> : std::true_type
+{
+};
+
 TEST(placeholder_test, setData)
 {
   ArrayType data({8});
@@ -38,6 +50,66 @@ TEST(placeholder_test, setData)
   }  
 }
 
+TEST(placeholder_test, bind)
+{
+  ArrayType data({8});
+  ArrayType other({4});
+  fetch::ml::ops::PlaceHolder<ArrayType, 1> op;
+  EXPECT_FALSE(op.HasData());
+  EXPECT_TRUE(op.Bind(data));
+  EXPECT_TRUE(op.HasData());
+  EXPECT_EQ(&op.Data(), &data);
+
+  // Refilled in place : the placeholder sees the new content without being fed again
+  for (uint64_t i(0) ; i < data.Size() ; ++i)
+  {
+    data.Set(i, int(i * 3));
+  }
+  ArrayType prediction = op.fetch::ml::template Ops<ArrayType, 1>::Forward({});
+  EXPECT_EQ(prediction.Storage(), data.Storage());
+  for (uint64_t i(0) ; i < data.Size() ; ++i)
+  {
+    EXPECT_EQ(prediction.Get(i), int(i * 3));
+  }
+
+  ArrayType same_shape({8});
+  EXPECT_FALSE(op.Bind(same_shape));
+  EXPECT_EQ(&op.Data(), &same_shape);
+  EXPECT_TRUE(op.Bind(other));
+
+  // Only a tensor owned by the caller can be bound, a temporary would be read after its destruction
+  static_assert(CanBind<decltype(op), ArrayType &>::value, "");
+  static_assert(!CanBind<decltype(op), ArrayType>::value, "");
+
+  // SetData goes back to a placeholder sharing the ownership of its data
+  EXPECT_FALSE(op.SetData(ArrayType({4})));
+  EXPECT_NE(&op.Data(), &other);
+}
+
+TEST(placeholder_test, rebind_after_bound_data_is_gone)
+{
+  fetch::ml::ops::PlaceHolder<ArrayType, 1> op;
+  {
+    ArrayType data({8});
+    EXPECT_TRUE(op.Bind(data));
+    op.Unbind();
+  }
+  EXPECT_FALSE(op.HasData());
+
+  // The shape is compared with the one remembered, not read from the destroyed tensor
+  ArrayType same_shape({8});
+  EXPECT_FALSE(op.Bind(same_shape));
+  EXPECT_EQ(&op.Data(), &same_shape);
+  op.Unbind();
+  {
+    ArrayType data({8});
+    EXPECT_FALSE(op.Bind(data));
+    op.Unbind();
+  }
+  ArrayType other({3});
+  EXPECT_TRUE(op.Bind(other));
+}
+
 // TEST(placeholder_test, resetData)
 // {
 //   fetch::math::Tensor<int> data(8);
@@ -0,0 +1,113 @@
+//------------------------------------------------------------------------------
+//
+//   Copyright 2018-2019 Fetch.AI Limited
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//------------------------------------------------------------------------------
+
+#include "shared_memory_averager.hpp"
+#include "tensor.hpp"
+#include <gtest/gtest.h>
+
+using ArrayType = fetch::math::Tensor<float, 2>;
+
+fetch::ml::StateDict<ArrayType> MakeModel(float value)
+{
+  fetch::ml::StateDict<ArrayType> model;
+  model.dict_["Words"].weights_   = std::make_shared<ArrayType>(std::array<uint64_t, 2>{{3, 5}});
+  model.dict_["Weights"].weights_ = std::make_shared<ArrayType>(std::array<uint64_t, 2>{{4, 2}});
+  model.dict_["Words"].weights_->Fill(value);
+  model.dict_["Weights"].weights_->Fill(-value);
+  return model;
+}
+
+bool AllEqual(ArrayType const &t, float value)
+{
+  for (float v : t)
+    {
+      if (v != value)
+	{
+	  return false;
+	}
+    }
+  return true;
+}
+
+TEST(SharedMemoryAveragerTest, processes_end_up_with_the_average)
+{
+  fetch::ml::StateDict<ArrayType> model = MakeModel(0);
+  fetch::ml::SharedMemoryAverager<ArrayType> averager(model, 3);
+  unsigned int rank = averager.Fork();
+  // Ranks 0, 1 and 2 hold 0, 3 and 6
+  model.dict_["Words"].weights_->Fill(3.0f * rank);
+  model.dict_["Weights"].weights_->Fill(-3.0f * rank);
+  averager.Average(model);
+  bool ok = AllEqual(*model.dict_["Words"].weights_, 3.0f) && AllEqual(*model.dict_["Weights"].weights_, -3.0f);
+
+  // A second round reuses the same slots
+  model.dict_["Words"].weights_->Fill(float(rank));
+  averager.Average(model);
+  ok = ok && AllEqual(*model.dict_["Words"].weights_, 1.0f);
+  if (rank != 0)
+    {
+      _exit(ok ? 0 : 1);
+    }
+  ASSERT_TRUE(ok);
+  ASSERT_TRUE(averager.Join());
+}
+
+TEST(SharedMemoryAveragerTest, processed_counter_is_shared)
+{
+  fetch::ml::StateDict<ArrayType> model = MakeModel(1);
+  fetch::ml::SharedMemoryAverager<ArrayType> averager(model, 2);
+  unsigned int rank = averager.Fork();
+  averager.Processed().fetch_add(rank + 1);
+  // Averaging is a synchronisation point between the processes
+  averager.Average(model);
+  bool ok = averager.Processed().load() == 3 && AllEqual(*model.dict_["Words"].weights_, 1.0f);
+  if (rank != 0)
+    {
+      _exit(ok ? 0 : 1);
+    }
+  ASSERT_TRUE(ok);
+  ASSERT_TRUE(averager.Join());
+}
+
+TEST(SharedMemoryAveragerTest, dead_process_fails_the_barrier)
+{
+  fetch::ml::StateDict<ArrayType> model = MakeModel(1);
+  fetch::ml::SharedMemoryAverager<ArrayType> averager(model, 3);
+  unsigned int rank = averager.Fork();
+  if (rank == 2)
+    {
+      // Dies without ever averaging
+      _exit(0);
+    }
+  // The others must not wait for it forever
+  bool failed(false);
+  try
+    {
+      averager.Average(model);
+    }
+  catch (std::runtime_error const &)
+    {
+      failed = true;
+    }
+  if (rank != 0)
+    {
+      _exit(failed ? 0 : 1);
+    }
+  ASSERT_TRUE(failed);
+  ASSERT_FALSE(averager.Join());
+}
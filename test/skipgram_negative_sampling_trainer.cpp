@@ -0,0 +1,182 @@
+//------------------------------------------------------------------------------
+//
+//   Copyright 2018-2019 Fetch.AI Limited
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//------------------------------------------------------------------------------
+
+#include "cbow_negative_sampling_trainer.hpp"
+#include "embeddings.hpp"
+#include "graph.hpp"
+#include "inplace_transpose.hpp"
+#include "matrix_multiply.hpp"
+#include "placeholder.hpp"
+#include "sigmoid.hpp"
+#include "skipgram_negative_sampling_trainer.hpp"
+#include "weights.hpp"
+#include "tensor.hpp"
+#include <gtest/gtest.h>
+
+using ArrayType = fetch::math::Tensor<float, 2>;
+
+/*
+ * With a single context word, a Skip-gram step is a CBOW step where the center word is the only
+ * context word
+ */
+TEST(skipgram_negative_sampling_trainer_test, single_pair_matches_cbow)
+{
+  std::uint64_t vocab_size(20), dimensions(10);
+  ArrayType skipgram_words({vocab_size, dimensions});
+  ArrayType skipgram_weights({vocab_size, dimensions});
+  fetch::ml::ops::Weights<ArrayType, 2>::Initialise(skipgram_words, vocab_size, dimensions);
+  fetch::ml::ops::Weights<ArrayType, 2>::Initialise(skipgram_weights, vocab_size, dimensions);
+  ArrayType cbow_words = skipgram_words.Clone();
+  ArrayType cbow_weights = skipgram_weights.Clone();
+
+  fetch::ml::SkipGramNegativeSamplingTrainer<float> skipgram(skipgram_words, skipgram_weights);
+  fetch::ml::CBOWNegativeSamplingTrainer<float> cbow(cbow_words, cbow_weights);
+
+  ArrayType center({1, 1});
+  ArrayType targets({3, 4});
+  ArrayType cbow_targets({1, 4});
+  for (std::uint64_t step(0) ; step < 10 ; ++step)
+    {
+      center.Set(0, 0, float(step));
+      for (std::uint64_t k(0) ; k < 4 ; ++k)
+	{
+	  targets.Set(0, k, float((step * 3 + k * 7 + 1) % vocab_size));
+	  cbow_targets.Set(0, k, targets.Get(0, k));
+	}
+      // Unused rows
+      targets.Set(1, 0, -1.0f);
+      targets.Set(2, 0, -1.0f);
+
+      skipgram.Step(center, targets, 0.1f);
+      cbow.Step(center, cbow_targets, 0.1f);
+    }
+
+  for (std::uint64_t i(0) ; i < vocab_size ; ++i)
+    {
+      for (std::uint64_t j(0) ; j < dimensions ; ++j)
+	{
+	  EXPECT_FLOAT_EQ(skipgram_words.Get(i, j), cbow_words.Get(i, j));
+	  EXPECT_FLOAT_EQ(skipgram_weights.Get(i, j), cbow_weights.Get(i, j));
+	}
+    }
+}
+
+TEST(skipgram_negative_sampling_trainer_test, center_updated_once_per_window)
+{
+  std::uint64_t vocab_size(10), dimensions(4);
+  ArrayType words({vocab_size, dimensions});
+  ArrayType weights({vocab_size, dimensions});
+  fetch::ml::ops::Weights<ArrayType, 2>::Initialise(words, vocab_size, dimensions);
+  fetch::ml::ops::Weights<ArrayType, 2>::Initialise(weights, vocab_size, dimensions);
+  ArrayType initial_words = words.Clone();
+  ArrayType initial_weights = weights.Clone();
+
+  ArrayType center({1, 1});
+  center.Set(0, 0, 0.0f);
+  ArrayType targets({2, 2});
+  targets.Set(0, 0, 1.0f);
+  targets.Set(0, 1, 2.0f);
+  targets.Set(1, 0, 3.0f);
+  targets.Set(1, 1, 4.0f);
+
+  fetch::ml::SkipGramNegativeSamplingTrainer<float> trainer(words, weights);
+  trainer.Step(center, targets, 1.0f);
+
+  // Expected center update, all computed from the initial center row
+  std::vector<float> center_error(dimensions, 0.0f);
+  for (std::uint64_t k(1) ; k <= 4 ; ++k)
+    {
+      float dot(0);
+      for (std::uint64_t j(0) ; j < dimensions ; ++j)
+	{
+	  dot += initial_words.Get(0, j) * initial_weights.Get(k, j);
+	}
+      float error = ((k == 1 || k == 3) ? 1.0f : 0.0f) - 1.0f / (1.0f + std::exp(-dot));
+      for (std::uint64_t j(0) ; j < dimensions ; ++j)
+	{
+	  center_error[j] += error * initial_weights.Get(k, j);
+	  EXPECT_NEAR(weights.Get(k, j), initial_weights.Get(k, j) + error * initial_words.Get(0, j), 1e-6);
+	}
+    }
+  for (std::uint64_t j(0) ; j < dimensions ; ++j)
+    {
+      EXPECT_NEAR(words.Get(0, j), initial_words.Get(0, j) + center_error[j], 1e-6);
+    }
+}
+
+/*
+ * The graph version used by main with --skipgram --graph : the center word goes through a plain
+ * Embeddings lookup. With one pair per window, it matches the fused trainer
+ */
+TEST(skipgram_negative_sampling_trainer_test, single_pair_same_as_graph)
+{
+  std::uint64_t vocab_size(20), dimensions(10);
+  ArrayType graph_words({vocab_size, dimensions});
+  ArrayType graph_weights({vocab_size, dimensions});
+  fetch::ml::ops::Weights<ArrayType, 2>::Initialise(graph_words, vocab_size, dimensions);
+  fetch::ml::ops::Weights<ArrayType, 2>::Initialise(graph_weights, vocab_size, dimensions);
+  ArrayType fused_words = graph_words.Clone();
+  ArrayType fused_weights = graph_weights.Clone();
+
+  fetch::ml::Graph<ArrayType> g;
+  auto center_node = g.AddNode<fetch::ml::ops::PlaceHolder<ArrayType, 2>>("Context", {});
+  g.AddNode<fetch::ml::ops::Embeddings<ArrayType>>("Words", {"Context"}, graph_words);
+  auto target_node = g.AddNode<fetch::ml::ops::PlaceHolder<ArrayType, 2>>("Target", {});
+  g.AddNode<fetch::ml::ops::Embeddings<ArrayType>>("Weights", {"Target"}, graph_weights);
+  g.AddNode<fetch::ml::ops::InplaceTranspose<ArrayType>>("WeightsTranspose", {"Weights"});
+  auto dot_product = g.AddNode<fetch::ml::ops::MatrixMultiply<ArrayType>>("DotProduct", {"Words", "WeightsTranspose"});
+  auto sigmoid = g.AddNode<fetch::ml::ops::Sigmoid<ArrayType>>("Sigmoid", {"DotProduct"});
+  g.Compile();
+
+  fetch::ml::SkipGramNegativeSamplingTrainer<float> trainer(fused_words, fused_weights);
+
+  ArrayType center({1, 1});
+  ArrayType targets({2, 4});
+  ArrayType ground_truth({1, 4});
+  ArrayType error({1, 4});
+  ground_truth.Set(0, 0, 1.0f);
+  for (std::uint64_t step(0) ; step < 10 ; ++step)
+    {
+      center.Set(0, 0, float(step));
+      for (std::uint64_t k(0) ; k < 4 ; ++k)
+	{
+	  targets.Set(0, k, float((step * 3 + k * 7 + 1) % vocab_size));
+	}
+      targets.Set(1, 0, -1.0f);
+
+      ArrayType pair_targets({1, 4});
+      pair_targets.Slice(0).Copy(targets.Slice(0));
+      g.SetInput(center_node, center);
+      g.SetInput(target_node, pair_targets);
+      error.Assign(ground_truth - g.Evaluate(sigmoid));
+      g.SetDirectUpdate(0.1f);
+      g.BackPropagate(dot_product, error);
+      g.Step(0.1f);
+
+      trainer.Step(center, targets, 0.1f);
+    }
+
+  for (std::uint64_t i(0) ; i < vocab_size ; ++i)
+    {
+      for (std::uint64_t j(0) ; j < dimensions ; ++j)
+	{
+	  EXPECT_NEAR(fused_words.Get(i, j), graph_words.Get(i, j), 1e-6);
+	  EXPECT_NEAR(fused_weights.Get(i, j), graph_weights.Get(i, j), 1e-6);
+	}
+    }
+}
@@ -0,0 +1,89 @@
+//------------------------------------------------------------------------------
+//
+//   Copyright 2018-2019 Fetch.AI Limited
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//------------------------------------------------------------------------------
+
+#include "spsc_ring_buffer.hpp"
+#include <gtest/gtest.h>
+#include <thread>
+
+TEST(SPSCRingBufferTest, capacity_is_rounded_to_power_of_2)
+{
+  fetch::ml::SPSCRingBuffer<int> ring(5, []() { return 0; });
+  ASSERT_EQ(ring.Capacity(), 8);
+}
+
+TEST(SPSCRingBufferTest, items_come_out_in_order)
+{
+  fetch::ml::SPSCRingBuffer<uint64_t> ring(4, []() { return uint64_t(0); });
+  std::thread producer([&]() {
+      for (uint64_t i(0) ; i < 1000 ; ++i)
+	{
+	  uint64_t *slot = ring.BeginPush();
+	  ASSERT_NE(slot, nullptr);
+	  *slot = i;
+	  ring.EndPush();
+	}
+      ring.Close();
+    });
+  uint64_t expected(0);
+  while (uint64_t const *slot = ring.BeginPop())
+    {
+      ASSERT_EQ(*slot, expected);
+      ring.EndPop();
+      ++expected;
+    }
+  producer.join();
+  ASSERT_EQ(expected, 1000);
+}
+
+TEST(SPSCRingBufferTest, full_ring_blocks_producer_until_pop)
+{
+  fetch::ml::SPSCRingBuffer<int> ring(2, []() { return 0; });
+  for (int i(0) ; i < 2 ; ++i)
+    {
+      *ring.BeginPush() = i;
+      ring.EndPush();
+    }
+  std::thread producer([&]() {
+      *ring.BeginPush() = 2;
+      ring.EndPush();
+    });
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  ASSERT_EQ(*ring.BeginPop(), 0);
+  ring.EndPop();
+  producer.join();
+  ASSERT_EQ(ring.ProducerWaits(), 1);
+  ASSERT_EQ(*ring.BeginPop(), 1);
+  ring.EndPop();
+  ASSERT_EQ(*ring.BeginPop(), 2);
+  ring.EndPop();
+}
+
+TEST(SPSCRingBufferTest, close_unblocks_both_sides)
+{
+  fetch::ml::SPSCRingBuffer<int> ring(1, []() { return 0; });
+  ASSERT_NE(ring.BeginPush(), nullptr);
+  ring.EndPush();
+  std::thread producer([&]() { ASSERT_EQ(ring.BeginPush(), nullptr); });
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  ring.Close();
+  producer.join();
+  // Items pushed before closing can still be read
+  ASSERT_NE(ring.BeginPop(), nullptr);
+  ring.EndPop();
+  ASSERT_EQ(ring.BeginPop(), nullptr);
+}
@@ -0,0 +1,107 @@
+//------------------------------------------------------------------------------
+//
+//   Copyright 2018-2019 Fetch.AI Limited
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//------------------------------------------------------------------------------
+
+#include "sigmoid.hpp"
+#include "table_sigmoid.hpp"
+#include "tensor.hpp"
+#include <gtest/gtest.h>
+
+#include <limits>
+
+template <typename T>
+class TableSigmoidTest : public ::testing::Test
+{
+};
+
+using MyTypes = ::testing::Types<float, double>;
+
+TYPED_TEST_CASE(TableSigmoidTest, MyTypes);
+
+TYPED_TEST(TableSigmoidTest, forward_test)
+{
+  using ArrayType = fetch::math::Tensor<TypeParam, 2>;
+
+  ArrayType data({1, 8});
+  std::vector<double> dataInput({1, -2, 3, -4, 5, -5.99, 0.01, 0});
+  for (std::uint64_t i(0); i < 8; ++i)
+  {
+    data.Set(0, i, TypeParam(dataInput[i]));
+  }
+  fetch::ml::ops::Sigmoid<ArrayType>      exact_op;
+  fetch::ml::ops::TableSigmoid<ArrayType> op;
+  ArrayType gt         = exact_op.fetch::ml::template Ops<ArrayType, 2>::Forward({std::cref(data)});
+  ArrayType prediction = op.fetch::ml::template Ops<ArrayType, 2>::Forward({std::cref(data)});
+
+  // Buckets are 0.012 wide and the slope of the sigmoid is at most 0.25
+  for (std::uint64_t i(0); i < 8; ++i)
+  {
+    EXPECT_NEAR(prediction.Get(0, i), gt.Get(0, i), 0.0016);
+  }
+}
+
+TYPED_TEST(TableSigmoidTest, clamping_test)
+{
+  fetch::math::SigmoidTable<TypeParam> table(100, TypeParam(2));
+  EXPECT_EQ(table.Size(), 100);
+  EXPECT_EQ(table(TypeParam(2)), TypeParam(1));
+  EXPECT_EQ(table(TypeParam(50)), TypeParam(1));
+  EXPECT_EQ(table(TypeParam(-2.001)), TypeParam(0));
+  EXPECT_EQ(table(TypeParam(-50)), TypeParam(0));
+  EXPECT_NEAR(table(TypeParam(1.999)), TypeParam(1.0 / (1.0 + std::exp(-2.0))), 0.01);
+  EXPECT_NEAR(table(TypeParam(-1.999)), TypeParam(1.0 / (1.0 + std::exp(2.0))), 0.01);
+
+  // Without a table, the exact value is computed
+  EXPECT_NEAR(fetch::math::Sigmoid(TypeParam(3)), TypeParam(0.952574), 1e-6);
+  EXPECT_EQ(fetch::math::Sigmoid(TypeParam(3), &table), TypeParam(1));
+}
+
+TYPED_TEST(TableSigmoidTest, nan_test)
+{
+  fetch::math::SigmoidTable<TypeParam> table(100, TypeParam(2));
+  EXPECT_EQ(table(std::numeric_limits<TypeParam>::quiet_NaN()), TypeParam(0));
+  EXPECT_EQ(table(-std::numeric_limits<TypeParam>::quiet_NaN()), TypeParam(0));
+  EXPECT_EQ(table(std::numeric_limits<TypeParam>::infinity()), TypeParam(1));
+  EXPECT_EQ(table(-std::numeric_limits<TypeParam>::infinity()), TypeParam(0));
+}
+
+TYPED_TEST(TableSigmoidTest, backward_test)
+{
+  using ArrayType = fetch::math::Tensor<TypeParam, 2>;
+
+  ArrayType           data({1, 8});
+  ArrayType           error({1, 8});
+  std::vector<double> dataInput({1, -2, 3, -4, 5, -6.5, 7, -8});
+  std::vector<double> errorInput({1, 2, 0, -1, 1, 1, 1, 0});
+  for (std::uint64_t i(0); i < 8; ++i)
+  {
+    data.Set(0, i, TypeParam(dataInput[i]));
+    error.Set(0, i, TypeParam(errorInput[i]));
+  }
+  fetch::ml::ops::Sigmoid<ArrayType>      exact_op;
+  fetch::ml::ops::TableSigmoid<ArrayType> op;
+  std::vector<ArrayType> gt         = exact_op.fetch::ml::template Ops<ArrayType, 2>::Backward({data}, error);
+  std::vector<ArrayType> prediction = op.fetch::ml::template Ops<ArrayType, 2>::Backward({data}, error);
+
+  for (std::uint64_t i(0); i < 8; ++i)
+  {
+    EXPECT_NEAR(prediction[0].Get(0, i), gt[0].Get(0, i), 0.004);
+  }
+  // Saturated values have no gradient
+  EXPECT_EQ(prediction[0].Get(0, 5), TypeParam(0));
+  EXPECT_EQ(prediction[0].Get(0, 6), TypeParam(0));
+}
@@ -0,0 +1,397 @@
+//------------------------------------------------------------------------------
+//
+//   Copyright 2018-2019 Fetch.AI Limited
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//------------------------------------------------------------------------------
+
+#include "cbow_graph.hpp"
+#include "cbow_hierarchical_softmax_trainer.hpp"
+#include "cbow_negative_sampling_trainer.hpp"
+#include "cbow_shared_negatives_trainer.hpp"
+#include "huffman_tree.hpp"
+#include "skipgram_negative_sampling_trainer.hpp"
+#include "sigmoid.hpp"
+#include "tensor.hpp"
+#include "tensor_arena.hpp"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// Every heap allocation of the test executable goes through here
+// All the replaceable forms share one allocation and one deallocation function, so whichever
+// delete releases a block, it matches the new that returned it
+static std::atomic<std::uint64_t> nb_allocations(0);
+
+static void *Allocate(std::size_t size) noexcept
+{
+  ++nb_allocations;
+  return std::malloc(size ? size : 1);
+}
+
+// Once a replaced delete is inlined at a delete expression, GCC sees free() called on the result of
+// a new expression and warns, although this free() matches the malloc() in Allocate
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+static void Deallocate(void *p) noexcept
+{
+  std::free(p);
+}
+#pragma GCC diagnostic pop
+
+void *operator new(std::size_t size)
+{
+  void *p = Allocate(size);
+  if (!p)
+    {
+      throw std::bad_alloc();
+    }
+  return p;
+}
+
+void *operator new[](std::size_t size)
+{
+  return operator new(size);
+}
+
+void *operator new(std::size_t size, std::nothrow_t const &) noexcept
+{
+  return Allocate(size);
+}
+
+void *operator new[](std::size_t size, std::nothrow_t const &) noexcept
+{
+  return Allocate(size);
+}
+
+void operator delete(void *p) noexcept
+{
+  Deallocate(p);
+}
+
+void operator delete[](void *p) noexcept
+{
+  Deallocate(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept
+{
+  Deallocate(p);
+}
+
+void operator delete[](void *p, std::size_t) noexcept
+{
+  Deallocate(p);
+}
+
+void operator delete(void *p, std::nothrow_t const &) noexcept
+{
+  Deallocate(p);
+}
+
+void operator delete[](void *p, std::nothrow_t const &) noexcept
+{
+  Deallocate(p);
+}
+
+using ArrayType = fetch::math::Tensor<float, 2>;
+
+TEST(TensorArenaTest, aligned_and_reset)
+{
+  fetch::math::TensorArena arena(1024);
+  std::size_t const alignment = fetch::math::TensorArena::ALIGNMENT;
+  char *a = static_cast<char *>(arena.Allocate(10));
+  char *b = static_cast<char *>(arena.Allocate(1));
+  ASSERT_EQ(reinterpret_cast<std::uintptr_t>(a) % alignment, 0);
+  ASSERT_EQ(b - a, alignment);
+
+  // Growing past the first chunk, then Reset merges everything in one chunk
+  for (int i(0) ; i < 100 ; ++i)
+    {
+      ASSERT_EQ(reinterpret_cast<std::uintptr_t>(arena.Allocate(100)) % alignment, 0);
+    }
+  std::size_t capacity = arena.Capacity();
+  ASSERT_GT(capacity, 1024);
+  arena.Reset();
+  ASSERT_EQ(arena.Capacity(), capacity);
+  char *c = static_cast<char *>(arena.Allocate(10));
+  char *d = static_cast<char *>(arena.Allocate(capacity - alignment));
+  ASSERT_EQ(d - c, alignment);
+  ASSERT_EQ(arena.Capacity(), capacity);
+
+  // Steps after the first one reuse the same memory
+  arena.Reset();
+  ASSERT_EQ(static_cast<char *>(arena.Allocate(10)), c);
+}
+
+TEST(TensorArenaTest, temporaries_come_from_the_scope)
+{
+  fetch::math::TensorArena arena;
+  for (int step(0) ; step < 3 ; ++step)
+    {
+      arena.Reset();
+      std::uint64_t before = nb_allocations;
+      {
+	fetch::math::TensorArena::Scope scope(&arena);
+	ArrayType t = ArrayType::Temporary({10, 100});
+	ArrayType u({3, 3}, arena);
+	t.Set(9, 99, 1.0f);
+	u.Fill(2.0f);
+	ASSERT_EQ(t.Get(9, 99), 1.0f);
+	ASSERT_EQ(t.Get(0, 0), 0.0f);
+	ASSERT_EQ(reinterpret_cast<std::uintptr_t>(t.RowPointer(1)) % ArrayType::ALIGNMENT, 0);
+
+	// A nullptr scope goes back to the heap
+	fetch::math::TensorArena::Scope heap(nullptr);
+	ASSERT_EQ(fetch::math::TensorArena::Current(), nullptr);
+	ArrayType v = ArrayType::Temporary({2, 2});
+	ASSERT_EQ(nb_allocations, before + 2);  // Storage and control block
+      }
+      ASSERT_EQ(fetch::math::TensorArena::Current(), nullptr);
+    }
+}
+
+// The convenience overloads of the ops allocate their outputs as temporaries, from the arena
+TEST(TensorArenaTest, op_outputs_come_from_the_scope)
+{
+  fetch::ml::ops::Sigmoid<ArrayType> sigmoid_op;
+  // Called through the interface, as the graph does : Sigmoid's own Forward hides the overload
+  fetch::ml::Ops<ArrayType, 2> &sigmoid = sigmoid_op;
+  ArrayType input({4, 25});
+  std::vector<std::reference_wrapper<ArrayType const>> inputs({input});
+  fetch::math::TensorArena arena;
+  for (int step(0) ; step < 3 ; ++step)
+    {
+      arena.Reset();
+      std::uint64_t before = nb_allocations;
+      {
+	fetch::math::TensorArena::Scope scope(&arena);
+	ArrayType output = sigmoid.Forward(inputs);
+	ASSERT_EQ(output.Get(3, 24), 0.5f);
+      }
+      ASSERT_EQ(nb_allocations, before);
+    }
+
+  // Without a scope, the same call goes to the heap
+  std::uint64_t before = nb_allocations;
+  ArrayType output = sigmoid.Forward(inputs);
+  ASSERT_GT(nb_allocations, before);
+}
+
+/*
+ * The CBOW graph trained as in main : once warm, a step must not allocate anything
+ * No arena is needed for that, the nodes reuse their buffers and nothing on this path asks for
+ * a temporary
+ */
+void CheckGraphStepDoesNotAllocate(bool compile, bool bind = false)
+{
+  std::uint64_t vocab_size(50), dimensions(16), window(6), negatives(5);
+  ArrayType words({vocab_size, dimensions});
+  ArrayType weights({vocab_size, dimensions});
+  fetch::ml::ops::Weights<ArrayType, 2>::Initialise(words, vocab_size, dimensions);
+  fetch::ml::ops::Weights<ArrayType, 2>::Initialise(weights, vocab_size, dimensions);
+
+  fetch::ml::Graph<ArrayType> graph;
+  CBOWGraph<ArrayType> cbow = AddCBOW(graph, words, weights);
+  if (compile)
+    {
+      graph.Compile();
+    }
+
+  std::vector<ArrayType> contexts;
+  std::vector<ArrayType> targets;
+  for (std::uint64_t s(0) ; s < 16 ; ++s)
+    {
+      contexts.push_back(ArrayType({1, window}));
+      targets.push_back(ArrayType({1, negatives}));
+      FillCBOWSample(contexts.back(), targets.back(), s, vocab_size);
+    }
+  ArrayType error({1, negatives});
+  ArrayType ground_truth({1, negatives});
+  ground_truth.Set(0, 0, 1.0f);
+
+  auto step = [&](std::uint64_t s) {
+    if (bind)
+      {
+	graph.BindInput(cbow.context, contexts[s % contexts.size()]);
+	graph.BindInput(cbow.target, targets[s % targets.size()]);
+      }
+    else
+      {
+	graph.SetInput("Context", contexts[s % contexts.size()]);
+	graph.SetInput("Target", targets[s % targets.size()]);
+      }
+    auto const &prediction = graph.Evaluate("Sigmoid");
+    error.Assign(ground_truth - prediction);
+    graph.SetDirectUpdate(0.1f);
+    graph.BackPropagate("DotProduct", error);
+    graph.Step(0.1f);
+  };
+
+  for (std::uint64_t s(0) ; s < 16 ; ++s)
+    {
+      step(s);
+    }
+  std::uint64_t before = nb_allocations;
+  for (std::uint64_t s(0) ; s < 1000 ; ++s)
+    {
+      step(s);
+    }
+  ASSERT_EQ(nb_allocations, before);
+}
+
+TEST(TensorArenaTest, graph_step_does_not_allocate)
+{
+  CheckGraphStepDoesNotAllocate(false);
+}
+
+TEST(TensorArenaTest, compiled_graph_step_does_not_allocate)
+{
+  CheckGraphStepDoesNotAllocate(true);
+}
+
+TEST(TensorArenaTest, bound_inputs_graph_step_does_not_allocate)
+{
+  CheckGraphStepDoesNotAllocate(true, true);
+}
+
+/*
+ * Same check for the fused trainers, used by main unless --graph is given : once warm, Step must
+ * not allocate anything
+ */
+template <typename Trainer>
+void CheckTrainerStepDoesNotAllocate(Trainer &trainer, std::vector<ArrayType> const &contexts, std::vector<ArrayType> const &targets)
+{
+  for (std::uint64_t s(0) ; s < contexts.size() ; ++s)
+    {
+      trainer.Step(contexts[s], targets[s], 0.01f);
+    }
+  std::uint64_t before = nb_allocations;
+  for (std::uint64_t s(0) ; s < 1000 ; ++s)
+    {
+      trainer.Step(contexts[s % contexts.size()], targets[s % targets.size()], 0.01f);
+    }
+  ASSERT_EQ(nb_allocations, before);
+}
+
+// CBOW samples as main builds them : [1 x window] context words and [1 x K] targets
+void MakeCBOWSamples(std::vector<ArrayType> &contexts, std::vector<ArrayType> &targets, std::uint64_t vocab_size)
+{
+  for (std::uint64_t s(0) ; s < 16 ; ++s)
+    {
+      contexts.push_back(ArrayType({1, 6}));
+      targets.push_back(ArrayType({1, 5}));
+      FillCBOWSample(contexts.back(), targets.back(), s, vocab_size);
+    }
+}
+
+TEST(TensorArenaTest, cbow_negative_sampling_step_does_not_allocate)
+{
+  std::uint64_t vocab_size(50), dimensions(100);
+  ArrayType words({vocab_size, dimensions});
+  ArrayType weights({vocab_size, dimensions});
+  fetch::ml::ops::Weights<ArrayType, 2>::Initialise(words, vocab_size, dimensions);
+  fetch::ml::ops::Weights<ArrayType, 2>::Initialise(weights, vocab_size, dimensions);
+  std::vector<ArrayType> contexts, targets;
+  MakeCBOWSamples(contexts, targets, vocab_size);
+
+  fetch::ml::CBOWNegativeSamplingTrainer<float> trainer(words, weights);
+  CheckTrainerStepDoesNotAllocate(trainer, contexts, targets);
+}
+
+TEST(TensorArenaTest, cbow_hierarchical_softmax_step_does_not_allocate)
+{
+  std::uint64_t vocab_size(50), dimensions(100);
+  std::vector<std::uint64_t> frequencies;
+  for (std::uint64_t i(0) ; i < vocab_size ; ++i)
+    {
+      frequencies.push_back((i * 37) % 51 + 1);
+    }
+  fetch::ml::HuffmanTree tree(frequencies);
+  ArrayType words({vocab_size, dimensions});
+  ArrayType inner_nodes({tree.NbInnerNodes(), dimensions});
+  fetch::ml::ops::Weights<ArrayType, 2>::Initialise(words, vocab_size, dimensions);
+  fetch::ml::ops::Weights<ArrayType, 2>::Initialise(inner_nodes, tree.NbInnerNodes(), dimensions);
+  std::vector<ArrayType> contexts, targets;
+  MakeCBOWSamples(contexts, targets, vocab_size);
+
+  fetch::ml::CBOWHierarchicalSoftmaxTrainer<float> trainer(words, inner_nodes, tree);
+  CheckTrainerStepDoesNotAllocate(trainer, contexts, targets);
+}
+
+TEST(TensorArenaTest, cbow_shared_negatives_step_does_not_allocate)
+{
+  std::uint64_t vocab_size(50), dimensions(100), batch_size(4), negatives(5);
+  ArrayType words({vocab_size, dimensions});
+  ArrayType weights({vocab_size, dimensions});
+  fetch::ml::ops::Weights<ArrayType, 2>::Initialise(words, vocab_size, dimensions);
+  fetch::ml::ops::Weights<ArrayType, 2>::Initialise(weights, vocab_size, dimensions);
+
+  // [B x window] contexts, [1 x B + K] targets : one positive per context, then the shared negatives
+  std::vector<ArrayType> contexts, targets;
+  ArrayType sample_targets({batch_size, negatives});
+  for (std::uint64_t s(0) ; s < 16 ; ++s)
+    {
+      contexts.push_back(ArrayType({batch_size, 6}));
+      targets.push_back(ArrayType({1, batch_size + negatives}));
+      for (std::uint64_t b(0) ; b < batch_size ; ++b)
+	{
+	  FillCBOWSample(contexts.back(), sample_targets, s * batch_size + b, vocab_size, b);
+	  targets.back().Set(0, b, sample_targets.Get(b, 0));
+	}
+      for (std::uint64_t k(0) ; k < negatives ; ++k)
+	{
+	  targets.back().Set(0, batch_size + k, sample_targets.Get(0, k));
+	}
+    }
+
+  fetch::ml::CBOWSharedNegativesTrainer<float> trainer(words, weights);
+  CheckTrainerStepDoesNotAllocate(trainer, contexts, targets);
+}
+
+TEST(TensorArenaTest, skipgram_negative_sampling_step_does_not_allocate)
+{
+  std::uint64_t vocab_size(50), dimensions(100), window(6), negatives(5);
+  ArrayType words({vocab_size, dimensions});
+  ArrayType weights({vocab_size, dimensions});
+  fetch::ml::ops::Weights<ArrayType, 2>::Initialise(words, vocab_size, dimensions);
+  fetch::ml::ops::Weights<ArrayType, 2>::Initialise(weights, vocab_size, dimensions);
+
+  // [1 x 1] center word, [window x K] pairs : a context word followed by its negatives, the last
+  // pair of every other sample is padding
+  std::vector<ArrayType> centers, pairs;
+  for (std::uint64_t s(0) ; s < 16 ; ++s)
+    {
+      centers.push_back(ArrayType({1, 1}));
+      pairs.push_back(ArrayType({window, negatives}));
+      centers.back().Set(0, 0, float(s % vocab_size));
+      for (std::uint64_t p(0) ; p < window ; ++p)
+	{
+	  for (std::uint64_t k(0) ; k < negatives ; ++k)
+	    {
+	      pairs.back().Set(p, k, float((s * 7 + p * 3 + k * 11) % vocab_size));
+	    }
+	}
+      if (s % 2)
+	{
+	  pairs.back().Set(window - 1, 0, -1.0f);
+	}
+    }
+
+  fetch::ml::SkipGramNegativeSamplingTrainer<float> trainer(words, weights);
+  CheckTrainerStepDoesNotAllocate(trainer, centers, pairs);
+}
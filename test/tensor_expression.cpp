@@ -0,0 +1,217 @@
+//------------------------------------------------------------------------------
+//
+//   Copyright 2018-2019 Fetch.AI Limited
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//------------------------------------------------------------------------------
+
+#include "tensor.hpp"
+#include <gtest/gtest.h>
+
+template <typename T>
+class TensorExpressionTest : public ::testing::Test
+{
+};
+
+using MyTypes = ::testing::Types<float, double>;
+TYPED_TEST_CASE(TensorExpressionTest, MyTypes);
+
+template <typename T>
+fetch::math::Tensor<T, 2> Make(std::uint64_t rows, std::uint64_t cols, T scale)
+{
+  fetch::math::Tensor<T, 2> t({rows, cols});
+  for (std::uint64_t i(0); i < rows; ++i)
+    {
+      for (std::uint64_t j(0); j < cols; ++j)
+	{
+	  t.Set(i, j, T(i * cols + j + 1) * scale);
+	}
+    }
+  return t;
+}
+
+TYPED_TEST(TensorExpressionTest, assign)
+{
+  fetch::math::Tensor<TypeParam, 2> a = Make<TypeParam>(3, 19, TypeParam(1));
+  fetch::math::Tensor<TypeParam, 2> b = Make<TypeParam>(3, 19, TypeParam(0.5));
+  fetch::math::Tensor<TypeParam, 2> r({3, 19});
+  std::shared_ptr<TypeParam> storage = r.Storage();
+
+  r.Assign(a - b);
+  for (std::uint64_t i(0); i < 3; ++i)
+    {
+      for (std::uint64_t j(0); j < 19; ++j)
+	{
+	  ASSERT_EQ(r.Get(i, j), a.Get(i, j) - b.Get(i, j));
+	}
+    }
+  // Written in place
+  ASSERT_EQ(r.Storage(), storage);
+
+  r.Assign(TypeParam(2) * (a + b) / a - -b * TypeParam(3) + TypeParam(1));
+  for (std::uint64_t i(0); i < 3; ++i)
+    {
+      for (std::uint64_t j(0); j < 19; ++j)
+	{
+	  TypeParam expected = TypeParam(2) * (a.Get(i, j) + b.Get(i, j)) / a.Get(i, j) - -b.Get(i, j) * TypeParam(3) + TypeParam(1);
+	  ASSERT_EQ(r.Get(i, j), expected);
+	}
+    }
+
+  // Same tensor on both sides
+  r.Assign(a);
+  r.Assign(r * r - a);
+  for (std::uint64_t i(0); i < 3; ++i)
+    {
+      for (std::uint64_t j(0); j < 19; ++j)
+	{
+	  ASSERT_EQ(r.Get(i, j), a.Get(i, j) * a.Get(i, j) - a.Get(i, j));
+	}
+    }
+}
+
+TYPED_TEST(TensorExpressionTest, compound_assignments)
+{
+  fetch::math::Tensor<TypeParam, 2> g = Make<TypeParam>(2, 21, TypeParam(0.25));
+  fetch::math::Tensor<TypeParam, 2> w = Make<TypeParam>(2, 21, TypeParam(1));
+  fetch::math::Tensor<TypeParam, 2> expected = w.Clone();
+  TypeParam const lr(0.1);
+
+  w += g * -lr;
+  expected.InlineAdd(g.Clone().InlineMultiply(-lr));
+  for (std::uint64_t i(0); i < 2; ++i)
+    {
+      for (std::uint64_t j(0); j < 21; ++j)
+	{
+	  ASSERT_EQ(w.Get(i, j), expected.Get(i, j));
+	}
+    }
+
+  w -= g;
+  w *= TypeParam(2);
+  w /= g + TypeParam(1);
+  w += TypeParam(3);
+  for (std::uint64_t i(0); i < 2; ++i)
+    {
+      for (std::uint64_t j(0); j < 21; ++j)
+	{
+	  ASSERT_EQ(w.Get(i, j), (expected.Get(i, j) - g.Get(i, j)) * TypeParam(2) / (g.Get(i, j) + TypeParam(1)) + TypeParam(3));
+	}
+    }
+}
+
+TYPED_TEST(TensorExpressionTest, transposed_operands)
+{
+  fetch::math::Tensor<TypeParam, 2> a = Make<TypeParam>(4, 3, TypeParam(1));
+  fetch::math::Tensor<TypeParam, 2> b = Make<TypeParam>(3, 4, TypeParam(2));
+  fetch::math::Tensor<TypeParam, 2> at = a.Transpose();
+  fetch::math::Tensor<TypeParam, 2> r({3, 4});
+
+  r.Assign(at + b);
+  for (std::uint64_t i(0); i < 3; ++i)
+    {
+      for (std::uint64_t j(0); j < 4; ++j)
+	{
+	  ASSERT_EQ(r.Get(i, j), a.Get(j, i) + b.Get(i, j));
+	}
+    }
+
+  // Non dense destination
+  fetch::math::Tensor<TypeParam, 2> bt = b.Transpose();
+  bt += a;
+  for (std::uint64_t i(0); i < 4; ++i)
+    {
+      for (std::uint64_t j(0); j < 3; ++j)
+	{
+	  ASSERT_EQ(b.Get(j, i), TypeParam(2) * TypeParam(j * 4 + i + 1) + a.Get(i, j));
+	}
+    }
+}
+
+TYPED_TEST(TensorExpressionTest, map)
+{
+  fetch::math::Tensor<TypeParam, 2> a = Make<TypeParam>(3, 19, TypeParam(1));
+  fetch::math::Tensor<TypeParam, 2> b = Make<TypeParam>(3, 19, TypeParam(0.5));
+  fetch::math::Tensor<TypeParam, 2> r({3, 19});
+
+  r.Assign(fetch::math::Map([](TypeParam x) { return x * x; }, a - b) * b);
+  for (std::uint64_t i(0); i < 3; ++i)
+    {
+      for (std::uint64_t j(0); j < 19; ++j)
+	{
+	  TypeParam d = a.Get(i, j) - b.Get(i, j);
+	  ASSERT_EQ(r.Get(i, j), d * d * b.Get(i, j));
+	}
+    }
+
+  // Transposed operand
+  fetch::math::Tensor<TypeParam, 2> at = a.Transpose();
+  fetch::math::Tensor<TypeParam, 2> rt({19, 3});
+  rt.Assign(fetch::math::Map([](TypeParam x) { return x + TypeParam(1); }, at));
+  for (std::uint64_t i(0); i < 19; ++i)
+    {
+      for (std::uint64_t j(0); j < 3; ++j)
+	{
+	  ASSERT_EQ(rt.Get(i, j), a.Get(j, i) + TypeParam(1));
+	}
+    }
+}
+
+TYPED_TEST(TensorExpressionTest, drain)
+{
+  fetch::math::Tensor<TypeParam, 2> w = Make<TypeParam>(3, 19, TypeParam(1));
+  fetch::math::Tensor<TypeParam, 2> g = Make<TypeParam>(3, 19, TypeParam(0.5));
+
+  w += fetch::math::Drain(g) * TypeParam(-2);
+  for (std::uint64_t i(0); i < 3; ++i)
+    {
+      for (std::uint64_t j(0); j < 19; ++j)
+	{
+	  ASSERT_EQ(w.Get(i, j), TypeParam(i * 19 + j + 1) - TypeParam(i * 19 + j + 1));
+	  ASSERT_EQ(g.Get(i, j), TypeParam(0));
+	}
+    }
+
+  // Non dense tensor to drain
+  fetch::math::Tensor<TypeParam, 2> b = Make<TypeParam>(4, 3, TypeParam(1));
+  fetch::math::Tensor<TypeParam, 2> bt = b.Transpose();
+  fetch::math::Tensor<TypeParam, 2> r({3, 4});
+  r.Assign(fetch::math::Drain(bt) + TypeParam(1));
+  for (std::uint64_t i(0); i < 3; ++i)
+    {
+      for (std::uint64_t j(0); j < 4; ++j)
+	{
+	  ASSERT_EQ(r.Get(i, j), TypeParam(j * 3 + i + 1) + TypeParam(1));
+	  ASSERT_EQ(b.Get(j, i), TypeParam(0));
+	}
+    }
+}
+
+TYPED_TEST(TensorExpressionTest, drain_guards)
+{
+  fetch::math::Tensor<TypeParam, 2> g = Make<TypeParam>(3, 4, TypeParam(1));
+  fetch::math::Tensor<TypeParam, 2> w = Make<TypeParam>(3, 4, TypeParam(1));
+
+  // Evaluation asserts that the destination is not drained, views of it included
+  fetch::math::Tensor<TypeParam, 2> gt = g.Transpose();
+  EXPECT_TRUE(fetch::math::Drain(g).Drains(g.Storage().get()));
+  EXPECT_TRUE((w + fetch::math::Drain(gt)).Drains(g.Storage().get()));
+  EXPECT_FALSE((w + fetch::math::Drain(g)).Drains(w.Storage().get()));
+
+  // A second Drain in the same expression does not compile
+  using Once  = decltype(w + fetch::math::Drain(g) * TypeParam(2));
+  using Twice = decltype(fetch::math::Drain(g) + -fetch::math::Drain(w));
+  static_assert(fetch::math::expression::DrainCount<Once>::value == 1, "");
+  static_assert(fetch::math::expression::DrainCount<Twice>::value == 2, "");
+}
@@ -30,9 +30,10 @@ TYPED_TEST_CASE(TensorIndexingTest, MyTypes);
 TYPED_TEST(TensorIndexingTest, one_dimentional_tensor_test)
 {
   fetch::math::Tensor<TypeParam, 1> t({5});
+  std::uint64_t const A = t.DefaultAlignment;
 
   ASSERT_EQ(t.Size(), 5);
-  ASSERT_EQ(t.Capacity(), 8);
+  ASSERT_EQ(t.Capacity(), A);
 
   ASSERT_EQ(t.template OffsetForIndices<0>(0), 0);
   ASSERT_EQ(t.template OffsetForIndices<0>(1), 1);
@@ -68,9 +69,10 @@ TYPED_TEST(TensorIndexingTest, one_dimentional_tensor_with_stride_test)
 TYPED_TEST(TensorIndexingTest, two_dimentional_tensor_test)
 {
   fetch::math::Tensor<TypeParam, 2> t({3, 5});
+  std::uint64_t const A = t.DefaultAlignment;  // row size, padding included
 
   ASSERT_EQ(t.Size(), 15);
-  ASSERT_EQ(t.Capacity(), 24);
+  ASSERT_EQ(t.Capacity(), 3 * A);
 
   ASSERT_EQ(t.template OffsetForIndices<0>(0, 0), 0);
   ASSERT_EQ(t.template OffsetForIndices<0>(0, 1), 1);
@@ -78,19 +80,19 @@ TYPED_TEST(TensorIndexingTest, two_dimentional_tensor_test)
   ASSERT_EQ(t.template OffsetForIndices<0>(0, 3), 3);
   ASSERT_EQ(t.template OffsetForIndices<0>(0, 4), 4);
 
-  ASSERT_EQ(t.template OffsetForIndices<0>(1, 0), 8);
-  ASSERT_EQ(t.template OffsetForIndices<0>(1, 1), 9);
-  ASSERT_EQ(t.template OffsetForIndices<0>(1, 2), 10);
-  ASSERT_EQ(t.template OffsetForIndices<0>(1, 3), 11);
-  ASSERT_EQ(t.template OffsetForIndices<0>(1, 4), 12);
+  ASSERT_EQ(t.template OffsetForIndices<0>(1, 0), A + 0);
+  ASSERT_EQ(t.template OffsetForIndices<0>(1, 1), A + 1);
+  ASSERT_EQ(t.template OffsetForIndices<0>(1, 2), A + 2);
+  ASSERT_EQ(t.template OffsetForIndices<0>(1, 3), A + 3);
+  ASSERT_EQ(t.template OffsetForIndices<0>(1, 4), A + 4);
 
-  ASSERT_EQ(t.template OffsetForIndices<0>(2, 0), 16);
-  ASSERT_EQ(t.template OffsetForIndices<0>(2, 1), 17);
-  ASSERT_EQ(t.template OffsetForIndices<0>(2, 2), 18);
-  ASSERT_EQ(t.template OffsetForIndices<0>(2, 3), 19);
-  ASSERT_EQ(t.template OffsetForIndices<0>(2, 4), 20);
+  ASSERT_EQ(t.template OffsetForIndices<0>(2, 0), 2 * A + 0);
+  ASSERT_EQ(t.template OffsetForIndices<0>(2, 1), 2 * A + 1);
+  ASSERT_EQ(t.template OffsetForIndices<0>(2, 2), 2 * A + 2);
+  ASSERT_EQ(t.template OffsetForIndices<0>(2, 3), 2 * A + 3);
+  ASSERT_EQ(t.template OffsetForIndices<0>(2, 4), 2 * A + 4);
 
-  ASSERT_EQ(t.DimensionSize(0), 8);
+  ASSERT_EQ(t.DimensionSize(0), A);
   ASSERT_EQ(t.DimensionSize(1), 1);
   ASSERT_EQ(t.DimensionSize(2), 0);
   ASSERT_EQ(t.DimensionSize(3), 0);
@@ -130,9 +132,10 @@ TYPED_TEST(TensorIndexingTest, two_dimentional_tensor_with_stride_test)
 TYPED_TEST(TensorIndexingTest, three_dimentional_tensor_test)
 {
   fetch::math::Tensor<TypeParam, 3> t({2, 3, 5});
+  std::uint64_t const A = t.DefaultAlignment;  // row size, padding included
 
   ASSERT_EQ(t.Size(), 30);
-  ASSERT_EQ(t.Capacity(), 48);
+  ASSERT_EQ(t.Capacity(), 6 * A);
 
   ASSERT_EQ(t.template OffsetForIndices<0>(0, 0, 0), 0);
   ASSERT_EQ(t.template OffsetForIndices<0>(0, 0, 1), 1);
@@ -140,39 +143,39 @@ TYPED_TEST(TensorIndexingTest, three_dimentional_tensor_test)
   ASSERT_EQ(t.template OffsetForIndices<0>(0, 0, 3), 3);
   ASSERT_EQ(t.template OffsetForIndices<0>(0, 0, 4), 4);
 
-  ASSERT_EQ(t.template OffsetForIndices<0>(0, 1, 0), 8);
-  ASSERT_EQ(t.template OffsetForIndices<0>(0, 1, 1), 9);
-  ASSERT_EQ(t.template OffsetForIndices<0>(0, 1, 2), 10);
-  ASSERT_EQ(t.template OffsetForIndices<0>(0, 1, 3), 11);
-  ASSERT_EQ(t.template OffsetForIndices<0>(0, 1, 4), 12);
-
-  ASSERT_EQ(t.template OffsetForIndices<0>(0, 2, 0), 16);
-  ASSERT_EQ(t.template OffsetForIndices<0>(0, 2, 1), 17);
-  ASSERT_EQ(t.template OffsetForIndices<0>(0, 2, 2), 18);
-  ASSERT_EQ(t.template OffsetForIndices<0>(0, 2, 3), 19);
-  ASSERT_EQ(t.template OffsetForIndices<0>(0, 2, 4), 20);
-
-  ASSERT_EQ(t.template OffsetForIndices<0>(1, 0, 0), 24);
-  ASSERT_EQ(t.template OffsetForIndices<0>(1, 0, 1), 25);
-  ASSERT_EQ(t.template OffsetForIndices<0>(1, 0, 2), 26);
-  ASSERT_EQ(t.template OffsetForIndices<0>(1, 0, 3), 27);
-  ASSERT_EQ(t.template OffsetForIndices<0>(1, 0, 4), 28);
-
-  ASSERT_EQ(t.template OffsetForIndices<0>(1, 1, 0), 32);
-  ASSERT_EQ(t.template OffsetForIndices<0>(1, 1, 1), 33);
-  ASSERT_EQ(t.template OffsetForIndices<0>(1, 1, 2), 34);
-  ASSERT_EQ(t.template OffsetForIndices<0>(1, 1, 3), 35);
-  ASSERT_EQ(t.template OffsetForIndices<0>(1, 1, 4), 36);
-
-  ASSERT_EQ(t.template OffsetForIndices<0>(1, 2, 0), 40);
-  ASSERT_EQ(t.template OffsetForIndices<0>(1, 2, 1), 41);
-  ASSERT_EQ(t.template OffsetForIndices<0>(1, 2, 2), 42);
-  ASSERT_EQ(t.template OffsetForIndices<0>(1, 2, 3), 43);
-  ASSERT_EQ(t.template OffsetForIndices<0>(1, 2, 4), 44);
-
-
-  ASSERT_EQ(t.DimensionSize(0), 24);
-  ASSERT_EQ(t.DimensionSize(1), 8);
+  ASSERT_EQ(t.template OffsetForIndices<0>(0, 1, 0), A + 0);
+  ASSERT_EQ(t.template OffsetForIndices<0>(0, 1, 1), A + 1);
+  ASSERT_EQ(t.template OffsetForIndices<0>(0, 1, 2), A + 2);
+  ASSERT_EQ(t.template OffsetForIndices<0>(0, 1, 3), A + 3);
+  ASSERT_EQ(t.template OffsetForIndices<0>(0, 1, 4), A + 4);
+
+  ASSERT_EQ(t.template OffsetForIndices<0>(0, 2, 0), 2 * A + 0);
+  ASSERT_EQ(t.template OffsetForIndices<0>(0, 2, 1), 2 * A + 1);
+  ASSERT_EQ(t.template OffsetForIndices<0>(0, 2, 2), 2 * A + 2);
+  ASSERT_EQ(t.template OffsetForIndices<0>(0, 2, 3), 2 * A + 3);
+  ASSERT_EQ(t.template OffsetForIndices<0>(0, 2, 4), 2 * A + 4);
+
+  ASSERT_EQ(t.template OffsetForIndices<0>(1, 0, 0), 3 * A + 0);
+  ASSERT_EQ(t.template OffsetForIndices<0>(1, 0, 1), 3 * A + 1);
+  ASSERT_EQ(t.template OffsetForIndices<0>(1, 0, 2), 3 * A + 2);
+  ASSERT_EQ(t.template OffsetForIndices<0>(1, 0, 3), 3 * A + 3);
+  ASSERT_EQ(t.template OffsetForIndices<0>(1, 0, 4), 3 * A + 4);
+
+  ASSERT_EQ(t.template OffsetForIndices<0>(1, 1, 0), 4 * A + 0);
+  ASSERT_EQ(t.template OffsetForIndices<0>(1, 1, 1), 4 * A + 1);
+  ASSERT_EQ(t.template OffsetForIndices<0>(1, 1, 2), 4 * A + 2);
+  ASSERT_EQ(t.template OffsetForIndices<0>(1, 1, 3), 4 * A + 3);
+  ASSERT_EQ(t.template OffsetForIndices<0>(1, 1, 4), 4 * A + 4);
+
+  ASSERT_EQ(t.template OffsetForIndices<0>(1, 2, 0), 5 * A + 0);
+  ASSERT_EQ(t.template OffsetForIndices<0>(1, 2, 1), 5 * A + 1);
+  ASSERT_EQ(t.template OffsetForIndices<0>(1, 2, 2), 5 * A + 2);
+  ASSERT_EQ(t.template OffsetForIndices<0>(1, 2, 3), 5 * A + 3);
+  ASSERT_EQ(t.template OffsetForIndices<0>(1, 2, 4), 5 * A + 4);
+
+
+  ASSERT_EQ(t.DimensionSize(0), 3 * A);
+  ASSERT_EQ(t.DimensionSize(1), A);
   ASSERT_EQ(t.DimensionSize(2), 1);
   ASSERT_EQ(t.DimensionSize(3), 0);
 
@@ -190,9 +193,15 @@ TYPED_TEST(TensorIndexingTest, three_dimentional_tensor_test)
     }
   }
 
-  std::vector<TypeParam> gt({0,  1,  2,  3,  4,  0, 0, 0, 5,  6,  7,  8,  9,  0, 0, 0,
-                             10, 11, 12, 13, 14, 0, 0, 0, 15, 16, 17, 18, 19, 0, 0, 0,
-                             20, 21, 22, 23, 24, 0, 0, 0, 25, 26, 27, 28, 29, 0, 0, 0});
+  // Rows of 5 values, then zeros up to the next row
+  std::vector<TypeParam> gt(6 * A, TypeParam(0));
+  for (std::size_t r(0) ; r < 6 ; ++r)
+    {
+      for (std::size_t k(0) ; k < 5 ; ++k)
+	{
+	  gt[r * A + k] = TypeParam(r * 5 + k);
+	}
+    }
   for (std::size_t i(0) ; i < gt.size() ; ++i)
     {
       ASSERT_EQ((t.Storage().get())[i], gt[i]);
@@ -341,7 +350,7 @@ TYPED_TEST(TensorIndexingTest, three_dimentional_tensor_slicing_test)
 {
   fetch::math::Tensor<TypeParam, 3> t({2, 3, 5});
 
-  ASSERT_EQ(t.DimensionSize(0), 24);
+  ASSERT_EQ(t.DimensionSize(0), 3 * t.DefaultAlignment);
   
   TypeParam v(0);
   for (std::uint64_t i(0); i < 2; ++i)
@@ -561,3 +570,73 @@ TYPED_TEST(TensorIndexingTest, range_based_iteration_4d_with_stride)
 	}
     }
 }
+
+TYPED_TEST(TensorIndexingTest, raw_access)
+{
+  fetch::math::Tensor<TypeParam, 2> t({3, 5});
+  TypeParam i(0);
+  for (TypeParam &e : t)
+  {
+    e = i;
+    i += TypeParam(1);
+  }
+
+  // Rows are padded to whole cache lines
+  ASSERT_TRUE(t.IsDense());
+  ASSERT_FALSE(t.IsContiguous());
+  ASSERT_EQ(t.NbRows(), 3);
+  ASSERT_EQ(t.RowSize(), 5);
+  ASSERT_EQ(t.RowPointer(1) - t.RowPointer(0), t.DefaultAlignment);
+  for (std::uint64_t r(0); r < 3; ++r)
+    {
+      std::uint64_t j(0);
+      for (TypeParam const &e : t.RowSpan(r))
+	{
+	  EXPECT_EQ(e, TypeParam(r * 5 + j++));
+	}
+      EXPECT_EQ(j, 5);
+    }
+
+  // A single row, or rows without padding, form one span
+  fetch::math::Tensor<TypeParam, 1> slice = t.Slice(2);
+  ASSERT_TRUE(slice.IsContiguous());
+  ASSERT_EQ(slice.AsSpan().data(), t.RowPointer(2));
+  ASSERT_EQ(slice.AsSpan().size(), 5);
+  fetch::math::Tensor<TypeParam, 2> packed({4, t.DefaultAlignment});
+  ASSERT_TRUE(packed.IsContiguous());
+  ASSERT_EQ(packed.AsSpan().size(), 4 * t.DefaultAlignment);
+  fetch::math::Tensor<TypeParam, 3> cube({2, 3, 4}, {{1, 1, 1}}, {{0, 0, 0}});
+  ASSERT_TRUE(cube.IsContiguous());
+  ASSERT_EQ(cube.NbRows(), 6);
+  ASSERT_EQ(cube.RowPointer(5) - cube.RowPointer(0), 20);
+
+  // Transposed views are neither
+  fetch::math::Tensor<TypeParam, 2> transposed = t.Transpose();
+  ASSERT_FALSE(transposed.IsDense());
+  ASSERT_FALSE(transposed.IsContiguous());
+  ASSERT_FALSE(transposed.Slice(0).IsDense());
+
+  // Writes through a span are seen by the tensor
+  t.RowSpan(1)[4] = TypeParam(42);
+  ASSERT_EQ(t.Get(1, 4), TypeParam(42));
+}
+
+TYPED_TEST(TensorIndexingTest, aligned_rows)
+{
+  // Every row starts on an ALIGNMENT boundary, whatever the row size
+  for (std::uint64_t cols : {1, 5, 16, 100, 300})
+    {
+      fetch::math::Tensor<TypeParam, 2> t({7, cols});
+      ASSERT_EQ(t.DimensionSize(0) * sizeof(TypeParam) % t.ALIGNMENT, 0);
+      for (std::uint64_t r(0); r < 7; ++r)
+	{
+	  ASSERT_EQ(reinterpret_cast<std::uintptr_t>(t.RowPointer(r)) % t.ALIGNMENT, 0);
+	  for (TypeParam const &e : t.RowSpan(r))
+	    {
+	      ASSERT_EQ(e, TypeParam(0));
+	    }
+	}
+    }
+  fetch::math::Tensor<TypeParam, 1> v({3});
+  ASSERT_EQ(reinterpret_cast<std::uintptr_t>(v.Storage().get()) % v.ALIGNMENT, 0);
+}
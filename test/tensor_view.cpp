@@ -0,0 +1,103 @@
+//------------------------------------------------------------------------------
+//
+//   Copyright 2018-2019 Fetch.AI Limited
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//------------------------------------------------------------------------------
+
+#include "tensor.hpp"
+#include <gtest/gtest.h>
+
+template <typename T>
+class TensorViewTest : public ::testing::Test
+{
+};
+
+using MyTypes = ::testing::Types<float, double>;
+TYPED_TEST_CASE(TensorViewTest, MyTypes);
+
+template <typename T>
+fetch::math::Tensor<T, 2> Iota(std::uint64_t rows, std::uint64_t cols)
+{
+  fetch::math::Tensor<T, 2> t({rows, cols});
+  for (std::uint64_t i(0); i < rows; ++i)
+    {
+      for (std::uint64_t j(0); j < cols; ++j)
+	{
+	  t.Set(i, j, T(i * cols + j));
+	}
+    }
+  return t;
+}
+
+TYPED_TEST(TensorViewTest, slice_view_matches_slice)
+{
+  fetch::math::Tensor<TypeParam, 2> t = Iota<TypeParam>(4, 13);
+  long const use_count = t.Storage().use_count();
+  for (std::uint64_t i(0); i < 4; ++i)
+    {
+      fetch::math::Tensor<TypeParam, 1>    slice = t.Slice(i);
+      fetch::math::TensorView<TypeParam, 1> view = t.SliceView(i);
+      ASSERT_EQ(view.Size(), slice.Size());
+      ASSERT_EQ(view.data(), slice.RowPointer(0));
+      for (std::uint64_t j(0); j < 13; ++j)
+	{
+	  ASSERT_EQ(view.Get(j), slice.Get(j));
+	}
+    }
+  // Views don't share the ownership of the storage
+  fetch::math::TensorView<TypeParam, 1> view = t.SliceView(2);
+  ASSERT_EQ(t.Storage().use_count(), use_count);
+  view.Get(3) = TypeParam(-1);
+  ASSERT_EQ(t.Get(2, 3), TypeParam(-1));
+}
+
+TYPED_TEST(TensorViewTest, element_wise)
+{
+  fetch::math::Tensor<TypeParam, 2> t = Iota<TypeParam>(3, 37);
+  fetch::math::Tensor<TypeParam, 2> u = Iota<TypeParam>(3, 37);
+  t.SliceView(0).Copy(t.SliceView(2));
+  t.SliceView(1).InlineAdd(u.SliceView(2), TypeParam(0.5)).InlineDivide(TypeParam(2));
+  t.SliceView(2).Fill(TypeParam(7)).InlineMultiply(TypeParam(3));
+  for (std::uint64_t j(0); j < 37; ++j)
+    {
+      ASSERT_EQ(t.Get(0, j), u.Get(2, j));
+      ASSERT_EQ(t.Get(1, j), (u.Get(1, j) + u.Get(2, j) * TypeParam(0.5)) / TypeParam(2));
+      ASSERT_EQ(t.Get(2, j), TypeParam(21));
+    }
+}
+
+TYPED_TEST(TensorViewTest, transposed_views)
+{
+  fetch::math::Tensor<TypeParam, 2> t = Iota<TypeParam>(5, 3);
+  fetch::math::Tensor<TypeParam, 2> r({3, 5});
+  fetch::math::TensorView<TypeParam const, 2> transposed = t.View().Transpose();
+  ASSERT_FALSE(transposed.IsDense());
+  for (std::uint64_t i(0); i < 3; ++i)
+    {
+      // Strided source, dense destination, then the other way round
+      r.SliceView(i).Copy(transposed.Slice(i));
+      r.SliceView(i).InlineAdd(transposed.Slice(i));
+    }
+  fetch::math::Tensor<TypeParam, 2> back({5, 3});
+  back.View().Transpose().Copy(r.View());
+  for (std::uint64_t i(0); i < 5; ++i)
+    {
+      for (std::uint64_t j(0); j < 3; ++j)
+	{
+	  ASSERT_EQ(r.Get(j, i), TypeParam(2) * t.Get(i, j));
+	  ASSERT_EQ(back.Get(i, j), TypeParam(2) * t.Get(i, j));
+	}
+    }
+}
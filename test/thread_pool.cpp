@@ -0,0 +1,195 @@
+//------------------------------------------------------------------------------
+//
+//   Copyright 2018-2019 Fetch.AI Limited
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//------------------------------------------------------------------------------
+
+#include "thread_pool.hpp"
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+TEST(ThreadPoolTest, runs_every_index_once)
+{
+  fetch::math::ThreadPool pool(3);
+  ASSERT_EQ(pool.NbThreads(), 4);
+  for (std::size_t n : {0, 1, 2, 7, 1000})
+    {
+      std::vector<std::atomic<int>> counts(n);
+      for (auto &c : counts)
+	{
+	  c = 0;
+	}
+      pool.ParallelFor(n, [&](std::size_t i) { ++counts[i]; });
+      for (auto &c : counts)
+	{
+	  ASSERT_EQ(c, 1);
+	}
+    }
+}
+
+TEST(ThreadPoolTest, uses_the_workers)
+{
+  fetch::math::ThreadPool pool(3);
+  std::mutex mutex;
+  std::set<std::thread::id> ids;
+  std::atomic<int> waiting(0);
+  // Every task waits for the others, so each one must run on its own thread
+  pool.ParallelFor(4, [&](std::size_t) {
+      {
+	std::lock_guard<std::mutex> lock(mutex);
+	ids.insert(std::this_thread::get_id());
+      }
+      ++waiting;
+      while (waiting < 4)
+	{
+	  std::this_thread::yield();
+	}
+    });
+  ASSERT_EQ(ids.size(), 4);
+  ASSERT_TRUE(ids.count(std::this_thread::get_id()));
+}
+
+TEST(ThreadPoolTest, serial_without_workers)
+{
+  fetch::math::ThreadPool pool(0);
+  ASSERT_EQ(pool.NbThreads(), 1);
+  std::vector<std::size_t> order;
+  pool.ParallelFor(5, [&](std::size_t i) { order.push_back(i); });
+  ASSERT_EQ(order, std::vector<std::size_t>({0, 1, 2, 3, 4}));
+}
+
+TEST(ThreadPoolTest, nested_and_concurrent_loops_run_serially)
+{
+  fetch::math::ThreadPool pool(2);
+  std::atomic<int> total(0);
+  pool.ParallelFor(3, [&](std::size_t) {
+      pool.ParallelFor(10, [&](std::size_t) { ++total; });
+    });
+  ASSERT_EQ(total, 30);
+
+  total = 0;
+  std::vector<std::thread> callers;
+  for (int t(0) ; t < 4 ; ++t)
+    {
+      callers.emplace_back([&]() {
+	  for (int r(0) ; r < 100 ; ++r)
+	    {
+	      pool.ParallelFor(8, [&](std::size_t) { ++total; });
+	    }
+	});
+    }
+  for (auto &c : callers)
+    {
+      c.join();
+    }
+  ASSERT_EQ(total, 4 * 100 * 8);
+}
+
+TEST(ThreadPoolTest, nested_loop_on_the_caller_thread)
+{
+  fetch::math::ThreadPool pool(2);
+  std::thread::id caller = std::this_thread::get_id();
+  std::atomic<int> waiting(0), nested_on_caller(0), nested_elsewhere(0);
+  // Every task waits for the others so the caller, which is running the loop, gets one of them
+  pool.ParallelFor(3, [&](std::size_t) {
+      ++waiting;
+      while (waiting < 3)
+	{
+	  std::this_thread::yield();
+	}
+      if (std::this_thread::get_id() == caller)
+	{
+	  pool.ParallelFor(10, [&](std::size_t) {
+	      ++(std::this_thread::get_id() == caller ? nested_on_caller : nested_elsewhere);
+	    });
+	}
+    });
+  ASSERT_EQ(nested_on_caller, 10);
+  ASSERT_EQ(nested_elsewhere, 0);
+
+  // The pool is free again afterwards
+  std::mutex mutex;
+  std::set<std::thread::id> ids;
+  waiting = 0;
+  pool.ParallelFor(3, [&](std::size_t) {
+      {
+	std::lock_guard<std::mutex> lock(mutex);
+	ids.insert(std::this_thread::get_id());
+      }
+      ++waiting;
+      while (waiting < 3)
+	{
+	  std::this_thread::yield();
+	}
+    });
+  ASSERT_EQ(ids.size(), 3);
+}
+
+TEST(ThreadPoolTest, exceptions_reach_the_caller)
+{
+  fetch::math::ThreadPool pool(3);
+  std::thread::id caller = std::this_thread::get_id();
+
+  // Thrown on a worker : every other index still runs
+  std::atomic<int> waiting(0), ran(0);
+  EXPECT_THROW(pool.ParallelFor(4, [&](std::size_t) {
+	++waiting;
+	while (waiting < 4)
+	  {
+	    std::this_thread::yield();
+	  }
+	if (std::this_thread::get_id() != caller)
+	  {
+	    throw std::runtime_error("worker");
+	  }
+	++ran;
+      }), std::runtime_error);
+  ASSERT_EQ(ran, 1);
+
+  // Thrown from a single index of a parallel loop, then from a serial loop
+  ran = 0;
+  EXPECT_THROW(pool.ParallelFor(100, [&](std::size_t i) {
+	if (i == 3)
+	  {
+	    throw std::runtime_error("index 3");
+	  }
+	++ran;
+      }), std::runtime_error);
+  ASSERT_EQ(ran, 99);
+  EXPECT_THROW(pool.ParallelFor(1, [&](std::size_t) { throw std::runtime_error("serial"); }), std::runtime_error);
+
+  // The pool is still free and uses all its threads
+  std::mutex mutex;
+  std::set<std::thread::id> ids;
+  waiting = 0;
+  pool.ParallelFor(4, [&](std::size_t) {
+      {
+	std::lock_guard<std::mutex> lock(mutex);
+	ids.insert(std::this_thread::get_id());
+      }
+      ++waiting;
+      while (waiting < 4)
+	{
+	  std::this_thread::yield();
+	}
+    });
+  ASSERT_EQ(ids.size(), 4);
+}
@@ -0,0 +1,72 @@
+//------------------------------------------------------------------------------
+//
+//   Copyright 2018-2019 Fetch.AI Limited
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//------------------------------------------------------------------------------
+
+#include "touched_rows.hpp"
+#include <gtest/gtest.h>
+#include <set>
+
+TEST(TouchedRowsTest, duplicates_keep_their_slot)
+{
+  fetch::ml::TouchedRows rows;
+  ASSERT_EQ(rows.Insert(42), std::make_pair(uint64_t(0), true));
+  ASSERT_EQ(rows.Insert(7), std::make_pair(uint64_t(1), true));
+  ASSERT_EQ(rows.Insert(42), std::make_pair(uint64_t(0), false));
+  ASSERT_EQ(rows.Size(), 2);
+  ASSERT_EQ(rows.Rows(), std::vector<uint64_t>({42, 7}));
+  ASSERT_EQ(rows.Find(7), 1);
+  ASSERT_EQ(rows.Find(8), rows.Size());
+}
+
+TEST(TouchedRowsTest, clear_forgets_everything)
+{
+  fetch::ml::TouchedRows rows;
+  for (uint64_t i(0) ; i < 10 ; ++i)
+    {
+      rows.Insert(i * 3);
+    }
+  rows.Clear();
+  ASSERT_TRUE(rows.Empty());
+  ASSERT_EQ(rows.Find(3), 0);
+  ASSERT_EQ(rows.Insert(3), std::make_pair(uint64_t(0), true));
+}
+
+TEST(TouchedRowsTest, same_as_std_set_past_initial_capacity)
+{
+  fetch::ml::TouchedRows rows(4);
+  std::set<uint64_t> reference;
+  uint64_t x(12345);
+  for (int step(0) ; step < 20 ; ++step)
+    {
+      for (int i(0) ; i < 500 ; ++i)
+	{
+	  x = x * 6364136223846793005ull + 1442695040888963407ull;
+	  uint64_t row = (x >> 33) % 3000;
+	  bool inserted = reference.insert(row).second;
+	  ASSERT_EQ(rows.Insert(row).second, inserted);
+	}
+      ASSERT_EQ(rows.Size(), reference.size());
+      std::vector<uint64_t> sorted;
+      for (uint64_t slot : rows.SortedSlots())
+	{
+	  sorted.push_back(rows.Rows()[slot]);
+	}
+      ASSERT_EQ(sorted, std::vector<uint64_t>(reference.begin(), reference.end()));
+      rows.Clear();
+      reference.clear();
+    }
+}
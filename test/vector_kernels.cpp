@@ -0,0 +1,167 @@
+//------------------------------------------------------------------------------
+//
+//   Copyright 2018-2019 Fetch.AI Limited
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//------------------------------------------------------------------------------
+
+#include "tensor.hpp"
+#include "vector_kernels.hpp"
+#include <gtest/gtest.h>
+#include <random>
+
+using fetch::math::kernels::InstructionSet;
+
+template <typename T>
+class VectorKernelsTest : public ::testing::Test
+{
+};
+
+using MyTypes = ::testing::Types<float, double>;
+TYPED_TEST_CASE(VectorKernelsTest, MyTypes);
+
+template <typename T>
+std::vector<T> RandomValues(std::size_t n, unsigned int seed)
+{
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<T> distribution(T(-10), T(10));
+  std::vector<T> values(n);
+  for (T &v : values)
+    {
+      v = distribution(rng);
+    }
+  return values;
+}
+
+// Every supported instruction set gives exactly the results of the scalar loops, tails included
+TYPED_TEST(VectorKernelsTest, same_as_scalar)
+{
+  using Scalar = fetch::math::kernels::Scalar<TypeParam>;
+  for (InstructionSet isa : {InstructionSet::SSE2, InstructionSet::AVX2, InstructionSet::AVX512})
+    {
+      if (!fetch::math::kernels::Supports(isa))
+	{
+	  continue;
+	}
+      fetch::math::kernels::KernelTable<TypeParam> kernels = fetch::math::kernels::Kernels<TypeParam>(isa);
+      for (std::size_t n : {0, 1, 3, 7, 8, 15, 16, 17, 33, 100, 1001})
+	{
+	  std::vector<TypeParam> a = RandomValues<TypeParam>(n, 1);
+	  std::vector<TypeParam> b = RandomValues<TypeParam>(n, 2);
+	  std::vector<TypeParam> expected(a), result(a);
+
+	  Scalar::Add(expected.data(), b.data(), TypeParam(0.37), n);
+	  kernels.add(result.data(), b.data(), TypeParam(0.37), n);
+	  ASSERT_EQ(result, expected);
+	  Scalar::Subtract(expected.data(), b.data(), n);
+	  kernels.subtract(result.data(), b.data(), n);
+	  ASSERT_EQ(result, expected);
+	  Scalar::Multiply(expected.data(), b.data(), n);
+	  kernels.multiply(result.data(), b.data(), n);
+	  ASSERT_EQ(result, expected);
+	  Scalar::Divide(expected.data(), b.data(), n);
+	  kernels.divide(result.data(), b.data(), n);
+	  ASSERT_EQ(result, expected);
+	  Scalar::AddScalar(expected.data(), TypeParam(1.1), n);
+	  kernels.add_scalar(result.data(), TypeParam(1.1), n);
+	  ASSERT_EQ(result, expected);
+	  Scalar::SubtractScalar(expected.data(), TypeParam(2.3), n);
+	  kernels.subtract_scalar(result.data(), TypeParam(2.3), n);
+	  ASSERT_EQ(result, expected);
+	  Scalar::MultiplyScalar(expected.data(), TypeParam(-0.7), n);
+	  kernels.multiply_scalar(result.data(), TypeParam(-0.7), n);
+	  ASSERT_EQ(result, expected);
+	  Scalar::DivideScalar(expected.data(), TypeParam(3.1), n);
+	  kernels.divide_scalar(result.data(), TypeParam(3.1), n);
+	  ASSERT_EQ(result, expected);
+
+	  // Partial sums per lane change the rounding
+	  TypeParam sum = Scalar::Sum(a.data(), n);
+	  ASSERT_NEAR(kernels.sum(a.data(), n), sum, std::abs(sum) * 1e-5 + 1e-4);
+	}
+    }
+}
+
+// The tensor fast path gives the same results as element by element operations, on full tensors,
+// padded rows and slices. Transposed views go through the iterators
+TYPED_TEST(VectorKernelsTest, tensor_operations)
+{
+  using ArrayType = fetch::math::Tensor<TypeParam, 2>;
+  ArrayType a({5, 13});
+  ArrayType b({5, 13});
+  std::vector<TypeParam> va = RandomValues<TypeParam>(65, 3);
+  std::vector<TypeParam> vb = RandomValues<TypeParam>(65, 4);
+  for (std::uint64_t i(0) ; i < 5 ; ++i)
+    {
+      for (std::uint64_t j(0) ; j < 13 ; ++j)
+	{
+	  a.Set(i, j, va[i * 13 + j]);
+	  b.Set(i, j, vb[i * 13 + j]);
+	}
+    }
+
+  ArrayType result = a.Clone();
+  result.InlineAdd(b, TypeParam(0.5)).InlineMultiply(b).InlineSubtract(TypeParam(1)).InlineDivide(TypeParam(3));
+  for (std::uint64_t i(0) ; i < 5 ; ++i)
+    {
+      for (std::uint64_t j(0) ; j < 13 ; ++j)
+	{
+	  TypeParam e = va[i * 13 + j];
+	  e += (vb[i * 13 + j] * TypeParam(0.5));
+	  e *= vb[i * 13 + j];
+	  e -= TypeParam(1);
+	  e /= TypeParam(3);
+	  ASSERT_EQ(result.Get(i, j), e);
+	}
+    }
+
+  // The padding at the end of the rows is never touched
+  ASSERT_EQ(a.Padding()[1], 3);
+  result.Fill(TypeParam(2));
+  ASSERT_EQ(result.Sum(), TypeParam(2 * 65));
+  ASSERT_EQ(result.Storage().get()[13], TypeParam(0));
+
+  // Rank 1 slices
+  result.Slice(2).Copy(a.Slice(4));
+  result.Slice(2).InlineSubtract(b.Slice(1));
+  for (std::uint64_t j(0) ; j < 13 ; ++j)
+    {
+      TypeParam e = va[4 * 13 + j];
+      e -= vb[1 * 13 + j];
+      ASSERT_EQ(result.Get(2, j), e);
+      ASSERT_EQ(result.Get(1, j), TypeParam(2));
+    }
+
+  // Transposed views
+  ArrayType t = a.Transpose().Clone();
+  t.InlineAdd(b.Transpose());
+  ArrayType bt = b.Transpose();
+  ArrayType c = a.Clone();
+  c.Transpose().InlineDivide(bt);
+  for (std::uint64_t i(0) ; i < 5 ; ++i)
+    {
+      for (std::uint64_t j(0) ; j < 13 ; ++j)
+	{
+	  ASSERT_EQ(t.Get(j, i), va[i * 13 + j] + vb[i * 13 + j]);
+	  ASSERT_EQ(c.Get(i, j), va[i * 13 + j] / vb[i * 13 + j]);
+	}
+    }
+  TypeParam sum(0);
+  for (TypeParam v : va)
+    {
+      sum += v;
+    }
+  ASSERT_NEAR(a.Transpose().Sum(), sum, 1e-3);
+  ASSERT_NEAR(a.Sum(), sum, 1e-3);
+}
@@ -0,0 +1,232 @@
+//------------------------------------------------------------------------------
+//
+//   Copyright 2018-2019 Fetch.AI Limited
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//------------------------------------------------------------------------------
+
+#include "w2v_cbow_dataloader.hpp"
+#include <gtest/gtest.h>
+
+using LoaderType = fetch::ml::CBOWLoader<float>;
+
+TEST(cbow_dataloader_test, size)
+{
+  LoaderType loader(2, 3);
+  EXPECT_TRUE(loader.AddData("a b c d e f g h"));
+  EXPECT_TRUE(loader.AddData("i j k l m"));
+  EXPECT_FALSE(loader.AddData("too short"));
+  EXPECT_EQ(loader.Size(), 4 + 1);
+  EXPECT_EQ(loader.VocabSize(), 13);
+}
+
+TEST(cbow_dataloader_test, set_offset)
+{
+  LoaderType loader(2, 3);
+  loader.AddData("a b c d e f g h");
+  loader.AddData("i j k l m");
+  loader.InitUnigramTable();
+
+  // Walking the whole dataset gives the reference first context word for each offset
+  // (the target itself depends on the random window size)
+  std::vector<float> first_words;
+  auto sample = loader.GetNext();
+  loader.Reset();
+  while (!loader.IsDone())
+    {
+      loader.GetNext(sample);
+      first_words.push_back(sample.first.Get(0, 0));
+    }
+  ASSERT_EQ(first_words.size(), loader.Size());
+
+  for (uint64_t offset(0) ; offset < loader.Size() ; ++offset)
+    {
+      loader.SetOffset(offset);
+      ASSERT_FALSE(loader.IsDone());
+      uint64_t remaining(0);
+      while (!loader.IsDone())
+	{
+	  loader.GetNext(sample);
+	  EXPECT_EQ(sample.first.Get(0, 0), first_words[offset + remaining]);
+	  remaining++;
+	}
+      EXPECT_EQ(remaining, loader.Size() - offset);
+    }
+}
+
+TEST(cbow_dataloader_test, copies_have_their_own_cursor)
+{
+  LoaderType loader(1, 2);
+  loader.AddData("a b c d e f g h");
+  loader.InitUnigramTable();
+
+  LoaderType copy(loader);
+  copy.SetOffset(3);
+  auto sample = loader.GetNext();
+  auto copy_sample = copy.GetNext();
+  EXPECT_EQ(sample.first.Get(0, 0), 0.0f);
+  EXPECT_EQ(copy_sample.first.Get(0, 0), 3.0f);
+}
+
+TEST(cbow_dataloader_test, copies_share_the_vocabulary)
+{
+  LoaderType loader(1, 2);
+  loader.AddData("a b a c a d a");
+  loader.InitUnigramTable();
+
+  LoaderType copy(loader);
+  EXPECT_EQ(&copy.GetVocab(), &loader.GetVocab());
+
+  // Rebuilding it leaves the copies with the one they were made with, like the corpus
+  loader.RemoveInfrequent(2);
+  EXPECT_EQ(loader.VocabSize(), 1);
+  EXPECT_EQ(copy.VocabSize(), 4);
+}
+
+TEST(cbow_dataloader_test, batch_wraps_around)
+{
+  LoaderType loader(1, 2);
+  loader.AddData("a b c d e");
+  loader.InitUnigramTable();
+
+  // 3 samples in the corpus, the 5 rows of the batch go around it
+  auto batch = loader.GetNextBatch(5);
+  ASSERT_EQ(batch.first.shape()[0], 5);
+  ASSERT_EQ(batch.second.shape()[0], 5);
+  std::vector<float> first_words({0, 1, 2, 0, 1});
+  std::vector<float> targets({1, 2, 3, 1, 2});
+  for (uint64_t b(0) ; b < 5 ; ++b)
+    {
+      EXPECT_EQ(batch.first.Get(b, 0), first_words[b]);
+      EXPECT_EQ(batch.first.Get(b, 1), first_words[b] + 2);
+      EXPECT_EQ(batch.second.Get(b, 0), targets[b]);
+    }
+}
+
+TEST(cbow_dataloader_test, shared_negatives)
+{
+  LoaderType loader(1, 2);
+  loader.AddData("a b c d e f g h");
+  loader.InitUnigramTable();
+
+  // 3 contexts, their 3 targets then 4 negatives shared by all of them
+  std::pair<fetch::math::Tensor<float, 2>, fetch::math::Tensor<float, 2>> batch(
+    fetch::math::Tensor<float, 2>({3, 2}), fetch::math::Tensor<float, 2>({1, 7}));
+  loader.GetNextSharedNegatives(batch);
+  for (uint64_t b(0) ; b < 3 ; ++b)
+    {
+      EXPECT_EQ(batch.first.Get(b, 0), float(b));
+      EXPECT_EQ(batch.second.Get(0, b), float(b + 1));
+    }
+  for (uint64_t i(3) ; i < 7 ; ++i)
+    {
+      EXPECT_GE(batch.second.Get(0, i), 0.0f);
+      EXPECT_LT(batch.second.Get(0, i), 8.0f);
+    }
+}
+
+TEST(cbow_dataloader_test, subsampling)
+{
+  // "the" is half of the corpus, every other word appears once
+  std::string text;
+  for (char c('a') ; c <= 'z' ; ++c)
+    {
+      text += std::string("the ") + c + c + " ";
+    }
+  LoaderType loader(1, 2);
+  loader.AddData(text);
+  loader.InitUnigramTable();
+  uint64_t the_index = loader.GetVocab().at("the").first;
+  loader.SetSubsampling(1e-2);
+
+  uint64_t nb_samples(0), nb_the(0), nb_words(0);
+  uint64_t position(loader.Position());
+  EXPECT_EQ(position, 0);
+  auto sample = loader.GetNext();
+  loader.Reset();
+  while (!loader.IsDone())
+    {
+      loader.GetNext(sample);
+      EXPECT_GT(loader.Position(), position);
+      position = loader.Position();
+      for (uint64_t i(0) ; i < 2 ; ++i)
+	{
+	  nb_the += (sample.first.Get(0, i) == float(the_index));
+	  nb_words++;
+	}
+      nb_samples++;
+    }
+
+  // Rare words are always kept and most occurences of "the" are dropped, but the whole dataset was still walked
+  EXPECT_EQ(loader.Position(), loader.Size());
+  EXPECT_LT(nb_samples, loader.Size());
+  EXPECT_GE(nb_samples, 26 - 2);
+  EXPECT_LT(nb_the * 4, nb_words);
+
+  // Disabling it gives back the whole corpus
+  loader.SetSubsampling(0);
+  nb_samples = 0;
+  while (!loader.IsDone())
+    {
+      loader.GetNext(sample);
+      EXPECT_EQ(loader.Position(), ++nb_samples);
+    }
+  EXPECT_EQ(nb_samples, loader.Size());
+}
+
+// Exposes the subsampled words under the cursor
+struct SubsampledLoader : public LoaderType
+{
+  using LoaderType::LoaderType;
+  using LoaderType::CurrentSentence;
+};
+
+TEST(cbow_dataloader_test, subsampling_one_line_corpus)
+{
+  // A single line, like text8, several segments long : "the" every other word, 676 rare words
+  uint64_t nb_words(3 * LoaderType::SUBSAMPLING_SEGMENT_SIZE + 123);
+  std::string text;
+  for (uint64_t i(0) ; i < nb_words / 2 ; ++i)
+    {
+      text += std::string("the ") + char('a' + i % 26) + char('a' + (i / 26) % 26) + " ";
+    }
+  SubsampledLoader loader(2, 2);
+  ASSERT_TRUE(loader.AddData(text));
+  loader.InitUnigramTable();
+  loader.SetSubsampling(1e-3);
+
+  // Only the segment under the cursor is filtered and buffered, never the whole corpus
+  uint64_t position(loader.Position()), nb_samples(0);
+  auto sample = loader.GetNext();
+  loader.Reset();
+  while (!loader.IsDone())
+    {
+      EXPECT_LE(loader.CurrentSentence().size(), LoaderType::SUBSAMPLING_SEGMENT_SIZE);
+      loader.GetNext(sample);
+      EXPECT_GT(loader.Position(), position);
+      position = loader.Position();
+      nb_samples++;
+    }
+  EXPECT_EQ(loader.Position(), loader.Size());
+  EXPECT_GT(nb_samples, nb_words / 2 - 8 * 4);
+  EXPECT_LT(nb_samples, loader.Size());
+
+  // Offsets land in the right segment
+  for (uint64_t offset : {uint64_t(0), LoaderType::SUBSAMPLING_SEGMENT_SIZE + 17, 2 * LoaderType::SUBSAMPLING_SEGMENT_SIZE + 5000})
+    {
+      loader.SetOffset(offset);
+      EXPECT_LE(loader.Position(), offset);
+      EXPECT_GT(loader.Position() + 100, offset);
+    }
+}
@@ -0,0 +1,65 @@
+//------------------------------------------------------------------------------
+//
+//   Copyright 2018-2019 Fetch.AI Limited
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//------------------------------------------------------------------------------
+
+#include "w2v_skipgram_dataloader.hpp"
+#include <gtest/gtest.h>
+
+using LoaderType = fetch::ml::SkipGramLoader<float>;
+
+TEST(skipgram_dataloader_test, samples)
+{
+  LoaderType loader(2, 3);
+  loader.AddData("a b c d e f g h");
+  loader.InitUnigramTable();
+  EXPECT_EQ(loader.Size(), 4);
+
+  auto sample = loader.GetNext();
+  std::array<std::uint64_t, 2> expected_center_shape({1, 1});
+  std::array<std::uint64_t, 2> expected_labels_shape({4, 3});
+  EXPECT_EQ(sample.first.shape(), expected_center_shape);
+  EXPECT_EQ(sample.second.shape(), expected_labels_shape);
+
+  loader.Reset();
+  std::uint64_t center(2);
+  while (!loader.IsDone())
+    {
+      loader.GetNext(sample);
+      EXPECT_EQ(sample.first.Get(0, 0), float(center));
+
+      // Context words are on both side of the center word, and never further than the window size
+      std::uint64_t nb_context(0);
+      for (std::uint64_t row(0) ; row < 4 ; ++row)
+	{
+	  float context = sample.second.Get(row, 0);
+	  if (context < 0)
+	    {
+	      continue;
+	    }
+	  nb_context++;
+	  EXPECT_NE(context, float(center));
+	  EXPECT_LE(std::abs(context - float(center)), 2.0f);
+	  for (std::uint64_t k(1) ; k < 3 ; ++k)
+	    {
+	      EXPECT_NE(sample.second.Get(row, k), context);
+	    }
+	}
+      EXPECT_TRUE(nb_context == 2 || nb_context == 4);
+      center++;
+    }
+  EXPECT_EQ(center, 6);
+}
@@ -60,6 +60,13 @@ TYPED_TEST(WeightsTest, gradient_step_test)
     {
       EXPECT_FLOAT_EQ(output.Get(0, i), TypeParam(gtInput[i]));
     }    
+
+  // The step consumed the gradient, stepping again changes nothing
+  w.Step(TypeParam(1));
+  for (std::uint64_t i(0); i < 8; ++i)
+    {
+      EXPECT_FLOAT_EQ(output.Get(0, i), TypeParam(gtInput[i]));
+    }
 }
 
 TYPED_TEST(WeightsTest, stateDict)